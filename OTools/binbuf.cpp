@@ -1,3 +1,4 @@
+#include "WinInclude.h"
 #include "binbuf.h"
 #include "memory.h"
 #include "outils.h"
@@ -129,3 +130,83 @@ void BinaryBuffer::Align(unsigned int alignment) {
     for (unsigned int i = 0; i < numBytes; i++)
         Put<unsigned char>(0);
 }
+
+void BinaryReader::Close() {
+    if (mData)
+        UnmapViewOfFile(mData);
+    if (mMapping)
+        CloseHandle(mMapping);
+    if (mFile)
+        CloseHandle(mFile);
+    mFile = nullptr;
+    mMapping = nullptr;
+    mData = nullptr;
+    mSize = 0;
+}
+
+BinaryReader::~BinaryReader() {
+    Close();
+}
+
+bool BinaryReader::Open(std::filesystem::path const &filepath) {
+    Close();
+    mOffset = 0;
+    mFailed = false;
+    HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    mFile = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || unsigned long long(fileSize.QuadPart) > SIZE_MAX) {
+        Close();
+        return false;
+    }
+    // an empty file can't be mapped
+    if (fileSize.QuadPart == 0)
+        return true;
+    mMapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mMapping)
+        mData = (char const *)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mData) {
+        Close();
+        return false;
+    }
+    mSize = size_t(fileSize.QuadPart);
+    return true;
+}
+
+bool BinaryReader::Failed() const {
+    return mFailed;
+}
+
+bool BinaryReader::AtEnd() const {
+    return mOffset == mSize;
+}
+
+void BinaryReader::Get(void *dst, size_t size) {
+    if (mFailed || mSize - mOffset < size) {
+        mFailed = true;
+        Memory_Zero(dst, size);
+        return;
+    }
+    Memory_Copy(dst, mData + mOffset, size);
+    mOffset += size;
+}
+
+std::string BinaryReader::GetString() {
+    char const *start = mData + mOffset;
+    size_t length = (mFailed || mOffset == mSize) ? 0 : strnlen(start, mSize - mOffset);
+    if (mFailed || mOffset + length == mSize) {
+        mFailed = true;
+        return std::string();
+    }
+    mOffset += length + 1;
+    return std::string(start, length);
+}
+
+unsigned int BinaryReader::GetCount() {
+    unsigned int count = Get<unsigned int>();
+    if (count > mSize - mOffset)
+        mFailed = true;
+    return mFailed ? 0 : count;
+}
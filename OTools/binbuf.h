@@ -2,6 +2,7 @@
 #include <cstring>
 #include <string>
 #include <filesystem>
+#include <vector>
 
 class BinaryBuffer {
     static const unsigned int DEFAULT_START_CAPACITY = 4096;
@@ -36,3 +37,35 @@ public:
         PutData((void *)&value, sizeof(T));
     }
 };
+
+// reads values from a memory-mapped file, values are copied out of the mapped view; any read past the end marks the reader
+// as failed
+class BinaryReader {
+    void *mFile = nullptr;
+    void *mMapping = nullptr;
+    char const *mData = nullptr;
+    size_t mSize = 0;
+    size_t mOffset = 0;
+    bool mFailed = false;
+
+    void Close();
+public:
+    BinaryReader() = default;
+    BinaryReader(BinaryReader const &) = delete;
+    BinaryReader &operator=(BinaryReader const &) = delete;
+    ~BinaryReader();
+    bool Open(std::filesystem::path const &filepath);
+    bool Failed() const;
+    bool AtEnd() const;
+    void Get(void *dst, size_t size);
+    std::string GetString();
+    // element count, limited by the remaining data so a corrupted count can't trigger a huge allocation
+    unsigned int GetCount();
+
+    template<typename T>
+    T Get() {
+        T value;
+        Get(&value, sizeof(T));
+        return value;
+    }
+};
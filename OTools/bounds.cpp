@@ -0,0 +1,91 @@
+#include "bounds.h"
+#include "memory.h"
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// min/max per component without branches, so the loop vectorizes; count must not be 0
+void MinMax(unsigned char const *data, unsigned int stride, unsigned int count, aiVector3D &pointsMin, aiVector3D &pointsMax) {
+    float lo[3], hi[3];
+    Memory_Copy(lo, data, 12);
+    Memory_Copy(hi, data, 12);
+    for (unsigned int i = 1; i < count; i++) {
+        float p[3];
+        Memory_Copy(p, data + size_t(i) * stride, 12);
+        for (unsigned int c = 0; c < 3; c++) {
+            lo[c] = std::min(lo[c], p[c]);
+            hi[c] = std::max(hi[c], p[c]);
+        }
+    }
+    pointsMin = aiVector3D(lo[0], lo[1], lo[2]);
+    pointsMax = aiVector3D(hi[0], hi[1], hi[2]);
+}
+
+}
+
+void Bounds::AddBox(unsigned char const *data, unsigned int stride, unsigned int count) {
+    if (!count)
+        return;
+    aiVector3D pointsMin, pointsMax;
+    MinMax(data, stride, count, pointsMin, pointsMax);
+    AddPoint(pointsMin);
+    AddPoint(pointsMax);
+}
+
+void Bounds::AddPoints(unsigned char const *data, unsigned int stride, unsigned int count) {
+    if (!count)
+        return;
+    aiVector3D pointsMin, pointsMax;
+    MinMax(data, stride, count, pointsMin, pointsMax);
+    AddPoints(data, stride, count, pointsMin, pointsMax);
+}
+
+void Bounds::AddPoints(unsigned char const *data, unsigned int stride, unsigned int count, aiVector3D const &pointsMin, aiVector3D const &pointsMax) {
+    if (!count)
+        return;
+    Bounds points;
+    points.min = pointsMin;
+    points.max = pointsMax;
+    points.empty = false;
+    points.FitSphere(data, stride, count);
+    Merge(points);
+}
+
+void Bounds::FitSphere(unsigned char const *data, unsigned int stride, unsigned int count) {
+    aiVector3D center = Center();
+    float maxDistanceSq = 0.0f;
+    for (unsigned int i = 0; i < count; i++) {
+        float p[3];
+        Memory_Copy(p, data + size_t(i) * stride, 12);
+        float dx = p[0] - center.x, dy = p[1] - center.y, dz = p[2] - center.z;
+        maxDistanceSq = std::max(maxDistanceSq, dx * dx + dy * dy + dz * dz);
+    }
+    radius = std::min(sqrtf(maxDistanceSq), HalfDiagonal());
+}
+
+void Bounds::Merge(Bounds const &other) {
+    if (other.empty)
+        return;
+    if (empty) {
+        *this = other;
+        return;
+    }
+    aiVector3D oldCenter = Center();
+    float oldRadius = radius;
+    min = aiVector3D(std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z));
+    max = aiVector3D(std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z));
+    aiVector3D center = Center();
+    float r = std::max((oldCenter - center).Length() + oldRadius, (other.Center() - center).Length() + other.radius);
+    radius = std::min(r, HalfDiagonal());
+}
+
+void Bounds::Scale(float scale) {
+    aiVector3D center = Center();
+    aiVector3D up = (max - center) * scale;
+    aiVector3D low = (min - center) * scale;
+    max = center + up;
+    min = center + low;
+    radius *= fabs(scale);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <assimp/types.h>
+#include <algorithm>
+
+// Axis-aligned box with a bounding sphere centred in it. The sphere radius never exceeds the half diagonal of the box and is
+// tightened from the points (FitSphere) or from the spheres of the merged parts, so primitive > layer > model bounds get
+// tighter spheres than the box alone gives.
+struct Bounds {
+    aiVector3D min = { 0.0f, 0.0f, 0.0f };
+    aiVector3D max = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+    bool empty = true;
+
+    // box only, call FitSphere or use HalfDiagonal() for the sphere
+    void AddPoint(aiVector3D const &p) {
+        if (empty) {
+            min = p;
+            max = p;
+            empty = false;
+        }
+        else {
+            min = aiVector3D(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+            max = aiVector3D(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+        }
+        radius = HalfDiagonal();
+    }
+
+    // strided float3 positions; box only, like AddPoint (for accessor and collision min/max)
+    void AddBox(unsigned char const *data, unsigned int stride, unsigned int count);
+    // strided float3 positions; box and sphere
+    void AddPoints(unsigned char const *data, unsigned int stride, unsigned int count);
+    // same, when the box of the points is already known (from the encoder loop)
+    void AddPoints(unsigned char const *data, unsigned int stride, unsigned int count, aiVector3D const &pointsMin, aiVector3D const &pointsMax);
+    // radius from the points, which must be inside the box
+    void FitSphere(unsigned char const *data, unsigned int stride, unsigned int count);
+    void Merge(Bounds const &other);
+    // -bboxScale: the box and the sphere are scaled around the center
+    void Scale(float scale);
+
+    aiVector3D Center() const {
+        return (min + max) * 0.5f;
+    }
+
+    float HalfDiagonal() const {
+        return (max - min).Length() * 0.5f;
+    }
+};
@@ -1,6 +1,6 @@
 #include "main.h"
 #include <stdio.h>
-#include <fstream>
+#include <array>
 
 namespace dump {
 
@@ -12,83 +12,299 @@ struct Symbol : public Elf32_Sym {
     string name;
 };
 
+// Output is streamed to the file through a fixed-size buffer, so memory use doesn't grow with the dump size.
+// In JSON mode every top-level object becomes one line: {"type", "name", "offset", "count", "fields", "size", "references"}.
+// Fields are { "name", "value" } or { "line" } items; nested scopes are { "scope", "fields" } items.
 class Writer {
+    static FILE *mFile;
+    static string mBuffer;
+    static bool mJson;
+    static bool mNeedComma;
+    static void writeSpacing();
+    static void endLine(string_view comment);
+    static void flushIfFull();
+    static void beginItem();
+    static void writeString(string_view str);
+    static void writeComment(string_view comment);
 public:
+    struct Reference {
+        unsigned int offset = 0;
+        unsigned int target = 0;
+        char const *symbol = nullptr; // for external references
+    };
+
     static unsigned int mSpacing;
-    static string mResult;
-    static void openScope(string const &title, unsigned int offset, string const &comment = string());
+    static bool open(path const &filePath, bool json);
+    static void close();
+    static bool isJson();
+    static void writeFileHeader(string_view filename, unsigned int dataSize);
+    static void beginObject(string_view type, string_view name, unsigned int offset, unsigned int count);
+    static void endObject(unsigned int size, vector<Reference> const &references);
+    static void openScope(string_view title, unsigned int offset, string_view comment = string_view());
     static void closeScope();
-    static string spacing();
-    static void writeLine(string const &line, string const &comment = string());
-    static void writeField(string const &name, string const &value, string const &comment = string());
+    static void writeLine(string_view line, string_view comment = string_view());
+    static void writeField(string_view name, string_view value, string_view comment = string_view());
 };
 
-string Writer::mResult;
+FILE *Writer::mFile = nullptr;
+string Writer::mBuffer;
+bool Writer::mJson = false;
+bool Writer::mNeedComma = false;
 unsigned int Writer::mSpacing = 0;
 const unsigned int SPACING = 4;
+const unsigned int WRITER_BUFFER_SIZE = 64 * 1024;
 map<unsigned int, Symbol> symbolRelocations;
 void *currentData = nullptr;
 
-void Writer::openScope(string const &title, unsigned int offset, string const &comment) {
-    mResult += spacing() + title;
-    if (mSpacing == 0)
-        mResult += " @" + Format("%X", offset);
-    mResult += " {";
-    if (!comment.empty())
-        mResult += " // " + comment;
-    mResult += "\n";
-    mSpacing += SPACING;
+bool Writer::open(path const &filePath, bool json) {
+    close();
+    mFile = _wfopen(filePath.c_str(), json ? L"wb" : L"w");
+    if (!mFile)
+        return false;
+    mBuffer.clear();
+    mBuffer.reserve(WRITER_BUFFER_SIZE + 4096);
+    mJson = json;
+    mNeedComma = false;
+    mSpacing = 0;
+    return true;
+}
+
+void Writer::close() {
+    if (mFile) {
+        if (!mBuffer.empty())
+            fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+        fclose(mFile);
+        mFile = nullptr;
+    }
+    mBuffer.clear();
 }
 
-void Writer::closeScope() {
-    mSpacing -= SPACING;
-    mResult += spacing() + "}\n";
+bool Writer::isJson() {
+    return mJson;
+}
+
+void Writer::flushIfFull() {
+    if (mBuffer.size() >= WRITER_BUFFER_SIZE) {
+        if (mFile)
+            fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+        mBuffer.clear();
+    }
+}
+
+void Writer::writeSpacing() {
+    mBuffer.append(mSpacing, ' ');
 }
 
-string Writer::spacing() {
-    if (mSpacing > 0)
-        return string(mSpacing, L' ');
-    return string();
+void Writer::endLine(string_view comment) {
+    if (!comment.empty()) {
+        mBuffer += " // ";
+        mBuffer += comment;
+    }
+    mBuffer += '\n';
+    flushIfFull();
 }
 
-void Writer::writeLine(string const &line, string const &comment) {
-    mResult += spacing() + line;
-    if (!comment.empty())
-        mResult += " // " + comment;
-    mResult += "\n";
+void Writer::beginItem() {
+    if (mNeedComma)
+        mBuffer += ',';
+    mNeedComma = true;
 }
 
-void Writer::writeField(string const &name, string const &value, string const &comment) {
-    mResult += spacing() + name + ": " + value;
-    if (!comment.empty())
-        mResult += " // " + comment;
-    mResult += "\n";
+void Writer::writeString(string_view str) {
+    static char const hex[] = "0123456789abcdef";
+    mBuffer += '"';
+    for (char c : str) {
+        unsigned char uc = (unsigned char)c;
+        if (c == '"' || c == '\\') {
+            mBuffer += '\\';
+            mBuffer += c;
+        }
+        else if (uc < 0x20 || uc >= 0x7F) {
+            // names in .o files aren't guaranteed to be UTF-8, so non-ASCII bytes are written as Latin-1 code points
+            mBuffer += "\\u00";
+            mBuffer += hex[uc >> 4];
+            mBuffer += hex[uc & 0xF];
+        }
+        else
+            mBuffer += c;
+    }
+    mBuffer += '"';
 }
 
+void Writer::writeComment(string_view comment) {
+    if (!comment.empty()) {
+        mBuffer += ",\"comment\":";
+        writeString(comment);
+    }
+}
+
+void Writer::writeFileHeader(string_view filename, unsigned int dataSize) {
+    if (mJson) {
+        mBuffer += "{\"file\":";
+        writeString(filename);
+        mBuffer += ",\"dataSize\":";
+        mBuffer += to_string(dataSize);
+        mBuffer += "}\n";
+    }
+    else {
+        mBuffer += "// ";
+        mBuffer += filename;
+        endLine(string_view());
+    }
+}
+
+void Writer::beginObject(string_view type, string_view name, unsigned int offset, unsigned int count) {
+    if (!mJson)
+        return;
+    mBuffer += "{\"type\":";
+    writeString(type);
+    mBuffer += ",\"name\":";
+    writeString(name);
+    mBuffer += ",\"offset\":";
+    mBuffer += to_string(offset);
+    if (count > 0) {
+        mBuffer += ",\"count\":";
+        mBuffer += to_string(count);
+    }
+    mBuffer += ",\"fields\":[";
+    mNeedComma = false;
+}
+
+void Writer::endObject(unsigned int size, vector<Reference> const &references) {
+    if (!mJson)
+        return;
+    mBuffer += "],\"size\":";
+    mBuffer += to_string(size);
+    mBuffer += ",\"references\":[";
+    for (unsigned int i = 0; i < references.size(); i++) {
+        if (i != 0)
+            mBuffer += ',';
+        mBuffer += "{\"offset\":";
+        mBuffer += to_string(references[i].offset);
+        if (references[i].symbol) {
+            mBuffer += ",\"symbol\":";
+            writeString(references[i].symbol);
+        }
+        else {
+            mBuffer += ",\"target\":";
+            mBuffer += to_string(references[i].target);
+        }
+        mBuffer += '}';
+    }
+    mBuffer += "]}\n";
+    mNeedComma = false;
+    flushIfFull();
+}
+
+void Writer::openScope(string_view title, unsigned int offset, string_view comment) {
+    if (mJson) {
+        // the top-level scope is the object record itself
+        if (mSpacing != 0) {
+            beginItem();
+            mBuffer += "{\"scope\":";
+            writeString(title);
+            writeComment(comment);
+            mBuffer += ",\"fields\":[";
+            mNeedComma = false;
+        }
+        mSpacing += SPACING;
+        return;
+    }
+    writeSpacing();
+    mBuffer += title;
+    if (mSpacing == 0) {
+        mBuffer += " @";
+        mBuffer += Format("%X", offset);
+    }
+    mBuffer += " {";
+    endLine(comment);
+    mSpacing += SPACING;
+}
+
+void Writer::closeScope() {
+    mSpacing -= SPACING;
+    if (mJson) {
+        if (mSpacing != 0) {
+            mBuffer += "]}";
+            mNeedComma = true;
+        }
+        return;
+    }
+    writeSpacing();
+    mBuffer += '}';
+    endLine(string_view());
+}
+
+void Writer::writeLine(string_view line, string_view comment) {
+    if (mJson) {
+        beginItem();
+        mBuffer += "{\"line\":";
+        writeString(line);
+        writeComment(comment);
+        mBuffer += '}';
+        return;
+    }
+    writeSpacing();
+    mBuffer += line;
+    endLine(comment);
+}
+
+void Writer::writeField(string_view name, string_view value, string_view comment) {
+    if (mJson) {
+        beginItem();
+        mBuffer += "{\"name\":";
+        writeString(name);
+        mBuffer += ",\"value\":";
+        writeString(value);
+        writeComment(comment);
+        mBuffer += '}';
+        return;
+    }
+    writeSpacing();
+    mBuffer += name;
+    mBuffer += ": ";
+    mBuffer += value;
+    endLine(comment);
+}
+
+enum class StructType : unsigned char {
+    Int8, UInt8, Int16, UInt16, Int32, UInt32, Bool32, Float, Offset, NameOffset, Name, NameAligned, Vector3, Vector4,
+    Coordinate4, Matrix4x4, BBOX, Bone, Model, RenderMethod, ModelTexture, ModelTexture_OldFormat, ModifiableData,
+    GeoPrimState, ComputationIndex, IrradLight, Light, ModelLayer, ModelLayers, ModelLayerStates, ModelLayersStates,
+    ModelLayerBounding, RenderDescriptorListEntry, AnimationBank, Animation, Skeleton, Morph, BoneState, BlendTarget,
+    BlendShape, BlendShapeVertexAttribute, EAGLMicroCode, VSDecl, GeoPrimDataBuffer, RenderCode, Command,
+    RenderDescriptor, CommandObjectParameter, GeometryInfo, VertexBuffer, IndexBuffer, Texture, BoneWeightsBuffer,
+    InterleavedVertices, InterleavedVerticesData, InterleavedVerticesVertexData, EffectTechnique, EffectPass,
+    StateAssignment,
+    Count
+};
+
 struct Struct {
+    char const *mName;
     unsigned int(*mWriter)(void *, string const &, unsigned char *, unsigned int);
     unsigned int(*mArrayWriter)(void *, string const &, unsigned char *, unsigned int, unsigned int);
 
-    Struct() {
+    constexpr Struct() {
+        mName = nullptr;
         mWriter = nullptr;
         mArrayWriter = nullptr;
     }
 
-    Struct(unsigned int(*writer)(void *, string const &, unsigned char *, unsigned int)) {
+    constexpr Struct(char const *name, unsigned int(*writer)(void *, string const &, unsigned char *, unsigned int)) {
+        mName = name;
         mWriter = writer;
         mArrayWriter = nullptr;
     }
 
-    Struct(unsigned int(*writer)(void *, string const &, unsigned char *, unsigned int), unsigned int(*arrayWriter)(void *, string const &, unsigned char *, unsigned int, unsigned int)) {
+    constexpr Struct(char const *name, unsigned int(*writer)(void *, string const &, unsigned char *, unsigned int), unsigned int(*arrayWriter)(void *, string const &, unsigned char *, unsigned int, unsigned int)) {
+        mName = name;
         mWriter = writer;
         mArrayWriter = arrayWriter;
     }
 };
 
-map<string, Struct> &GetStructs() {
-    static map<string, Struct> structs;
-    return structs;
-}
+// defined after all writers, see STRUCTS below
+Struct const &GetStruct(StructType type);
 
 unsigned int WriteInt8(void *, string const &name, unsigned char *data, unsigned int offset) {
     Writer::writeField(name, Format("%d", GetAt<char>(data, offset)));
@@ -297,31 +513,27 @@ unsigned int WriteVector4(void *, string const &name, unsigned char *data, unsig
     return 16;
 }
 
-unsigned int WriteObject(void *baseObj, string const &type, string const &name, unsigned char *data, unsigned int offset, unsigned int count = 0) {
+unsigned int WriteObject(void *baseObj, StructType type, string const &name, unsigned char *data, unsigned int offset, unsigned int count = 0) {
+    auto const &struc = GetStruct(type);
     if (count > 0)
-        Writer::openScope(Format("Array[%d] of ", count) + type, offset); // TODO: write references
+        Writer::openScope(Format("Array[%d] of ", count) + struc.mName, offset); // TODO: write references
     unsigned int bytesWritten = 0;
-    auto struc = GetStructs()[ToLower(type)];
     if (count > 0) {
         if (struc.mArrayWriter)
             bytesWritten = struc.mArrayWriter(baseObj, name, data, offset, count);
         else {
-            if (struc.mWriter) {
-                for (unsigned int i = 0; i < count; i++)
-                    bytesWritten += struc.mWriter(baseObj, name + Format("[%d]", i), data, offset + bytesWritten);
-            }
+            for (unsigned int i = 0; i < count; i++)
+                bytesWritten += struc.mWriter(baseObj, name + Format("[%d]", i), data, offset + bytesWritten);
         }
     }
-    else {
-        if (struc.mWriter)
-            bytesWritten = struc.mWriter(baseObj, name, data, offset);
-    }
+    else
+        bytesWritten = struc.mWriter(baseObj, name, data, offset);
     if (count > 0)
         Writer::closeScope();
     return bytesWritten; // TODO: show error message
 }
 
-unsigned int WriteObjectWithFields(void *baseObj, string const &type, string const &name, unsigned char *data, unsigned int offset, vector<pair<string, string>> const &fields, unsigned int count = 0) {
+unsigned int WriteObjectWithFields(void *baseObj, string const &type, string const &name, unsigned char *data, unsigned int offset, std::initializer_list<std::pair<StructType, char const *>> fields, unsigned int count = 0) {
     Writer::openScope(type + " " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
     for (auto const &f : fields) {
@@ -355,50 +567,50 @@ unsigned int WriteEnum16Bit(string const &name, unsigned char *data, unsigned in
 unsigned int WriteMatrix4x4(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "Matrix4x4", name, data, offset,
         {
-            { "VECTOR4", "vec1" },
-        { "VECTOR4", "vec2" },
-        { "VECTOR4", "vec3" },
-        { "VECTOR4", "posn" }
+            { StructType::Vector4, "vec1" },
+        { StructType::Vector4, "vec2" },
+        { StructType::Vector4, "vec3" },
+        { StructType::Vector4, "posn" }
         });
 }
 
 unsigned int WriteBBOX(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "BBOX", name, data, offset,
         {
-         { "VECTOR3", "Min" },
-        { "VECTOR3", "Max" }
+         { StructType::Vector3, "Min" },
+        { StructType::Vector3, "Max" }
         });
 }
 
 unsigned int WriteModel(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "Model", name, data, offset,
         {
-            { "OFFSET", "ModifiableDataDescriptors" },
-        { "UINT32", "NumModifiableDataDescriptors" },
-        { "UINT32", "NumVariations" },
-        { "MATRIX4X4", "TransformationMatrix" },
-        { "VECTOR4", "unknown1" },
-        { "VECTOR4", "unknown2" },
-        { "VECTOR4", "BoundingMin" },
-        { "VECTOR4", "BoundingMax" },
-        { "VECTOR4", "Center" },
-        { "UINT32", "NumModelLayers" },
-        { "OFFSET", "ModelLayersNames" },
-        { "UINT32", "unknown3" },
-        { "OFFSET", "unknown4" },
-        { "OFFSET", "unknown5" },
-        { "OFFSET", "NextModel" },
-        { "NAMEOFFSET", "ModelName" },
-        { "OFFSET", "InterleavedVertices" },
-        { "OFFSET", "Textures" },
-        { "UINT32", "VariationID" },
-        { "OFFSET", "ModelLayersStates" },
-        { "BOOL32", "IsModelRenderable" },
-        { "OFFSET", "ModelLayers" },
-        { "UINT32", "unknown6" },
-        { "UINT32", "unknown7" },
-        { "UINT32", "SkeletonVersion" },
-        { "UINT32", "LastFrame" }
+            { StructType::Offset, "ModifiableDataDescriptors" },
+        { StructType::UInt32, "NumModifiableDataDescriptors" },
+        { StructType::UInt32, "NumVariations" },
+        { StructType::Matrix4x4, "TransformationMatrix" },
+        { StructType::Vector4, "unknown1" },
+        { StructType::Vector4, "unknown2" },
+        { StructType::Vector4, "BoundingMin" },
+        { StructType::Vector4, "BoundingMax" },
+        { StructType::Vector4, "Center" },
+        { StructType::UInt32, "NumModelLayers" },
+        { StructType::Offset, "ModelLayersNames" },
+        { StructType::UInt32, "unknown3" },
+        { StructType::Offset, "unknown4" },
+        { StructType::Offset, "unknown5" },
+        { StructType::Offset, "NextModel" },
+        { StructType::NameOffset, "ModelName" },
+        { StructType::Offset, "InterleavedVertices" },
+        { StructType::Offset, "Textures" },
+        { StructType::UInt32, "VariationID" },
+        { StructType::Offset, "ModelLayersStates" },
+        { StructType::Bool32, "IsModelRenderable" },
+        { StructType::Offset, "ModelLayers" },
+        { StructType::UInt32, "unknown6" },
+        { StructType::UInt32, "unknown7" },
+        { StructType::UInt32, "SkeletonVersion" },
+        { StructType::UInt32, "LastFrame" }
         });
 }
 
@@ -406,35 +618,35 @@ unsigned int WriteRenderMethod(void *baseObj, string const &name, unsigned char
     if (globalVars().target->Version() <= 2) {
         return WriteObjectWithFields(baseObj, "RenderMethod", name, data, offset,
             {
-                { "OFFSET", "CodeBlock" },
-                { "OFFSET", "UsedCodeBlock" },
-                { "OFFSET", "MicroCode" },
-                { "OFFSET", "Effect" },
-                { "OFFSET", "Parent" },
-                { "OFFSET", "ParameterNames" },
-                { "INT32", "unknown2" },
-                { "INT32", "unknown3" },
-                { "OFFSET", "unknown4" },
-                { "OFFSET", "GeometryDataBuffer" },
-                { "INT32", "ComputationIndexCommand" }
+                { StructType::Offset, "CodeBlock" },
+                { StructType::Offset, "UsedCodeBlock" },
+                { StructType::Offset, "MicroCode" },
+                { StructType::Offset, "Effect" },
+                { StructType::Offset, "Parent" },
+                { StructType::Offset, "ParameterNames" },
+                { StructType::Int32, "unknown2" },
+                { StructType::Int32, "unknown3" },
+                { StructType::Offset, "unknown4" },
+                { StructType::Offset, "GeometryDataBuffer" },
+                { StructType::Int32, "ComputationIndexCommand" }
             });
     }
     else {
         return WriteObjectWithFields(baseObj, "RenderMethod", name, data, offset,
             {
-                { "OFFSET", "CodeBlock" },
-                { "OFFSET", "UsedCodeBlock" },
-                { "OFFSET", "MicroCode" },
-                { "OFFSET", "Effect" },
-                { "OFFSET", "Parent" },
-                { "OFFSET", "ParameterNames" },
-                { "INT32", "unknown2" },
-                { "INT32", "unknown3" },
-                { "OFFSET", "unknown4" },
-                { "OFFSET", "GeometryDataBuffer" },
-                { "INT32", "ComputationIndexCommand" },
-                { "NAMEOFFSET", "Name" },
-                { "OFFSET", "EAGLModel" }
+                { StructType::Offset, "CodeBlock" },
+                { StructType::Offset, "UsedCodeBlock" },
+                { StructType::Offset, "MicroCode" },
+                { StructType::Offset, "Effect" },
+                { StructType::Offset, "Parent" },
+                { StructType::Offset, "ParameterNames" },
+                { StructType::Int32, "unknown2" },
+                { StructType::Int32, "unknown3" },
+                { StructType::Offset, "unknown4" },
+                { StructType::Offset, "GeometryDataBuffer" },
+                { StructType::Int32, "ComputationIndexCommand" },
+                { StructType::NameOffset, "Name" },
+                { StructType::Offset, "EAGLModel" }
             });
     }
 }
@@ -442,15 +654,15 @@ unsigned int WriteRenderMethod(void *baseObj, string const &name, unsigned char
 unsigned int WriteModelTexture(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     Writer::openScope("ModelTexture " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
-    char const *texName = GetAt<char const *>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "NAMEOFFSET", "Name", data, offset, 0);
-    if (texName) {
+    unsigned int texNameOffset = GetAt<unsigned int>(data, offset + bytesWritten);
+    bytesWritten += WriteObject(baseObj, StructType::NameOffset, "Name", data, offset, 0);
+    if (texNameOffset) {
         unsigned int tarCount = GetAt<unsigned int>(data, offset + bytesWritten);
-        bytesWritten += WriteObject(baseObj, "UINT32", "TARCount", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "TARCount", data, offset + bytesWritten, 0);
         if (tarCount > 0)
-            bytesWritten += WriteObject(baseObj, "OFFSET", "Texture", data, offset + bytesWritten, tarCount);
-        bytesWritten += WriteObject(baseObj, "UINT16", "unknown2", data, offset + bytesWritten, 0);
-        bytesWritten += WriteObject(baseObj, "UINT16", "unknown3", data, offset + bytesWritten, 0);
+            bytesWritten += WriteObject(baseObj, StructType::Offset, "Texture", data, offset + bytesWritten, tarCount);
+        bytesWritten += WriteObject(baseObj, StructType::UInt16, "unknown2", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt16, "unknown3", data, offset + bytesWritten, 0);
     }
     Writer::closeScope();
     return bytesWritten;
@@ -459,13 +671,13 @@ unsigned int WriteModelTexture(void *baseObj, string const &name, unsigned char
 unsigned int WriteModelTexture_OldFormat(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     Writer::openScope("ModelTexture_OldFormat " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
-    char const *texName = GetAt<char const *>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "NAMEOFFSET", "Name", data, offset, 0);
-    if (texName) {
+    unsigned int texNameOffset = GetAt<unsigned int>(data, offset + bytesWritten);
+    bytesWritten += WriteObject(baseObj, StructType::NameOffset, "Name", data, offset, 0);
+    if (texNameOffset) {
         unsigned int tarCount = GetAt<unsigned int>(data, offset + bytesWritten);
-        bytesWritten += WriteObject(baseObj, "UINT32", "TARCount", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "TARCount", data, offset + bytesWritten, 0);
         if (tarCount > 0)
-            bytesWritten += WriteObject(baseObj, "OFFSET", "Texture", data, offset + bytesWritten, tarCount);
+            bytesWritten += WriteObject(baseObj, StructType::Offset, "Texture", data, offset + bytesWritten, tarCount);
     }
     Writer::closeScope();
     return bytesWritten;
@@ -474,95 +686,95 @@ unsigned int WriteModelTexture_OldFormat(void *baseObj, string const &name, unsi
 unsigned int WriteBone(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "Bone", name, data, offset,
         {
-            { "UINT32", "Index" },
-            { "UINT32", "unknown1" },
-            { "UINT32", "unknown2" },
-            { "UINT32", "unknown3" },
+            { StructType::UInt32, "Index" },
+            { StructType::UInt32, "unknown1" },
+            { StructType::UInt32, "unknown2" },
+            { StructType::UInt32, "unknown3" },
         });
 }
 
 unsigned int WriteModifiableData(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "ModifiableData", name, data, offset,
         {
-            { "NAMEOFFSET", "Name" },
-            { "UINT16", "EntrySize" },
-            { "UINT16", "unknown1" },
-            { "UINT32", "EntriesCount" },
-            { "OFFSET", "Entries" }
+            { StructType::NameOffset, "Name" },
+            { StructType::UInt16, "EntrySize" },
+            { StructType::UInt16, "unknown1" },
+            { StructType::UInt32, "EntriesCount" },
+            { StructType::Offset, "Entries" }
         });
 }
 
 unsigned int WriteModelLayerBounding(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "ModelLayerBounding", name, data, offset,
         {
-            { "VECTOR4", "Min" },
-            { "VECTOR4", "Max" },
-            { "VECTOR4", "Center" }
+            { StructType::Vector4, "Min" },
+            { StructType::Vector4, "Max" },
+            { StructType::Vector4, "Center" }
         });
 }
 
 unsigned int WriteGeoPrimState(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "GeoPrimState", name, data, offset,
         {
-            { "UINT32", "PrimitiveType" },
-            { "UINT32", "Shading" },
-            { "BOOL32", "CullingEnabled" },
-            { "UINT32", "CullDirection" },
-            { "UINT32", "DepthTestMethod" },
-            { "UINT32", "AlphaBlendMode" },
-            { "BOOL32", "AlphaTestEnable" },
-            { "UINT32", "AlphaCompareValue" },
-            { "UINT32", "AlphaTestMethod" },
-            { "BOOL32", "TextureEnabled" },
-            { "UINT32", "TransparencyMethod" },
-            { "UINT32", "FillMode" },
-            { "UINT32", "BlendOperation" },
-            { "UINT32", "SourceBlend" },
-            { "UINT32", "DestinationBlend" },
-            { "FLOAT", "NumberOfPatchSegments" },
-            { "INT32", "ZWritingEnabled" }
+            { StructType::UInt32, "PrimitiveType" },
+            { StructType::UInt32, "Shading" },
+            { StructType::Bool32, "CullingEnabled" },
+            { StructType::UInt32, "CullDirection" },
+            { StructType::UInt32, "DepthTestMethod" },
+            { StructType::UInt32, "AlphaBlendMode" },
+            { StructType::Bool32, "AlphaTestEnable" },
+            { StructType::UInt32, "AlphaCompareValue" },
+            { StructType::UInt32, "AlphaTestMethod" },
+            { StructType::Bool32, "TextureEnabled" },
+            { StructType::UInt32, "TransparencyMethod" },
+            { StructType::UInt32, "FillMode" },
+            { StructType::UInt32, "BlendOperation" },
+            { StructType::UInt32, "SourceBlend" },
+            { StructType::UInt32, "DestinationBlend" },
+            { StructType::Float, "NumberOfPatchSegments" },
+            { StructType::Int32, "ZWritingEnabled" }
         });
 }
 
 unsigned int WriteComputationIndex(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "ComputationIndex", name, data, offset,
         {
-            { "UINT16", "ActiveTechnique" },
-            { "UINT16", "unknown1" },
+            { StructType::UInt16, "ActiveTechnique" },
+            { StructType::UInt16, "unknown1" },
         });
 }
 
 unsigned int WriteIrradLight(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "IrradLight", name, data, offset,
         {
-            { "VECTOR4", "unknown1" },
-            { "VECTOR4", "unknown2" },
-            { "VECTOR4", "unknown3" },
-            { "VECTOR4", "unknown4" },
-            { "VECTOR4", "unknown5" },
-            { "VECTOR4", "unknown6" },
-            { "VECTOR4", "unknown7" },
-            { "VECTOR4", "unknown8" },
-            { "VECTOR4", "unknown9" },
-            { "VECTOR4", "unknown10" }
+            { StructType::Vector4, "unknown1" },
+            { StructType::Vector4, "unknown2" },
+            { StructType::Vector4, "unknown3" },
+            { StructType::Vector4, "unknown4" },
+            { StructType::Vector4, "unknown5" },
+            { StructType::Vector4, "unknown6" },
+            { StructType::Vector4, "unknown7" },
+            { StructType::Vector4, "unknown8" },
+            { StructType::Vector4, "unknown9" },
+            { StructType::Vector4, "unknown10" }
         });
 }
 
 unsigned int WriteLight(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "Light", name, data, offset,
         {
-            { "MATRIX4X4", "unknown1" },
-            { "VECTOR4", "unknown2" },
-            { "VECTOR4", "unknown3" },
-            { "VECTOR4", "unknown4" }
+            { StructType::Matrix4x4, "unknown1" },
+            { StructType::Vector4, "unknown2" },
+            { StructType::Vector4, "unknown3" },
+            { StructType::Vector4, "unknown4" }
         });
 }
 
 unsigned int WriteModelLayerStates(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "ModelLayerStates", name, data, offset,
         {
-            { "UINT16", "unknown1" },
-            { "UINT16", "Visibility" }
+            { StructType::UInt16, "unknown1" },
+            { StructType::UInt16, "Visibility" }
         });
 }
 
@@ -571,24 +783,24 @@ unsigned int WriteAnimationBank(void *baseObj, string const &name, unsigned char
     if (bankSize == 0x18) {
         return WriteObjectWithFields(baseObj, "AnimationBank", name, data, offset,
             {
-                { "UINT32", "Size" },
-                { "UINT32", "NumAnimations" },
-                { "UINT32", "unknown1" },
-                { "OFFSET", "Animations" },
-                { "OFFSET", "AnimationNames" },
-                { "UINT32", "Stat" },
+                { StructType::UInt32, "Size" },
+                { StructType::UInt32, "NumAnimations" },
+                { StructType::UInt32, "unknown1" },
+                { StructType::Offset, "Animations" },
+                { StructType::Offset, "AnimationNames" },
+                { StructType::UInt32, "Stat" },
             });
     }
     else {
         return WriteObjectWithFields(baseObj, "AnimationBank", name, data, offset,
             {
-                { "UINT32", "Size" },
-                { "UINT32", "NumAnimations" },
-                { "UINT32", "unknown1" },
-                { "UINT32", "unknown2" },
-                { "OFFSET", "Animations" },
-                { "OFFSET", "AnimationNames" },
-                { "UINT32", "Stat" },
+                { StructType::UInt32, "Size" },
+                { StructType::UInt32, "NumAnimations" },
+                { StructType::UInt32, "unknown1" },
+                { StructType::UInt32, "unknown2" },
+                { StructType::Offset, "Animations" },
+                { StructType::Offset, "AnimationNames" },
+                { StructType::UInt32, "Stat" },
             });
     }
 }
@@ -626,25 +838,25 @@ unsigned int WriteAnimation(void *baseObj, string const &name, unsigned char *da
         { 24, "ANIM_CSISEVENT" },
         { 25, "ANIM_POSEANIM" }
     });
-    bytesWritten += WriteObject(baseObj, "UINT16", "CheckSum", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt16, "CheckSum", data, offset + bytesWritten, 0);
     unsigned short animType = GetAt<unsigned short>(data, offset);
     if (animType == 15) { // ANIM_COMPOUND
-        bytesWritten += WriteObject(baseObj, "OFFSET", "AttributeBlock", data, offset + bytesWritten, 0);
-        bytesWritten += WriteObject(baseObj, "UINT16", "NumChannels", data, offset + bytesWritten, 0);
-        bytesWritten += WriteObject(baseObj, "UINT16", "NumFrames", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::Offset, "AttributeBlock", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt16, "NumChannels", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt16, "NumFrames", data, offset + bytesWritten, 0);
         unsigned short numChannels = GetAt<unsigned short>(data, offset + 0x8);
         if (numChannels)
-            bytesWritten += WriteObject(baseObj, "OFFSET", "ChannelOffset", data, offset + bytesWritten, numChannels);
+            bytesWritten += WriteObject(baseObj, StructType::Offset, "ChannelOffset", data, offset + bytesWritten, numChannels);
     }
     else if (animType == 10 || animType == 11) { // ANIM_DELTAQUAT, ANIM_DELTALERP
-        bytesWritten += WriteObject(baseObj, "OFFSET", "DeltaCompressedData", data, offset + bytesWritten, 0);
-        bytesWritten += WriteObject(baseObj, "UINT16", "NumFrames", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::Offset, "DeltaCompressedData", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt16, "NumFrames", data, offset + bytesWritten, 0);
         unsigned short deltaCompressedDataOffset = GetAt<unsigned short>(data, offset + 0x4);
         if (deltaCompressedDataOffset != 0) {
             unsigned short numDofs = GetAt<unsigned short>(data, deltaCompressedDataOffset);
             unsigned short numDofIndices = (animType == 11) ? (numDofs / 4) : numDofs;
             if (numDofIndices)
-                bytesWritten += WriteObject(baseObj, "UINT16", "DofIndex", data, offset + bytesWritten, numDofIndices);
+                bytesWritten += WriteObject(baseObj, StructType::UInt16, "DofIndex", data, offset + bytesWritten, numDofIndices);
         }
     }
     Writer::closeScope();
@@ -654,11 +866,11 @@ unsigned int WriteAnimation(void *baseObj, string const &name, unsigned char *da
 unsigned int WriteBoneState(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "BoneState", name, data, offset,
         {
-            { "VECTOR3", "Scale" },
-            { "INT32", "ParentBoneID" },
-            { "VECTOR4", "RotationQuat" },
-            { "VECTOR4", "Translation" },
-            { "MATRIX4X4", "Transform" }
+            { StructType::Vector3, "Scale" },
+            { StructType::Int32, "ParentBoneID" },
+            { StructType::Vector4, "RotationQuat" },
+            { StructType::Vector4, "Translation" },
+            { StructType::Matrix4x4, "Transform" }
         });
 }
 
@@ -666,10 +878,10 @@ unsigned int WriteBlendTarget(void *baseObj, string const &name, unsigned char *
     Writer::openScope("BlendTarget " + name, offset);
     unsigned int bytesWritten = 0;
     unsigned int numBlendShapes = GetAt<unsigned int>(data, offset + 0x4);
-    bytesWritten += WriteObject(baseObj, "NAMEOFFSET", "InterleavedVerticesName", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumBlendShapes", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::NameOffset, "InterleavedVerticesName", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumBlendShapes", data, offset + bytesWritten, 0);
     if (numBlendShapes)
-        bytesWritten += WriteObject(baseObj, "BlendShape", Format("BlendShape.%X", offset + bytesWritten), data, offset + bytesWritten, numBlendShapes);
+        bytesWritten += WriteObject(baseObj, StructType::BlendShape, Format("BlendShape.%X", offset + bytesWritten), data, offset + bytesWritten, numBlendShapes);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -678,10 +890,10 @@ unsigned int WriteBlendShape(void *baseObj, string const &name, unsigned char *d
     Writer::openScope("BlendShape " + name, offset);
     unsigned int bytesWritten = 0;
     unsigned int numVertexTargets = GetAt<unsigned int>(data, offset + 0x4);
-    bytesWritten += WriteObject(baseObj, "UINT32", "BlendWeightIndex", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumVertexAttributes", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "BlendWeightIndex", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumVertexAttributes", data, offset + bytesWritten, 0);
     if (numVertexTargets)
-        bytesWritten += WriteObject(baseObj, "BlendShapeVertexAttribute", Format("BlendShapeVertexAttribute.%X", offset + bytesWritten), data, offset + bytesWritten, numVertexTargets);
+        bytesWritten += WriteObject(baseObj, StructType::BlendShapeVertexAttribute, Format("BlendShapeVertexAttribute.%X", offset + bytesWritten), data, offset + bytesWritten, numVertexTargets);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -704,9 +916,9 @@ unsigned int WriteBlendShapeVertexAttribute(void *baseObj, string const &name, u
     Writer::writeField("ComponentType", Format("%u (%s)", componentType, componentTypeName.c_str()));
     Writer::writeField("NumComponents", Format("%u", numComponents));
     bytesWritten += 4;
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumVertices", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "InterleavedVBOffset", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "InterleavedVBIndex", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumVertices", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "InterleavedVBOffset", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "InterleavedVBIndex", data, offset + bytesWritten, 0);
     Writer::openScope("BlendData [" + Format("%u", blendDataSize) + "]", offset + bytesWritten);
     string ary;
     for (unsigned int i = 0; i < min(blendDataSize, 100u); i++) {
@@ -726,36 +938,36 @@ unsigned int WriteBlendShapeVertexAttribute(void *baseObj, string const &name, u
 unsigned int WriteCommandObjectParameter(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "CommandObjectParameter", name, data, offset,
         {
-            { "UINT32", "Count" },
-            { "OFFSET", "Data" }
+            { StructType::UInt32, "Count" },
+            { StructType::Offset, "Data" }
         });
 }
 
 unsigned int WriteTexture(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "Texture", name, data, offset,
         {
-             { "UINT32", "unknown1" },
-             { "UINT32", "Tag" },
-             { "UINT32", "unknown2" },
-             { "FLOAT",  "unknown3" },
-             { "UINT32", "unknown4" },
-             { "FLOAT",  "unknown5" },
-             { "UINT32", "unknown6" },
-             { "UINT32", "WrapU" },
-             { "UINT32", "WrapV" },
-             { "UINT32", "WrapW" },
-             { "UINT32", "unknown7" },
-             { "UINT32", "unknown8" }
+             { StructType::UInt32, "unknown1" },
+             { StructType::UInt32, "Tag" },
+             { StructType::UInt32, "unknown2" },
+             { StructType::Float, "unknown3" },
+             { StructType::UInt32, "unknown4" },
+             { StructType::Float, "unknown5" },
+             { StructType::UInt32, "unknown6" },
+             { StructType::UInt32, "WrapU" },
+             { StructType::UInt32, "WrapV" },
+             { StructType::UInt32, "WrapW" },
+             { StructType::UInt32, "unknown7" },
+             { StructType::UInt32, "unknown8" }
         });
 }
 
 unsigned int WriteGeometryInfo(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "GeometryInfo", name, data, offset,
         {
-            { "UINT32", "NumIndices" },
-            { "UINT32", "NumVertices" },
-            { "UINT32", "NumPrimitives" },
-            { "BOOL32", "unknown1" }
+            { StructType::UInt32, "NumIndices" },
+            { StructType::UInt32, "NumVertices" },
+            { StructType::UInt32, "NumPrimitives" },
+            { StructType::Bool32, "unknown1" }
         });
 }
 
@@ -763,13 +975,13 @@ unsigned int WriteSkeleton(void *baseObj, string const &name, unsigned char *dat
     Writer::openScope("Skeleton " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
     unsigned int numBones = GetAt<unsigned int>(baseObj, 0x8);
-    bytesWritten += WriteObject(baseObj, "UINT16", "Signature1", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT16", "unknown1", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "Signature2", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumBones", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "OFFSET", "unknown2", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt16, "Signature1", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt16, "unknown1", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "Signature2", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumBones", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::Offset, "unknown2", data, offset + bytesWritten, 0);
     if (numBones)
-        bytesWritten += WriteObject(baseObj, "BoneState", Format("BoneState.%X", offset + bytesWritten), data, offset + bytesWritten, numBones);
+        bytesWritten += WriteObject(baseObj, StructType::BoneState, Format("BoneState.%X", offset + bytesWritten), data, offset + bytesWritten, numBones);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -778,13 +990,13 @@ unsigned int WriteMorph(void *baseObj, string const &name, unsigned char *data,
     Writer::openScope("Morph " + name, offset);
     unsigned int bytesWritten = 0;
     unsigned int unknown3 = GetAt<unsigned int>(baseObj, 0x10);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumBlendWeights", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "OFFSET", "BlendWeightsNames", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "OFFSET", "BlendWeightsValues", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "unknown1", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumBlendTargets", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumBlendWeights", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::Offset, "BlendWeightsNames", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::Offset, "BlendWeightsValues", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "unknown1", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumBlendTargets", data, offset + bytesWritten, 0);
     if (unknown3)
-        bytesWritten += WriteObject(baseObj, "BlendTarget", Format("BlendTarget.%X", offset + bytesWritten), data, offset + bytesWritten, unknown3);
+        bytesWritten += WriteObject(baseObj, StructType::BlendTarget, Format("BlendTarget.%X", offset + bytesWritten), data, offset + bytesWritten, unknown3);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -793,9 +1005,9 @@ unsigned int WriteModelLayersStates(void *baseObj, string const &name, unsigned
     Writer::openScope("ModelLayersStates " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
     unsigned int numLayers = GetAt<unsigned int>(baseObj, 0x9C);
-    bytesWritten += WriteObject(baseObj, "INT32", "unknown1", data, offset, 0);
+    bytesWritten += WriteObject(baseObj, StructType::Int32, "unknown1", data, offset, 0);
     if (numLayers > 0)
-        bytesWritten += WriteObject(baseObj, "ModelLayerStates", Format("ModelLayerStates.%X", offset + bytesWritten), data, offset + bytesWritten, numLayers);
+        bytesWritten += WriteObject(baseObj, StructType::ModelLayerStates, Format("ModelLayerStates.%X", offset + bytesWritten), data, offset + bytesWritten, numLayers);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -803,9 +1015,9 @@ unsigned int WriteModelLayersStates(void *baseObj, string const &name, unsigned
 unsigned int WriteModelLayer(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     Writer::openScope("ModelLayer " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumRenderDescriptors", data, offset, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumRenderDescriptors", data, offset, 0);
     unsigned int numRenderDescriptors = GetAt<unsigned int>(data, offset);
-    bytesWritten += WriteObject(baseObj, "OFFSET", Format("RenderDescriptor.%X", offset + bytesWritten), data, offset + bytesWritten, numRenderDescriptors);
+    bytesWritten += WriteObject(baseObj, StructType::Offset, Format("RenderDescriptor.%X", offset + bytesWritten), data, offset + bytesWritten, numRenderDescriptors);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -826,10 +1038,10 @@ unsigned int WriteRenderDescriptorListEntry(void *baseObj, string const &name, u
     Writer::writeField("EntryType", Format("%X (%s)", entryType, entryTypeName.c_str()));
     bytesWritten += 4;
     if (entryType == 0xA000FFFF)
-        bytesWritten += WriteObject(baseObj, "OFFSET", "RenderDescriptor", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::Offset, "RenderDescriptor", data, offset + bytesWritten, 0);
     else if (entryType != 0) {
-        bytesWritten += WriteObject(baseObj, "UINT32", "unknown1", data, offset + bytesWritten, 0);
-        bytesWritten += WriteObject(baseObj, "UINT32", "Size", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "unknown1", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "Size", data, offset + bytesWritten, 0);
     }
     Writer::closeScope();
     return bytesWritten;
@@ -844,14 +1056,14 @@ unsigned int WriteModelLayers(void *baseObj, string const &name, unsigned char *
         void *modelLayers = &data[offset];
         do {
             modelLayersHeader = GetAt<unsigned int>(data, offset + bytesWritten);
-            bytesWritten += WriteObject(baseObj, "RenderDescriptorListEntry", Format("RenderDescriptorListEntry.%X", offset + bytesWritten), data, offset + bytesWritten, 0);
+            bytesWritten += WriteObject(baseObj, StructType::RenderDescriptorListEntry, Format("RenderDescriptorListEntry.%X", offset + bytesWritten), data, offset + bytesWritten, 0);
             
         } while (modelLayersHeader != 0);
     }
     else {
         unsigned int numLayers = GetAt<unsigned int>(baseObj, 0x9C);
-        bytesWritten += WriteObject(baseObj, "OFFSET", "unknown1", data, offset, 0);
-        bytesWritten += WriteObject(baseObj, "ModelLayer", Format("ModelLayer.%X", offset + bytesWritten), data, offset + bytesWritten, numLayers);
+        bytesWritten += WriteObject(baseObj, StructType::Offset, "unknown1", data, offset, 0);
+        bytesWritten += WriteObject(baseObj, StructType::ModelLayer, Format("ModelLayer.%X", offset + bytesWritten), data, offset + bytesWritten, numLayers);
     }
     Writer::closeScope();
     return bytesWritten;
@@ -860,16 +1072,16 @@ unsigned int WriteModelLayers(void *baseObj, string const &name, unsigned char *
 unsigned int WriteEAGLMicroCode(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     Writer::openScope("EAGLMicroCode " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
-    bytesWritten += WriteObject(baseObj, "UINT32", "MaxNumSelectedTechniques", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "MaxNumSelectedTechniques", data, offset + bytesWritten, 0);
     bytesWritten += WriteEnum("EffectType", data, offset + bytesWritten, { { 0, "EFFECT" }, { 1, "TECHNIQUE" }, { 2, "PASS" }});
     unsigned int numVSDeclarations = GetAt<unsigned int>(baseObj, bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumVertexShaderDeclarations", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumVertexShaderDeclarations", data, offset + bytesWritten, 0);
     if (numVSDeclarations)
-        bytesWritten += WriteObject(baseObj, "VSDECL", "VertexShaderDeclaration", data, offset + bytesWritten, numVSDeclarations);
+        bytesWritten += WriteObject(baseObj, StructType::VSDecl, "VertexShaderDeclaration", data, offset + bytesWritten, numVSDeclarations);
     unsigned int numTechniques = GetAt<unsigned int>(baseObj, bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumTechniques", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumTechniques", data, offset + bytesWritten, 0);
     if (numTechniques)
-        bytesWritten += WriteObject(baseObj, "EffectTechnique", Format("EffectTechnique.%X", offset + bytesWritten), data, offset + bytesWritten, numTechniques);
+        bytesWritten += WriteObject(baseObj, StructType::EffectTechnique, Format("EffectTechnique.%X", offset + bytesWritten), data, offset + bytesWritten, numTechniques);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -878,17 +1090,17 @@ unsigned int WriteEffectTechnique(void *baseObj, string const &name, unsigned ch
     Writer::openScope("EffectTechnique " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
     bytesWritten += WriteEnum("TechniqueType", data, offset + bytesWritten, { { 0, "EFFECT" }, { 1, "TECHNIQUE" }, { 2, "PASS" } });
-    bytesWritten += WriteObject(baseObj, "UINT32", "TecniqueId", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "TecniqueId", data, offset + bytesWritten, 0);
     unsigned int numStateAssignments1 = GetAt<unsigned int>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumTechniqueSamplerAssignments", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumTechniqueSamplerAssignments", data, offset + bytesWritten, 0);
     unsigned int numStateAssignments2 = GetAt<unsigned int>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumTechniqueGeoPrimAssignments", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumTechniqueGeoPrimAssignments", data, offset + bytesWritten, 0);
     if (numStateAssignments1 + numStateAssignments2)
-        bytesWritten += WriteObject(baseObj, "StateAssignment", Format("StateAssignment.%X", offset + bytesWritten), data, offset + bytesWritten, numStateAssignments1 + numStateAssignments2);
+        bytesWritten += WriteObject(baseObj, StructType::StateAssignment, Format("StateAssignment.%X", offset + bytesWritten), data, offset + bytesWritten, numStateAssignments1 + numStateAssignments2);
     unsigned int numPasses = GetAt<unsigned int>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumPasses", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumPasses", data, offset + bytesWritten, 0);
     if (numPasses)
-        bytesWritten += WriteObject(baseObj, "EffectPass", Format("EffectPass.%X", offset + bytesWritten), data, offset + bytesWritten, numPasses);
+        bytesWritten += WriteObject(baseObj, StructType::EffectPass, Format("EffectPass.%X", offset + bytesWritten), data, offset + bytesWritten, numPasses);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -898,11 +1110,11 @@ unsigned int WriteEffectPass(void *baseObj, string const &name, unsigned char *d
     unsigned int bytesWritten = 0;
     bytesWritten += WriteEnum("PassType", data, offset + bytesWritten, { { 0, "EFFECT" }, { 1, "TECHNIQUE" }, { 2, "PASS" } });
     unsigned int numStateAssignments1 = GetAt<unsigned int>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumPassSamplerAssignments", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumPassSamplerAssignments", data, offset + bytesWritten, 0);
     unsigned int numStateAssignments2 = GetAt<unsigned int>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumPassGeoPrimAssignments", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "UINT32", "pass_unknown1", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "StateAssignment", Format("StateAssignment.%X", offset + bytesWritten), data, offset + bytesWritten, numStateAssignments1 + numStateAssignments2 + 3);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumPassGeoPrimAssignments", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "pass_unknown1", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::StateAssignment, Format("StateAssignment.%X", offset + bytesWritten), data, offset + bytesWritten, numStateAssignments1 + numStateAssignments2 + 3);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -913,8 +1125,8 @@ unsigned int WriteStateAssignment(void *baseObj, string const &name, unsigned ch
     unsigned int type = GetAt<unsigned int>(data, offset + bytesWritten);
     bytesWritten += WriteEnum("Type", data, offset + bytesWritten, { { 3, "SAMPLER" }, { 4, "TEXTURE_STAGE" }, { 5, "GEO_PRIM" }, { 6, "VERTEX_SHADER" } , { 7, "PIXEL_SHADER" } , { 8, "VERTEX_SHADER_REFERENCE" } });
     if (type == 3) {
-        bytesWritten += WriteObject(baseObj, "UINT32", "TextureStage", data, offset + bytesWritten, 0);
-        bytesWritten += WriteObject(baseObj, "UINT32", "Sampler", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "TextureStage", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "Sampler", data, offset + bytesWritten, 0);
     }
     else if (type == 4) {
         struct TextureStageState {
@@ -983,11 +1195,11 @@ unsigned int WriteStateAssignment(void *baseObj, string const &name, unsigned ch
                 { 0X3C, "NUM_PATCH_SEGMENTS" },
                 { 0X40, "Z_WRITES_ENABLE" }
             });
-        bytesWritten += WriteObject(baseObj, "UINT32", "GeoPrimStateValue", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "GeoPrimStateValue", data, offset + bytesWritten, 0);
     }
     else if (type == 6) {
         unsigned int size = GetAt<unsigned int>(data, offset + bytesWritten) * 4;
-        bytesWritten += WriteObject(baseObj, "UINT32", "VertexShaderSizeInInts", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "VertexShaderSizeInInts", data, offset + bytesWritten, 0);
         if (size) {
             Writer::openScope("VertexShader [" + Format("%u", size) + "]", offset + bytesWritten);
             string ary;
@@ -1005,7 +1217,7 @@ unsigned int WriteStateAssignment(void *baseObj, string const &name, unsigned ch
     }
     else if (type == 7) {
         unsigned int size = GetAt<unsigned int>(data, offset + bytesWritten) * 4;
-        bytesWritten += WriteObject(baseObj, "UINT32", "PixelShaderSizeInInts", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "PixelShaderSizeInInts", data, offset + bytesWritten, 0);
         if (size) {
             Writer::openScope("PixelShader [" + Format("%u", size) + "]", offset + bytesWritten);
             string ary;
@@ -1023,7 +1235,7 @@ unsigned int WriteStateAssignment(void *baseObj, string const &name, unsigned ch
     }
     else if (type == 8) {
         unsigned int size = GetAt<unsigned int>(data, offset + bytesWritten) * 4;
-        bytesWritten += WriteObject(baseObj, "UINT32", "VertexShaderReferenceSizeInInts", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::UInt32, "VertexShaderReferenceSizeInInts", data, offset + bytesWritten, 0);
         if (size) {
             Writer::openScope("VertexShaderReference [" + Format("%u", size) + "]", offset + bytesWritten);
             string ary;
@@ -1057,15 +1269,15 @@ unsigned int WriteRenderCode(void *baseObj, string const &name, unsigned char *d
     }
     unsigned int bytesWritten = 0;
     if (numCommands > 0)
-        bytesWritten += WriteObject(baseObj, "COMMAND", "Command", data, offset + bytesWritten, numCommands);
-    bytesWritten += WriteObject(baseObj, "UINT32", Format("RenderCodeFooter.%X", offset + bytesWritten), data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::Command, "Command", data, offset + bytesWritten, numCommands);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, Format("RenderCodeFooter.%X", offset + bytesWritten), data, offset + bytesWritten, 0);
     return bytesWritten;
 }
 
 unsigned int WriteGeoPrimDataBuffer(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     Writer::openScope("geoprimdatabuffer " + name, offset); // TODO: write references
     unsigned int bytesWritten = 0;
-    bytesWritten += WriteObject(baseObj, "UINT32", "unknown1", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "unknown1", data, offset + bytesWritten, 0);
     unsigned int numTechniques = 1;
     string shaderName;
     unsigned int rmCodeOffset = (unsigned char *)baseObj - data + 8;
@@ -1080,7 +1292,7 @@ unsigned int WriteGeoPrimDataBuffer(void *baseObj, string const &name, unsigned
     auto codeShader = globalVars().target->FindShader(shaderName);
     if (codeShader)
         numTechniques = codeShader->numTechniques;
-    bytesWritten += WriteObject(baseObj, "RenderCode", "RenderCode", data, offset + bytesWritten, options().onlyFirstTechnique ? 1 : numTechniques);
+    bytesWritten += WriteObject(baseObj, StructType::RenderCode, "RenderCode", data, offset + bytesWritten, options().onlyFirstTechnique ? 1 : numTechniques);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -1101,8 +1313,8 @@ unsigned int WriteRenderDescriptor(void *baseObj, string const &name, unsigned c
         size = GetAt<unsigned short>(renderCode, commandOffset);
     }
     unsigned int bytesWritten = 0;
-    bytesWritten += WriteObject(baseObj, "OFFSET", "RenderMethod", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "CommandObjectParameter", "CommandObjectParameter", data, offset + bytesWritten, (numCommands > 2) ? (numCommands - 2) : 1);
+    bytesWritten += WriteObject(baseObj, StructType::Offset, "RenderMethod", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::CommandObjectParameter, "CommandObjectParameter", data, offset + bytesWritten, (numCommands > 2) ? (numCommands - 2) : 1);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -1110,7 +1322,7 @@ unsigned int WriteRenderDescriptor(void *baseObj, string const &name, unsigned c
 unsigned int WriteInterleavedVertices(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     Writer::openScope("InterleavedVertices " + name, offset);
     unsigned int bytesWritten = 0;
-    bytesWritten += WriteObject(baseObj, "UINT32", "unknown1", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "unknown1", data, offset + bytesWritten, 0);
     unsigned int numInterleavedVerticesDatas = 0;
     unsigned int nameOffset = 0;
     unsigned int curr = 4;
@@ -1129,8 +1341,8 @@ unsigned int WriteInterleavedVertices(void *baseObj, string const &name, unsigne
     //    printf("InterleavedVertices in %s\n", globalVars().currentFilePath.filename().string().c_str());
     //}
     if (numInterleavedVerticesDatas > 0)
-        bytesWritten += WriteObject(baseObj, "InterleavedVerticesData", "InterleavedVerticesDatas", data, offset + bytesWritten, numInterleavedVerticesDatas);
-    bytesWritten += WriteObject(baseObj, "UINT32", "Terminator", data, offset + bytesWritten, 0);
+        bytesWritten += WriteObject(baseObj, StructType::InterleavedVerticesData, "InterleavedVerticesDatas", data, offset + bytesWritten, numInterleavedVerticesDatas);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "Terminator", data, offset + bytesWritten, 0);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -1138,10 +1350,10 @@ unsigned int WriteInterleavedVertices(void *baseObj, string const &name, unsigne
 unsigned int WriteInterleavedVerticesData(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     Writer::openScope("InterleavedVerticesData " + name, offset);
     unsigned int bytesWritten = 0;
-    bytesWritten += WriteObject(baseObj, "NAMEOFFSET", "Name", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::NameOffset, "Name", data, offset + bytesWritten, 0);
     unsigned int numVertexDatas = GetAt<unsigned int>(data, offset + bytesWritten);
-    bytesWritten += WriteObject(baseObj, "UINT32", "NumVertexDatas", data, offset + bytesWritten, 0);
-    bytesWritten += WriteObject(baseObj, "InterleavedVerticesVertexData", "VertexDatas", data, offset + bytesWritten, numVertexDatas);
+    bytesWritten += WriteObject(baseObj, StructType::UInt32, "NumVertexDatas", data, offset + bytesWritten, 0);
+    bytesWritten += WriteObject(baseObj, StructType::InterleavedVerticesVertexData, "VertexDatas", data, offset + bytesWritten, numVertexDatas);
     Writer::closeScope();
     return bytesWritten;
 }
@@ -1149,11 +1361,11 @@ unsigned int WriteInterleavedVerticesData(void *baseObj, string const &name, uns
 unsigned int WriteInterleavedVerticesVertexData(void *baseObj, string const &name, unsigned char *data, unsigned int offset) {
     return WriteObjectWithFields(baseObj, "InterleavedVerticesVertexData", name, data, offset,
     {
-         { "UINT32", "Index" },
-         { "UINT16", "VertexCount" },
-         { "UINT16", "MorphVertexDataSize_MultipleVertexBuffers" },
-         { "UINT32",  "VertexBufferSize" },
-         { "OFFSET", "VertexBuffer" }
+         { StructType::UInt32, "Index" },
+         { StructType::UInt16, "VertexCount" },
+         { StructType::UInt16, "MorphVertexDataSize_MultipleVertexBuffers" },
+         { StructType::UInt32, "VertexBufferSize" },
+         { StructType::Offset, "VertexBuffer" }
     });
     return 16;
 }
@@ -1210,81 +1422,98 @@ unsigned int WriteBoneWeightsBuffer(void *baseObj, string const &name, unsigned
     return numBoneWeights * 16;
 }
 
-void InitAnalyzer() {
-    GetStructs()["int8"] = WriteInt8;
-    GetStructs()["uint8"] = WriteUInt8;
-    GetStructs()["int16"] = WriteInt16;
-    GetStructs()["uint16"] = WriteUInt16;
-    GetStructs()["int32"] = WriteInt32;
-    GetStructs()["uint32"] = WriteUInt32;
-    GetStructs()["bool32"] = WriteBool32;
-    GetStructs()["float"] = WriteFloat;
-    GetStructs()["offset"] = WriteOffset;
-    GetStructs()["nameoffset"] = WriteNameOffset;
-    GetStructs()["name"] = WriteName;
-    GetStructs()["namealigned"] = WriteNameAligned;
-    GetStructs()["vector3"] = WriteVector3;
-    GetStructs()["vector4"] = WriteVector4;
-    GetStructs()["coordinate4"] = WriteVector4;
-    GetStructs()["matrix4x4"] = WriteMatrix4x4;
-    GetStructs()["bbox"] = WriteBBOX;
-    GetStructs()["bone"] = WriteBone;
-    GetStructs()["model"] = WriteModel;
-    GetStructs()["rendermethod"] = WriteRenderMethod;
-    GetStructs()["modeltexture"] = WriteModelTexture;
-    GetStructs()["modeltexture_oldformat"] = WriteModelTexture_OldFormat;
-    GetStructs()["modifiabledata"] = WriteModifiableData;
-    GetStructs()["geoprimstate"] = WriteGeoPrimState;
-    GetStructs()["computationindex"] = WriteComputationIndex;
-    GetStructs()["irradlight"] = WriteIrradLight;
-    GetStructs()["light"] = WriteLight;
-    GetStructs()["modellayer"] = WriteModelLayer;
-    GetStructs()["modellayers"] = WriteModelLayers;
-    GetStructs()["modellayerstates"] = WriteModelLayerStates;
-    GetStructs()["modellayersstates"] = WriteModelLayersStates;
-    GetStructs()["modellayerbounding"] = WriteModelLayerBounding;
-    GetStructs()["renderdescriptorlistentry"] = WriteRenderDescriptorListEntry;
-    GetStructs()["animationbank"] = WriteAnimationBank;
-    GetStructs()["animation"] = WriteAnimation;
-    GetStructs()["skeleton"] = WriteSkeleton;
-    GetStructs()["morph"] = WriteMorph;
-    GetStructs()["bonestate"] = WriteBoneState;
-    GetStructs()["blendtarget"] = WriteBlendTarget;
-    GetStructs()["blendshape"] = WriteBlendShape;
-    GetStructs()["blendshapevertexattribute"] = WriteBlendShapeVertexAttribute;
-    GetStructs()["eaglmicrocode"] = WriteEAGLMicroCode;
-    GetStructs()["vsdecl"] = WriteVShaderDecl;
-    GetStructs()["geoprimdatabuffer"] = WriteGeoPrimDataBuffer;
-    GetStructs()["rendercode"] = WriteRenderCode;
-    GetStructs()["command"] = WriteCommand;
-    GetStructs()["renderdescriptor"] = WriteRenderDescriptor;
-    GetStructs()["commandobjectparameter"] = WriteCommandObjectParameter;
-    GetStructs()["geometryinfo"] = WriteGeometryInfo;
-    GetStructs()["vertexbuffer"] = WriteVertexBuffer;
-    GetStructs()["indexbuffer"] = WriteIndexBuffer;
-    GetStructs()["texture"] = WriteTexture;
-    GetStructs()["boneweightsbuffer"] = WriteBoneWeightsBuffer;
-    GetStructs()["interleavedvertices"] = WriteInterleavedVertices;
-    GetStructs()["interleavedverticesdata"] = WriteInterleavedVerticesData;
-    GetStructs()["interleavedverticesvertexdata"] = WriteInterleavedVerticesVertexData;
-    GetStructs()["effecttechnique"] = WriteEffectTechnique;
-    GetStructs()["effectpass"] = WriteEffectPass;
-    GetStructs()["stateassignment"] = WriteStateAssignment;
+constexpr array<Struct, size_t(StructType::Count)> MakeStructs() {
+    array<Struct, size_t(StructType::Count)> s;
+    s[size_t(StructType::Int8)] = { "INT8", WriteInt8 };
+    s[size_t(StructType::UInt8)] = { "UINT8", WriteUInt8 };
+    s[size_t(StructType::Int16)] = { "INT16", WriteInt16 };
+    s[size_t(StructType::UInt16)] = { "UINT16", WriteUInt16 };
+    s[size_t(StructType::Int32)] = { "INT32", WriteInt32 };
+    s[size_t(StructType::UInt32)] = { "UINT32", WriteUInt32 };
+    s[size_t(StructType::Bool32)] = { "BOOL32", WriteBool32 };
+    s[size_t(StructType::Float)] = { "FLOAT", WriteFloat };
+    s[size_t(StructType::Offset)] = { "OFFSET", WriteOffset };
+    s[size_t(StructType::NameOffset)] = { "NAMEOFFSET", WriteNameOffset };
+    s[size_t(StructType::Name)] = { "NAME", WriteName };
+    s[size_t(StructType::NameAligned)] = { "NAMEALIGNED", WriteNameAligned };
+    s[size_t(StructType::Vector3)] = { "VECTOR3", WriteVector3 };
+    s[size_t(StructType::Vector4)] = { "VECTOR4", WriteVector4 };
+    s[size_t(StructType::Coordinate4)] = { "Coordinate4", WriteVector4 };
+    s[size_t(StructType::Matrix4x4)] = { "Matrix4x4", WriteMatrix4x4 };
+    s[size_t(StructType::BBOX)] = { "BBOX", WriteBBOX };
+    s[size_t(StructType::Bone)] = { "Bone", WriteBone };
+    s[size_t(StructType::Model)] = { "Model", WriteModel };
+    s[size_t(StructType::RenderMethod)] = { "RenderMethod", WriteRenderMethod };
+    s[size_t(StructType::ModelTexture)] = { "ModelTexture", WriteModelTexture };
+    s[size_t(StructType::ModelTexture_OldFormat)] = { "ModelTexture_OldFormat", WriteModelTexture_OldFormat };
+    s[size_t(StructType::ModifiableData)] = { "ModifiableData", WriteModifiableData };
+    s[size_t(StructType::GeoPrimState)] = { "GeoPrimState", WriteGeoPrimState };
+    s[size_t(StructType::ComputationIndex)] = { "ComputationIndex", WriteComputationIndex };
+    s[size_t(StructType::IrradLight)] = { "IrradLight", WriteIrradLight };
+    s[size_t(StructType::Light)] = { "Light", WriteLight };
+    s[size_t(StructType::ModelLayer)] = { "ModelLayer", WriteModelLayer };
+    s[size_t(StructType::ModelLayers)] = { "ModelLayers", WriteModelLayers };
+    s[size_t(StructType::ModelLayerStates)] = { "ModelLayerStates", WriteModelLayerStates };
+    s[size_t(StructType::ModelLayersStates)] = { "ModelLayersStates", WriteModelLayersStates };
+    s[size_t(StructType::ModelLayerBounding)] = { "ModelLayerBounding", WriteModelLayerBounding };
+    s[size_t(StructType::RenderDescriptorListEntry)] = { "RenderDescriptorListEntry", WriteRenderDescriptorListEntry };
+    s[size_t(StructType::AnimationBank)] = { "AnimationBank", WriteAnimationBank };
+    s[size_t(StructType::Animation)] = { "Animation", WriteAnimation };
+    s[size_t(StructType::Skeleton)] = { "Skeleton", WriteSkeleton };
+    s[size_t(StructType::Morph)] = { "Morph", WriteMorph };
+    s[size_t(StructType::BoneState)] = { "BoneState", WriteBoneState };
+    s[size_t(StructType::BlendTarget)] = { "BlendTarget", WriteBlendTarget };
+    s[size_t(StructType::BlendShape)] = { "BlendShape", WriteBlendShape };
+    s[size_t(StructType::BlendShapeVertexAttribute)] = { "BlendShapeVertexAttribute", WriteBlendShapeVertexAttribute };
+    s[size_t(StructType::EAGLMicroCode)] = { "EAGLMicroCode", WriteEAGLMicroCode };
+    s[size_t(StructType::VSDecl)] = { "VSDECL", WriteVShaderDecl };
+    s[size_t(StructType::GeoPrimDataBuffer)] = { "GeoPrimDataBuffer", WriteGeoPrimDataBuffer };
+    s[size_t(StructType::RenderCode)] = { "RenderCode", WriteRenderCode };
+    s[size_t(StructType::Command)] = { "COMMAND", WriteCommand };
+    s[size_t(StructType::RenderDescriptor)] = { "RenderDescriptor", WriteRenderDescriptor };
+    s[size_t(StructType::CommandObjectParameter)] = { "CommandObjectParameter", WriteCommandObjectParameter };
+    s[size_t(StructType::GeometryInfo)] = { "GeometryInfo", WriteGeometryInfo };
+    s[size_t(StructType::VertexBuffer)] = { "VertexBuffer", WriteVertexBuffer };
+    s[size_t(StructType::IndexBuffer)] = { "IndexBuffer", WriteIndexBuffer };
+    s[size_t(StructType::Texture)] = { "Texture", WriteTexture };
+    s[size_t(StructType::BoneWeightsBuffer)] = { "BoneWeightsBuffer", WriteBoneWeightsBuffer };
+    s[size_t(StructType::InterleavedVertices)] = { "InterleavedVertices", WriteInterleavedVertices };
+    s[size_t(StructType::InterleavedVerticesData)] = { "InterleavedVerticesData", WriteInterleavedVerticesData };
+    s[size_t(StructType::InterleavedVerticesVertexData)] = { "InterleavedVerticesVertexData", WriteInterleavedVerticesVertexData };
+    s[size_t(StructType::EffectTechnique)] = { "EffectTechnique", WriteEffectTechnique };
+    s[size_t(StructType::EffectPass)] = { "EffectPass", WriteEffectPass };
+    s[size_t(StructType::StateAssignment)] = { "StateAssignment", WriteStateAssignment };
+    return s;
+}
+
+constexpr auto STRUCTS = MakeStructs();
+
+constexpr bool AllStructsHaveWriters() {
+    for (auto const &s : STRUCTS) {
+        if (!s.mName || !s.mWriter)
+            return false;
+    }
+    return true;
+}
+
+static_assert(AllStructsHaveWriters(), "every StructType needs an entry in STRUCTS");
+
+Struct const &GetStruct(StructType type) {
+    return STRUCTS[size_t(type)];
 }
 
 void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int fileDataSize, vector<Symbol> const &symbols, vector<Relocation> const &references) {
-    Writer::mResult.clear();
     currentData = fileData;
     class Object {
     public:
-        string mType;
+        StructType mType = StructType::UInt32;
         string mName;
         int mOffset = 0;
         unsigned int mCount = 0;
         void *mBaseObj = nullptr;
 
         Object() {}
-        Object(string const &type, string const &name, int offset, unsigned int count, void *baseObj) {
+        Object(StructType type, string const &name, int offset, unsigned int count, void *baseObj) {
             mType = type;
             mName = name;
             mOffset = offset;
@@ -1299,7 +1528,7 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
 
     map<unsigned int, Object> objects;
 
-    auto AddObjectInfo = [&](string const &type, string const &name, unsigned int offset, unsigned int count, void *baseObj) {
+    auto AddObjectInfo = [&](StructType type, string const &name, unsigned int offset, unsigned int count, void *baseObj) {
         if (objects.find(offset) == objects.end())
             objects[offset] = Object(type, name, offset, count, baseObj);
     };
@@ -1314,7 +1543,7 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
     for (auto const &s : symbols) {
         if (s.name.starts_with("__Model:::")) {
             void *model = At<void *>(fileData, s.st_value);
-            AddObjectInfo("Model", s.name.substr(10), s.st_value, 0, model);
+            AddObjectInfo(StructType::Model, s.name.substr(10), s.st_value, 0, model);
             // TODO: add symbol validation
             unsigned int texturesOffset = GetAt<unsigned int>(model, 0xBC);
             if (texturesOffset) { // TODO: replace with IsValidOffset()
@@ -1330,10 +1559,10 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
                     for (unsigned int tx = 0; tx < texCount; tx++) {
                         unsigned int texOffset = GetAt<unsigned int>(texDesc, 8 + tx * 4);
                         if (texOffset != 0) // TODO: replace with IsValidOffset()
-                            AddObjectInfo("Texture", Format("Texture.%X", texOffset), texOffset, 0, model);
+                            AddObjectInfo(StructType::Texture, Format("Texture.%X", texOffset), texOffset, 0, model);
                     }
                     unsigned short info = GetAt<unsigned int>(texDesc, 8 + texSize);
-                    AddObjectInfo("NAME", Format("Name.%X", texNameOffset), texNameOffset, 0, model);
+                    AddObjectInfo(StructType::Name, Format("Name.%X", texNameOffset), texNameOffset, 0, model);
                     if (info == 1)
                         tmpTexOffset += 12 + texSize;
                     else {
@@ -1343,22 +1572,22 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
                     texDesc = At<void *>(fileData, tmpTexOffset);
                     texNameOffset = GetAt<unsigned int>(texDesc, 0);
                 }
-                AddObjectInfo("UINT32", Format("ModelTexturesFooter.%X", tmpTexOffset), tmpTexOffset, 0, model);
+                AddObjectInfo(StructType::UInt32, Format("ModelTexturesFooter.%X", tmpTexOffset), tmpTexOffset, 0, model);
                 if (numTextures > 0) {
                     if (oldModelTextureFormat)
-                        AddObjectInfo("ModelTexture_OldFormat", Format("ModelTexture_OldFormat.%X", texturesOffset), texturesOffset, numTextures, model);
+                        AddObjectInfo(StructType::ModelTexture_OldFormat, Format("ModelTexture_OldFormat.%X", texturesOffset), texturesOffset, numTextures, model);
                     else
-                        AddObjectInfo("ModelTexture", Format("ModelTexture.%X", texturesOffset), texturesOffset, numTextures, model);
+                        AddObjectInfo(StructType::ModelTexture, Format("ModelTexture.%X", texturesOffset), texturesOffset, numTextures, model);
                 }
             }
             unsigned int numLayers = GetAt<unsigned int>(model, 0x9C);
             if (numLayers) {
                 unsigned int layerNamesOffset = GetAt<unsigned int>(model, 0xA0);
-                AddObjectInfo("NAMEOFFSET", Format("ModelLayerName.%X", layerNamesOffset), layerNamesOffset, numLayers, model);
+                AddObjectInfo(StructType::NameOffset, Format("ModelLayerName.%X", layerNamesOffset), layerNamesOffset, numLayers, model);
                 for (unsigned int i = 0; i < numLayers; i++)
-                    AddObjectInfo("NAME", Format("Name.%X", GetAt<unsigned int>(fileData, layerNamesOffset + 4 * i)), GetAt<unsigned int>(fileData, layerNamesOffset + 4 * i), 0, model);
+                    AddObjectInfo(StructType::Name, Format("Name.%X", GetAt<unsigned int>(fileData, layerNamesOffset + 4 * i)), GetAt<unsigned int>(fileData, layerNamesOffset + 4 * i), 0, model);
                 unsigned int modelLayersOffset = GetAt<unsigned int>(model, 0xCC);
-                AddObjectInfo("ModelLayers", Format("ModelLayers.%X", modelLayersOffset), modelLayersOffset, 0, model);
+                AddObjectInfo(StructType::ModelLayers, Format("ModelLayers.%X", modelLayersOffset), modelLayersOffset, 0, model);
                 void *modelLayers = At<void *>(fileData, modelLayersOffset);
                 unsigned int modelLayersHeader = GetAt<unsigned int>(modelLayers, 0);
                 bool isOldFormat = modelLayersHeader == 0xA0000000;
@@ -1376,10 +1605,10 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
                         unsigned int renderDescriptorOffset = *rd;
                         rd++;
                         void *renderDescriptor = At<void *>(fileData, renderDescriptorOffset);
-                        AddObjectInfo("RenderDescriptor", Format("RenderDescriptor.%X", renderDescriptorOffset), renderDescriptorOffset, 0, model);
+                        AddObjectInfo(StructType::RenderDescriptor, Format("RenderDescriptor.%X", renderDescriptorOffset), renderDescriptorOffset, 0, model);
                         void *renderMethod = At<void *>(fileData, GetAt<unsigned int>(renderDescriptor, 0));
                         void *globalParameters = At<void *>(renderDescriptor, 4);
-                        AddObjectInfo("GeometryInfo", Format("GeometryInfo.%X", GetAt<unsigned int>(globalParameters, 4)), GetAt<unsigned int>(globalParameters, 4), GetAt<unsigned int>(globalParameters, 0), model);
+                        AddObjectInfo(StructType::GeometryInfo, Format("GeometryInfo.%X", GetAt<unsigned int>(globalParameters, 4)), GetAt<unsigned int>(globalParameters, 4), GetAt<unsigned int>(globalParameters, 0), model);
                         unsigned int rmCodeOffset = GetAt<unsigned int>(renderDescriptor, 0) + 8;
                         auto it = symbolRelocations.find(rmCodeOffset);
                         if (it != symbolRelocations.end() && (*it).second.st_info == 0x10) {
@@ -1397,13 +1626,13 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
                                         switch (id) {
                                         case 4:
                                         case 75:
-                                            AddObjectInfo("VertexBuffer", Format("VertexBuffer.%X", GetAt<unsigned int>(renderCode, commandOffset + 24)), GetAt<unsigned int>(renderCode, commandOffset + 24), 0, At<void *>(renderCode, commandOffset));
+                                            AddObjectInfo(StructType::VertexBuffer, Format("VertexBuffer.%X", GetAt<unsigned int>(renderCode, commandOffset + 24)), GetAt<unsigned int>(renderCode, commandOffset + 24), 0, At<void *>(renderCode, commandOffset));
                                             break;
                                         case 7:
-                                            AddObjectInfo("IndexBuffer", Format("IndexBuffer.%X", GetAt<unsigned int>(renderCode, commandOffset + 16)), GetAt<unsigned int>(renderCode, commandOffset + 16), 0, At<void *>(renderCode, commandOffset));
+                                            AddObjectInfo(StructType::IndexBuffer, Format("IndexBuffer.%X", GetAt<unsigned int>(renderCode, commandOffset + 16)), GetAt<unsigned int>(renderCode, commandOffset + 16), 0, At<void *>(renderCode, commandOffset));
                                             break;
                                         case 28:
-                                            AddObjectInfo("BoneWeightsBuffer", Format("BoneWeightsBuffer.%X", GetAt<unsigned int>(globalParameters, 4)), GetAt<unsigned int>(globalParameters, 4), 0, globalParameters);
+                                            AddObjectInfo(StructType::BoneWeightsBuffer, Format("BoneWeightsBuffer.%X", GetAt<unsigned int>(globalParameters, 4)), GetAt<unsigned int>(globalParameters, 4), 0, globalParameters);
                                             break;
                                         }
                                         if (numCommands != 0)
@@ -1418,37 +1647,37 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
                         }
                     }
                 }
-                AddObjectInfo("ModelLayerBounding", Format("ModelLayerBounding.%X", s.st_value - numLayers * 48), s.st_value - numLayers * 48, numLayers, model);
+                AddObjectInfo(StructType::ModelLayerBounding, Format("ModelLayerBounding.%X", s.st_value - numLayers * 48), s.st_value - numLayers * 48, numLayers, model);
             }
-            AddObjectInfo("ModelLayersStates", Format("ModelLayersStates.%X", GetAt<unsigned int>(model, 0xC4)), GetAt<unsigned int>(model, 0xC4), 0, model);
-            AddObjectInfo("InterleavedVertices", Format("InterleavedVertices.%X", GetAt<unsigned int>(model, 0xB8)), GetAt<unsigned int>(model, 0xB8), 0, model);
+            AddObjectInfo(StructType::ModelLayersStates, Format("ModelLayersStates.%X", GetAt<unsigned int>(model, 0xC4)), GetAt<unsigned int>(model, 0xC4), 0, model);
+            AddObjectInfo(StructType::InterleavedVertices, Format("InterleavedVertices.%X", GetAt<unsigned int>(model, 0xB8)), GetAt<unsigned int>(model, 0xB8), 0, model);
             unsigned int nameOffset = GetAt<unsigned int>(model, 0xB4);
             if (nameOffset) // TODO: replace with IsValidOffset()
-                AddObjectInfo("NAME", Format("Name.%X", nameOffset), nameOffset, 0, model);
+                AddObjectInfo(StructType::Name, Format("Name.%X", nameOffset), nameOffset, 0, model);
             unsigned int numModifiableDatas = GetAt<unsigned int>(model, 0x04);
             if (numModifiableDatas) {
-                AddObjectInfo("ModifiableData", Format("ModifiableData.%X", GetAt<unsigned int>(model, 0x0)), GetAt<unsigned int>(model, 0x0), numModifiableDatas, model);
+                AddObjectInfo(StructType::ModifiableData, Format("ModifiableData.%X", GetAt<unsigned int>(model, 0x0)), GetAt<unsigned int>(model, 0x0), numModifiableDatas, model);
                 for (unsigned int i = 0; i < numModifiableDatas; i++) {
                     void *modData = At<void *>(fileData, GetAt<unsigned int>(model, 0x0) + 16 * i);
                     unsigned int numEntries = GetAt<unsigned int>(modData, 0x8);
                     if (numEntries) {
                         unsigned short entrySize = GetAt<unsigned short>(modData, 0x4);
                         char *name = At<char>(fileData, GetAt<unsigned int>(modData, 0x0));
-                        AddObjectInfo("NAMEALIGNED", Format("Name.%X", GetAt<unsigned int>(modData, 0x0)), GetAt<unsigned int>(modData, 0x0), 0, model);
+                        AddObjectInfo(StructType::NameAligned, Format("Name.%X", GetAt<unsigned int>(modData, 0x0)), GetAt<unsigned int>(modData, 0x0), 0, model);
                         auto it = symbolRelocations.find(GetAt<unsigned int>(model, 0x0) + 16 * i + 0xC);
                         if (it == symbolRelocations.end() || (*it).second.st_info != 0x10) {
                             if (entrySize == 68)
-                                AddObjectInfo("GeoPrimState", name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
+                                AddObjectInfo(StructType::GeoPrimState, name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
                             else if (entrySize == 4)
-                                AddObjectInfo("ComputationIndex", name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
+                                AddObjectInfo(StructType::ComputationIndex, name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
                             else if (entrySize == 160)
-                                AddObjectInfo("IrradLight", name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
+                                AddObjectInfo(StructType::IrradLight, name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
                             else if (entrySize == 112)
-                                AddObjectInfo("Light", name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
+                                AddObjectInfo(StructType::Light, name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
                             else if (entrySize == 16)
-                                AddObjectInfo("Coordinate4", name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
+                                AddObjectInfo(StructType::Coordinate4, name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
                             else if (entrySize == 64)
-                                AddObjectInfo("Matrix4x4", name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
+                                AddObjectInfo(StructType::Matrix4x4, name + Format(".%X", GetAt<unsigned int>(modData, 0xC)), GetAt<unsigned int>(modData, 0xC), numEntries, model);
                         }
                     }
                 }
@@ -1456,27 +1685,27 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
         }
         if (s.name.starts_with("__RenderMethod:::")) {
             void *renderMethod = At<void *>(fileData, s.st_value);
-            AddObjectInfo("RenderMethod", s.name.substr(17), s.st_value, 0, renderMethod);
+            AddObjectInfo(StructType::RenderMethod, s.name.substr(17), s.st_value, 0, renderMethod);
             if (globalVars().target->Version() >= 3) {
                 unsigned int nameOffset = GetAt<unsigned int>(renderMethod, 0x2C);
                 if (nameOffset) // TODO: replace with IsValidOffset()
-                    AddObjectInfo("NAMEALIGNED", Format("Name.%X", nameOffset), nameOffset, 0, renderMethod);
+                    AddObjectInfo(StructType::NameAligned, Format("Name.%X", nameOffset), nameOffset, 0, renderMethod);
             }
             unsigned int geoBuf = GetAt<unsigned int>(renderMethod, 0x24);
             if (geoBuf && geoBuf != GetAt<unsigned int>(renderMethod, 8)) // TODO: replace with IsValidOffset()
-                AddObjectInfo("geoprimdatabuffer", Format("geoprimdatabuffer.%X", geoBuf), geoBuf, 0, renderMethod);
+                AddObjectInfo(StructType::GeoPrimDataBuffer, Format("geoprimdatabuffer.%X", geoBuf), geoBuf, 0, renderMethod);
             else {
                 unsigned int codeBlock = GetAt<unsigned int>(renderMethod, 0);
                 if (codeBlock >= 4) // TODO: replace with IsValidOffset()
-                    AddObjectInfo("geoprimdatabuffer", Format("geoprimdatabuffer.%X", codeBlock - 4), codeBlock - 4, 0, renderMethod);
+                    AddObjectInfo(StructType::GeoPrimDataBuffer, Format("geoprimdatabuffer.%X", codeBlock - 4), codeBlock - 4, 0, renderMethod);
             }
         }
         else if (s.name.starts_with("__BBOX:::"))
-            AddObjectInfo("BBOX", s.name.substr(9), s.st_value, 0, nullptr);
+            AddObjectInfo(StructType::BBOX, s.name.substr(9), s.st_value, 0, nullptr);
         else if (s.name.starts_with("__Bone:::"))
-            AddObjectInfo("Bone", s.name.substr(9), s.st_value, 0, nullptr);
+            AddObjectInfo(StructType::Bone, s.name.substr(9), s.st_value, 0, nullptr);
         else if (s.name.starts_with("__AnimationBank:::")) {
-            AddObjectInfo("AnimationBank", s.name.substr(18), s.st_value, 0, nullptr);
+            AddObjectInfo(StructType::AnimationBank, s.name.substr(18), s.st_value, 0, nullptr);
             void *bank = At<void *>(fileData, s.st_value);
             unsigned int numAnimations = GetAt<unsigned int>(bank, 0x4);
             if (numAnimations > 0) {
@@ -1484,18 +1713,18 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
                 bool oldBankVersion = animBankSize == 0x18;
                 unsigned int animNamesOffset = GetAt<unsigned int>(bank, oldBankVersion ? 0x10 : 0x14);
                 unsigned int animsOffset = GetAt<unsigned int>(bank, oldBankVersion ? 0xC : 0x10);
-                AddObjectInfo("NAMEOFFSET", Format("AnimationName.%X", animNamesOffset), animNamesOffset, numAnimations, bank);
-                AddObjectInfo("OFFSET", Format("AnimationOffset.%X", animsOffset), animsOffset, numAnimations, bank);
+                AddObjectInfo(StructType::NameOffset, Format("AnimationName.%X", animNamesOffset), animNamesOffset, numAnimations, bank);
+                AddObjectInfo(StructType::Offset, Format("AnimationOffset.%X", animsOffset), animsOffset, numAnimations, bank);
                 for (unsigned int i = 0; i < numAnimations; i++) {
                     unsigned int animationOffset = GetAt<unsigned int>(fileData, animsOffset + 4 * i);
-                    AddObjectInfo("Animation", Format("Animation.%X", animationOffset), animationOffset, 0, bank);
-                    AddObjectInfo((i == (numAnimations - 1)) ? "NAMEALIGNED" : "NAME", Format("Name.%X", GetAt<unsigned int>(fileData, animNamesOffset + 4 * i)), GetAt<unsigned int>(fileData, animNamesOffset + 4 * i), 0, bank);
+                    AddObjectInfo(StructType::Animation, Format("Animation.%X", animationOffset), animationOffset, 0, bank);
+                    AddObjectInfo((i == (numAnimations - 1)) ? StructType::NameAligned : StructType::Name, Format("Name.%X", GetAt<unsigned int>(fileData, animNamesOffset + 4 * i)), GetAt<unsigned int>(fileData, animNamesOffset + 4 * i), 0, bank);
                     void *animation = At<void *>(fileData, animationOffset);
                     if (GetAt<unsigned short>(animation, 0) == 15) {
                         unsigned short numChannels = GetAt<unsigned short>(animation, 0x8);
                         for (unsigned int a = 0; a < numChannels; a++) {
                             unsigned int channelOffset = GetAt<unsigned int>(animation, 0xC + a * 4);
-                            AddObjectInfo("Animation", Format("Animation.%X", channelOffset), channelOffset, 0, bank);
+                            AddObjectInfo(StructType::Animation, Format("Animation.%X", channelOffset), channelOffset, 0, bank);
                         }
                     }
                 }
@@ -1503,27 +1732,27 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
         }
         else if (s.name.starts_with("__Skeleton:::")) {
             void *skeleton = At<void *>(fileData, s.st_value);
-            AddObjectInfo("Skeleton", s.name.substr(13), s.st_value, 0, skeleton);
+            AddObjectInfo(StructType::Skeleton, s.name.substr(13), s.st_value, 0, skeleton);
         }
         else if (s.name.starts_with("__Morph:::")) {
             void *morph = At<void *>(fileData, s.st_value);
-            AddObjectInfo("Morph", s.name.substr(10), s.st_value, 0, morph);
+            AddObjectInfo(StructType::Morph, s.name.substr(10), s.st_value, 0, morph);
             unsigned int numWeights = GetAt<unsigned int>(morph, 0x0);
             unsigned int weightNamesOffset = GetAt<unsigned int>(morph, 0x4);
             unsigned int weightValuesOffset = GetAt<unsigned int>(morph, 0x8);
             unsigned int numBlendTargets = GetAt<unsigned int>(morph, 0x10);
-            AddObjectInfo("NAMEOFFSET", Format("BlendWeightName.%X", weightNamesOffset), weightNamesOffset, numWeights, morph);
-            AddObjectInfo("FLOAT", Format("BlendWeightValue.%X", weightValuesOffset), weightValuesOffset, numWeights, morph);
+            AddObjectInfo(StructType::NameOffset, Format("BlendWeightName.%X", weightNamesOffset), weightNamesOffset, numWeights, morph);
+            AddObjectInfo(StructType::Float, Format("BlendWeightValue.%X", weightValuesOffset), weightValuesOffset, numWeights, morph);
             for (unsigned int i = 0; i < numWeights; i++) {
                 unsigned int nameOffset = GetAt<unsigned int>(fileData, weightNamesOffset + 4 * i);
-                AddObjectInfo("NAME", Format("Name.%X", nameOffset), nameOffset, 0, morph);
+                AddObjectInfo(StructType::Name, Format("Name.%X", nameOffset), nameOffset, 0, morph);
             }
             unsigned int morphOffset = s.st_value + 20;
             for (unsigned int t = 0; t < numBlendTargets; t++) {
                 unsigned int nameOffset = GetAt<unsigned int>(fileData, morphOffset);
                 unsigned int numBlendShapes = GetAt<unsigned int>(fileData, morphOffset + 4);
                 morphOffset += 8;
-                AddObjectInfo("NAME", Format("Name.%X", nameOffset), nameOffset, 0, morph);
+                AddObjectInfo(StructType::Name, Format("Name.%X", nameOffset), nameOffset, 0, morph);
                 for (unsigned int b = 0; b < numBlendShapes; b++) {
                     unsigned int numAttributes = GetAt<unsigned int>(fileData, morphOffset + 4);
                     morphOffset += 8;
@@ -1536,17 +1765,34 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
         }
         else if (s.name.ends_with("__EAGLMicroCode") && s.st_info == 0x11) {
             void *microCode = At<void *>(fileData, s.st_value);
-            AddObjectInfo("EAGLMicroCode", s.name.substr(0, s.name.length() - 15), s.st_value, 0, microCode);
+            AddObjectInfo(StructType::EAGLMicroCode, s.name.substr(0, s.name.length() - 15), s.st_value, 0, microCode);
         }
         //else if (s.name.starts_with("__geoprimdatabuffer")) {
         //    void *geoprimdatabuffer = At<void *>(fileData, s.st_value);
-        //    AddObjectInfo("geoprimdatabuffer", s.name, s.st_value, 0, geoprimdatabuffer);
+        //    AddObjectInfo(StructType::GeoPrimDataBuffer, s.name, s.st_value, 0, geoprimdatabuffer);
         //}
     }
-    Writer::writeLine("// " + filename);
+    Writer::writeFileHeader(filename, fileDataSize);
 
     int previousStructEnd = -1;
 
+    vector<Writer::Reference> objectReferences;
+    auto CollectReferences = [&](unsigned int offset, unsigned int size) -> vector<Writer::Reference> const & {
+        objectReferences.clear();
+        if (Writer::isJson()) {
+            for (auto it = symbolRelocations.lower_bound(offset); it != symbolRelocations.end() && (*it).first < offset + size; ++it) {
+                Writer::Reference ref;
+                ref.offset = (*it).first;
+                if ((*it).second.st_info == 0x10)
+                    ref.symbol = (*it).second.name.c_str();
+                else
+                    ref.target = GetAt<unsigned int>(fileData, (*it).first);
+                objectReferences.push_back(ref);
+            }
+        }
+        return objectReferences;
+    };
+
     auto WriteUnknown = [&](unsigned int endOffset) {
         if (previousStructEnd == -1)
             previousStructEnd = 0;
@@ -1555,6 +1801,7 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
             Error("previousStructEnd (%X) > endOffset (%X)", previousStructEnd, endOffset);
         }
         unsigned int size = endOffset - previousStructEnd;
+        Writer::beginObject("Unknown", string_view(), previousStructEnd, 0);
         Writer::openScope("Unknown [" + Format("%u", size) + "]", previousStructEnd); // TODO: write references
         string ary;
         for (unsigned int i = 0; i < min(size, 100u); i++) {
@@ -1566,6 +1813,7 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
             ary += "...";
         Writer::writeLine(ary);
         Writer::closeScope();
+        Writer::endObject(size, CollectReferences(previousStructEnd, size));
         previousStructEnd += size;
     };
     for (auto const &[i, o] : objects) {
@@ -1574,7 +1822,10 @@ void AnalyzeFile(string const &filename, unsigned char *fileData, unsigned int f
         //::Warning("writing %s - %s", o.mType.c_str(), o.mName.c_str());
         if (o.mOffset != previousStructEnd)
             WriteUnknown(o.mOffset);
-        previousStructEnd += WriteObject(o.mBaseObj, o.mType, o.mName, fileData, o.mOffset, o.mCount);
+        Writer::beginObject(GetStruct(o.mType).mName, o.mName, o.mOffset, o.mCount);
+        unsigned int size = WriteObject(o.mBaseObj, o.mType, o.mName, fileData, o.mOffset, o.mCount);
+        Writer::endObject(size, CollectReferences(o.mOffset, size));
+        previousStructEnd += size;
     }
     if (previousStructEnd != fileDataSize)
         WriteUnknown(fileDataSize);
@@ -1588,7 +1839,8 @@ GlobalVars &globalVars() {
 }
 
 void odump(path const &out, path const &in) {
-    dump::InitAnalyzer();
+    if (!dump::Writer::open(out, options().dumpJson))
+        return;
     auto fileData = readofile(in);
     if (fileData.first) {
         unsigned char *data = nullptr;
@@ -1647,7 +1899,5 @@ void odump(path const &out, path const &in) {
         AnalyzeFile(in.filename().string(), data, dataSize, vecSymbols, vecReferences);
         delete[] fileData.first;
     }
-    ofstream w(out, ios::out);
-    if (w.is_open())
-        w << dump::Writer::mResult;
+    dump::Writer::close();
 }
@@ -2,6 +2,9 @@
 #include <fstream>
 #include <iostream>
 #include "shaders.h"
+#include "binbuf.h"
+#include <thread>
+#include <atomic>
 
 enum SamplerArgumentType {
     SamplerUndefined = 0,
@@ -357,9 +360,26 @@ int GetShaderAttributeFromSymbolName(string const &symbolName) {
 }
 
 class ShaderDumper {
+    // shaders found in a single model file (or merged over all files)
+    struct ScanResult {
+        vector<ShaderInfo> shaders;
+        map<string, unsigned int> shaderTextures;
+        set<string> notFoundShaders;
+        vector<string> errors;
+    };
+
+    // per-file cache entry, valid while file size and modification time match
+    struct CachedScan {
+        unsigned long long fileSize = 0;
+        long long fileTime = 0;
+        ScanResult result;
+    };
+
+    static constexpr unsigned int CACHE_SIGNATURE = 0x43534853; // 'SHSC'
+    static constexpr unsigned int CACHE_VERSION = 1;
+
     map<string, pair<unsigned int, vector<Shader::VertexDeclElement>>> shadersDef;
     vector<ShaderInfo> shaders;
-    set<string> notFoundShaders;
     map<string, unsigned int> shaderTextures;
 
     struct FileSymbol : public Elf32_Sym {
@@ -379,15 +399,15 @@ class ShaderDumper {
     struct BBOX { vector3 min, max; };
 
     struct ModifiableData {
-        char *mName;
+        Ptr32<char> mName;
         unsigned short mEntrySize;
         unsigned short unknown;
         unsigned int mEntriesCount;
-        void *mEntries;
+        Ptr32<void> mEntries;
     };
 
     struct Model {
-        ModifiableData *mModifiableData;
+        Ptr32<ModifiableData> mModifiableData;
         unsigned int mNumModifiableDatas;
         unsigned int mNumVariations;
         Matrix4x4 mTransform;
@@ -397,18 +417,18 @@ class ShaderDumper {
         vector4 mBoundMax;
         vector4 mCenter;
         unsigned int mNumLayers;
-        char const **mLayerNames;
+        Ptr32<Ptr32<char const>> mLayerNames;
         unsigned int field_A4;
-        Model *field_A8;
-        Model *field_AC;
-        Model *mNext;
-        char const *mName;
-        void *mMorphVertexInfo;
-        void *mTextures;
+        Ptr32<Model> field_A8;
+        Ptr32<Model> field_AC;
+        Ptr32<Model> mNext;
+        Ptr32<char const> mName;
+        Ptr32<void> mMorphVertexInfo;
+        Ptr32<void> mTextures;
         unsigned int mVariationID;
-        void *mLayersStates;
+        Ptr32<void> mLayersStates;
         unsigned int mIsRenderable;
-        void *mLayers;
+        Ptr32<void> mLayers;
         unsigned int field_D0;
         unsigned int field_D4;
         unsigned int mSkeletonVersion;
@@ -416,19 +436,19 @@ class ShaderDumper {
     };
 
     struct RenderMethod {
-        unsigned char *mCodeBlock;
-        unsigned char **mCodeToUse;
-        void *mMicroCode;
-        void *mETTObject;
-        RenderMethod *mParent;
-        char const **mpParameterNames;
+        Ptr32<unsigned char> mCodeBlock;
+        Ptr32<Ptr32<unsigned char>> mCodeToUse;
+        Ptr32<void> mMicroCode;
+        Ptr32<void> mETTObject;
+        Ptr32<RenderMethod> mParent;
+        Ptr32<Ptr32<char const>> mpParameterNames;
         unsigned int field_18;
         int field_1C;
-        RenderMethod *field_20;
-        void *mGeoPrimDataBuffer;
+        Ptr32<RenderMethod> field_20;
+        Ptr32<void> mGeoPrimDataBuffer;
         int mComputationIndexCommand;
-        char const *mShaderName;
-        void *mEAGLModel;
+        Ptr32<char const> mShaderName;
+        Ptr32<void> mEAGLModel;
     };
 
     struct GeometryInfo {
@@ -461,7 +481,7 @@ class ShaderDumper {
         unsigned short unknown1;
         unsigned int mSignature2;
         unsigned int mNumBones;
-        void *unknown2;
+        Ptr32<void> unknown2;
     };
 
     struct VertexSkinDataPacked {
@@ -528,7 +548,7 @@ class ShaderDumper {
         int nZWritesEnable;
     };
 public:
-    void get_o_info(path const &inPath, bool isEAGLRM = false) {
+    void get_o_info(path const &inPath, ScanResult &out, bool isEAGLRM = false) {
         auto fileData = readofile(inPath);
         if (!fileData.first)
             return;
@@ -597,12 +617,13 @@ public:
                 symbolRelocations[rel[i].r_offset] = symbols[rel[i].r_info_sym];
         }
 
-        // do relocations
+        // register relocations
 
+        RelocView view(data, dataSize);
         for (unsigned int i = 0; i < numRelocations; i++) {
             auto symbolId = rel[i].r_info_sym;
             if (symbolId < numSymbols && isSymbolDataPresent(symbols[symbolId]))
-                SetAt(data, rel[i].r_offset, &data[GetAt<unsigned int>(data, rel[i].r_offset)]);
+                view.AddRelocation(rel[i].r_offset);
         }
 
         if (isEAGLRM) {
@@ -611,7 +632,7 @@ public:
                     if (s.name.ends_with("__EAGLMicroCode")) {
                         string shaderName = s.name.substr(0, s.name.length() - 15);
                         if (!shaderName.empty()) {
-                            void *m = At<void *>(data, s.st_value);
+                            void *m = At<void>(data, s.st_value);
                             auto &def = shadersDef[shaderName];
                             unsigned int maxSelected = GetAt<unsigned int>(m, 0);
                             unsigned int baseOffset = 4;
@@ -724,10 +745,11 @@ public:
                 static unsigned int vec3DA0A0A1[4] = { 0x3DA0A0A1, 0x3DA0A0A1, 0x3DA0A0A1, 0x3DA0A0A1 };
                 static unsigned int vec40200000[4] = { 0x40200000, 0x40A00000, 0x3F000000, 0x3F800000 };
                 map<void const *, ModifiableData const *> modifiables;
-                for (unsigned int m = 0; m < model->mNumModifiableDatas; m++)
-                    modifiables[model->mModifiableData[m].mEntries] = &model->mModifiableData[m];
-                if (model->mNumLayers && model->mLayers) {
-                    unsigned int *modelLayers = (unsigned int *)(model->mLayers);
+                ModifiableData const *modifiableData = view.Get(model->mModifiableData);
+                for (unsigned int m = 0; modifiableData && m < model->mNumModifiableDatas; m++)
+                    modifiables[view.Get(modifiableData[m].mEntries)] = &modifiableData[m];
+                if (model->mNumLayers && view.Get(model->mLayers)) {
+                    unsigned int *modelLayers = (unsigned int *)view.Get(model->mLayers);
                     unsigned int modelLayersHeader = *modelLayers;
                     bool isOldFormat = modelLayersHeader == 0xA0000000;
                     modelLayers++;
@@ -741,9 +763,9 @@ public:
                             numPrimitives /= 2;
                         modelLayers++;
                         for (unsigned int p = 0; p < numPrimitives; p++) {
-                            void *renderDescriptor = GetAt<void *>(modelLayers, isOldFormat ? (p * 8 + 4) : (p * 4));
-                            RenderMethod *renderMethod = GetAt<RenderMethod *>(renderDescriptor, 0);
-                            void *globalParameters = At<void *>(renderDescriptor, 4);
+                            void *renderDescriptor = view.Get<void>(modelLayers, isOldFormat ? (p * 8 + 4) : (p * 4));
+                            RenderMethod *renderMethod = view.Get<RenderMethod>(renderDescriptor, 0);
+                            void *globalParameters = At<void>(renderDescriptor, 4);
                             unsigned int rmCodeOffset = At<unsigned char>(renderMethod, 8) - data;
                             auto it = symbolRelocations.find(rmCodeOffset);
                             if (it != symbolRelocations.end() && (*it).second.st_info == 0x10) {
@@ -755,7 +777,7 @@ public:
                                         auto const &shader = (*it).second;
                                         ShaderInfo info;
                                         info.name = shaderName;
-                                        void *renderCode = GetAt<void *>(renderMethod, 0);
+                                        void *renderCode = view.Get<void>(renderMethod, 0);
                                         unsigned int numCommands = 0;
                                         unsigned int commandOffset = 0;
                                         vector<unsigned short> firstTechniqueCommands;
@@ -767,7 +789,7 @@ public:
                                                 if (t == 0)
                                                     numCommands++;
                                                 if (size == 0) {
-                                                    Error("Incorrect instruction size (0) in %s", filename.c_str());
+                                                    out.errors.push_back("Incorrect instruction size (0) in " + filename);
                                                     break;
                                                 }
                                                 if (id == 31)
@@ -904,8 +926,8 @@ public:
                                                 if (g == 0)
                                                     info.globalArguments[g].type = Shader::GeometryInfo;
                                                 else {
-                                                    auto argDataPtr = At<void *>(globalParameters, 4);
-                                                    auto argData = *argDataPtr;
+                                                    auto argDataPtr = At<void>(globalParameters, 4);
+                                                    auto argData = view.Get<void>(argDataPtr, 0);
                                                     auto argCount = GetAt<unsigned int>(globalParameters, 0);
                                                     switch (firstTechniqueCommands[g + 1]) {
                                                     case 4:
@@ -940,7 +962,7 @@ public:
                                                                 break;
                                                             }
                                                         }
-                                                        Texture const *tar = GetAt<Texture *>(globalParameters, 4);
+                                                        Texture const *tar = view.Get<Texture>(globalParameters, 4);
                                                         string tarAttributes;
                                                         if (tar) { // local texture
                                                             char texTag[5];
@@ -955,12 +977,12 @@ public:
                                                                     break;
                                                                 }
                                                             }
-                                                            shaderTextures[texTag] |= samplerArgType;
+                                                            out.shaderTextures[texTag] |= samplerArgType;
                                                             if (info.commands[g + 1].arguments.size() > 0 && info.commands[g + 1].arguments[0] < 4)
                                                                 info.samplerArguments[info.commands[g + 1].arguments[0]] |= samplerArgType;
                                                         }
                                                         else { // global or runtime-constructed texture
-                                                            unsigned int tarOffset = unsigned int(At<Texture *>(globalParameters, 4)) - unsigned int(data);
+                                                            unsigned int tarOffset = view.OffsetOf(At<void>(globalParameters, 4));
                                                             auto it2 = symbolRelocations.find(tarOffset);
                                                             if (it2 != symbolRelocations.end()) {
                                                                 auto const &s = (*it2).second;
@@ -980,7 +1002,7 @@ public:
                                                                         }
                                                                     }
                                                                     if (!texName.empty()) {
-                                                                        shaderTextures[texName] |= SamplerArgumentType::SamplerGlobal;
+                                                                        out.shaderTextures[texName] |= SamplerArgumentType::SamplerGlobal;
                                                                         if (info.commands[g + 1].arguments.size() > 0 && info.commands[g + 1].arguments[0] < 4)
                                                                             info.samplerArguments[info.commands[g + 1].arguments[0]] |= SamplerArgumentType::SamplerGlobal;
                                                                     }
@@ -991,7 +1013,7 @@ public:
                                                     break;
                                                     default:
                                                         {
-                                                            auto rit = symbolRelocations.find(unsigned int(argDataPtr) - unsigned int(data));
+                                                            auto rit = symbolRelocations.find(view.OffsetOf(argDataPtr));
                                                             if (rit != symbolRelocations.end()) {
                                                                 string symbolName = (*rit).second.name;
                                                                 auto attr = GetShaderAttributeFromSymbolName(symbolName);
@@ -1007,7 +1029,7 @@ public:
                                                                                 if (argData) {
                                                                                     auto mit = modifiables.find(argData);
                                                                                     if (mit != modifiables.end()) {
-                                                                                        if ((*mit).second->mName == "State::GeoPrimState")
+                                                                                        if (view.Get((*mit).second->mName) == "State::GeoPrimState")
                                                                                             info.globalArguments[g].type = Shader::RuntimeGeoPrimState2;
                                                                                     }
                                                                                 } 
@@ -1019,7 +1041,7 @@ public:
                                                                         auto mit = modifiables.find(argData);
                                                                         if (mit != modifiables.end()) {
                                                                             ModifiableData const *m = (*mit).second;
-                                                                            string mname = m->mName;
+                                                                            string mname = view.Get(m->mName);
                                                                             if (mname == "ComputationIndex::CompIdx")
                                                                                 info.globalArguments[g].type = Shader::ComputationIndex;
                                                                             else if(mname == "Coordinate4::BaseColour")
@@ -1128,7 +1150,7 @@ public:
                                             }
                                         }
                                         bool found = false;
-                                        for (auto &si : shaders) {
+                                        for (auto &si : out.shaders) {
                                             if (si == info) {
                                                 si.files.insert(filename);
                                                 si.numFiles += 1;
@@ -1142,14 +1164,11 @@ public:
                                             info.files.insert(filename);
                                             info.numFiles = 1;
                                             info.Update(false);
-                                            shaders.push_back(info);
+                                            out.shaders.push_back(info);
                                         }
                                     }
                                     else {
-                                        if (!notFoundShaders.contains(shaderName)) {
-                                            Error("Shader not found: " + shaderName);
-                                            notFoundShaders.insert(shaderName);
-                                        }
+                                        out.notFoundShaders.insert(shaderName);
                                     }
                                 }
                             }
@@ -1162,31 +1181,233 @@ public:
         delete[] fileData.first;
     }
 
+    static void Merge(ScanResult &dst, ScanResult const &src) {
+        for (auto const &info : src.shaders) {
+            bool found = false;
+            for (auto &si : dst.shaders) {
+                if (si == info) {
+                    si.files.insert(info.files.begin(), info.files.end());
+                    si.numFiles += info.numFiles;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+                dst.shaders.push_back(info);
+        }
+        for (auto const &[texName, type] : src.shaderTextures)
+            dst.shaderTextures[texName] |= type;
+        dst.notFoundShaders.insert(src.notFoundShaders.begin(), src.notFoundShaders.end());
+        dst.errors.insert(dst.errors.end(), src.errors.begin(), src.errors.end());
+    }
+
+    static void WriteScanResult(BinaryBuffer &buf, ScanResult const &r) {
+        buf.Put<unsigned int>(r.shaders.size());
+        for (auto const &s : r.shaders) {
+            buf.Put(s.name);
+            buf.Put(s.numTechniques);
+            buf.Put(s.numFiles);
+            buf.Put(s.debugVertexSize);
+            buf.Put(s.samplerArguments);
+            buf.Put<unsigned int>(s.files.size());
+            for (auto const &f : s.files)
+                buf.Put(f);
+            buf.Put<unsigned int>(s.declaration.size());
+            for (auto const &d : s.declaration) {
+                buf.Put<unsigned int>(d.type);
+                buf.Put<unsigned int>(d.usage);
+            }
+            buf.Put<unsigned int>(s.commands.size());
+            for (auto const &c : s.commands) {
+                buf.Put<unsigned int>(c.id);
+                buf.Put<unsigned int>(c.arguments.size());
+                buf.Put(c.arguments.data(), c.arguments.size() * sizeof(int));
+            }
+            buf.Put<unsigned int>(s.globalArguments.size());
+            for (auto const &g : s.globalArguments) {
+                buf.Put(g.type);
+                buf.Put(g.format);
+            }
+        }
+        buf.Put<unsigned int>(r.shaderTextures.size());
+        for (auto const &[texName, type] : r.shaderTextures) {
+            buf.Put(texName);
+            buf.Put(type);
+        }
+        buf.Put<unsigned int>(r.notFoundShaders.size());
+        for (auto const &n : r.notFoundShaders)
+            buf.Put(n);
+        buf.Put<unsigned int>(r.errors.size());
+        for (auto const &e : r.errors)
+            buf.Put(e);
+    }
+
+    static void ReadScanResult(BinaryReader &reader, ScanResult &r) {
+        r.shaders.resize(reader.GetCount());
+        for (auto &s : r.shaders) {
+            s.name = reader.GetString();
+            s.numTechniques = reader.Get<unsigned int>();
+            s.numFiles = reader.Get<unsigned int>();
+            s.debugVertexSize = reader.Get<unsigned int>();
+            reader.Get(s.samplerArguments, sizeof(s.samplerArguments));
+            unsigned int numFiles = reader.GetCount();
+            for (unsigned int f = 0; f < numFiles; f++)
+                s.files.insert(reader.GetString());
+            s.declaration.resize(reader.GetCount());
+            for (auto &d : s.declaration) {
+                d.type = Shader::DataType(reader.Get<unsigned int>());
+                d.usage = Shader::DataUsage(reader.Get<unsigned int>());
+            }
+            unsigned int numCommands = reader.GetCount();
+            for (unsigned int c = 0; c < numCommands; c++) {
+                unsigned int id = reader.Get<unsigned int>();
+                vector<int> args(reader.GetCount());
+                reader.Get(args.data(), args.size() * sizeof(int));
+                s.commands.emplace_back(unsigned char(id), args);
+            }
+            unsigned int numGlobalArguments = reader.GetCount();
+            for (unsigned int g = 0; g < numGlobalArguments; g++) {
+                unsigned int type = reader.Get<unsigned int>();
+                s.globalArguments.emplace_back(type, reader.GetString());
+            }
+            s.Update(false);
+        }
+        unsigned int numTextures = reader.GetCount();
+        for (unsigned int t = 0; t < numTextures; t++) {
+            string texName = reader.GetString();
+            r.shaderTextures[texName] = reader.Get<unsigned int>();
+        }
+        unsigned int numNotFound = reader.GetCount();
+        for (unsigned int n = 0; n < numNotFound; n++)
+            r.notFoundShaders.insert(reader.GetString());
+        r.errors.resize(reader.GetCount());
+        for (auto &e : r.errors)
+            e = reader.GetString();
+    }
+
+    static long long FileTime(directory_entry const &entry) {
+        return entry.last_write_time().time_since_epoch().count();
+    }
+
+    // cache is dropped as a whole when eaglrm.o (which defines the shader layouts) changes
+    static map<string, CachedScan> LoadCache(path const &cachePath, CachedScan const &eaglrmKey) {
+        map<string, CachedScan> cache;
+        BinaryReader reader;
+        if (!exists(cachePath) || !reader.Open(cachePath))
+            return cache;
+        if (reader.Get<unsigned int>() != CACHE_SIGNATURE || reader.Get<unsigned int>() != CACHE_VERSION)
+            return cache;
+        if (reader.Get<unsigned long long>() != eaglrmKey.fileSize || reader.Get<long long>() != eaglrmKey.fileTime)
+            return cache;
+        unsigned int numEntries = reader.GetCount();
+        for (unsigned int e = 0; e < numEntries && !reader.Failed(); e++) {
+            string filePath = reader.GetString();
+            CachedScan entry;
+            entry.fileSize = reader.Get<unsigned long long>();
+            entry.fileTime = reader.Get<long long>();
+            ReadScanResult(reader, entry.result);
+            if (!reader.Failed())
+                cache[filePath] = move(entry);
+        }
+        if (reader.Failed() || !reader.AtEnd())
+            cache.clear();
+        return cache;
+    }
+
+    static void SaveCache(path const &cachePath, CachedScan const &eaglrmKey, vector<pair<string, CachedScan const *>> const &entries) {
+        BinaryBuffer buf;
+        buf.Put(CACHE_SIGNATURE);
+        buf.Put(CACHE_VERSION);
+        buf.Put(eaglrmKey.fileSize);
+        buf.Put(eaglrmKey.fileTime);
+        buf.Put<unsigned int>(entries.size());
+        for (auto const &[filePath, entry] : entries) {
+            buf.Put(filePath);
+            buf.Put(entry->fileSize);
+            buf.Put(entry->fileTime);
+            WriteScanResult(buf, entry->result);
+        }
+        buf.WriteToFile(cachePath);
+    }
+
     void dump(path const &inPath) {
-        cout << "Scanning folders for eaglrm.o" << endl;
-        bool eaglrmFound = false;
+        cout << "Scanning folders for .o files" << endl;
+        path eaglrmPath;
+        CachedScan eaglrmKey;
+        vector<pair<path, CachedScan>> files;
         for (auto const &i : recursive_directory_iterator(inPath)) {
+            if (!i.is_regular_file())
+                continue;
             auto const &p = i.path();
-            if (is_regular_file(p) && p.filename() == "eaglrm.o") {
-                cout << "Found eaglrm.o" << endl;
-                get_o_info(p, true);
-                eaglrmFound = true;
-                break;
+            if (p.filename() == "eaglrm.o") {
+                if (eaglrmPath.empty()) {
+                    eaglrmPath = p;
+                    eaglrmKey.fileSize = i.file_size();
+                    eaglrmKey.fileTime = FileTime(i);
+                }
+            }
+            else {
+                string ext = ToLower(p.extension().string());
+                if (ext == ".o" || ext == ".ord") {
+                    CachedScan key;
+                    key.fileSize = i.file_size();
+                    key.fileTime = FileTime(i);
+                    files.emplace_back(p, move(key));
+                }
             }
         }
-        if (eaglrmFound) {
-            cout << "Scanning folders for .o files" << endl;
-            for (auto const &i : recursive_directory_iterator(inPath)) {
-                auto const &p = i.path();
-                if (is_regular_file(p) && (ToLower(p.extension().string()) == ".o" || ToLower(p.extension().string()) == ".ord") && p.filename() != "eaglrm.o") {
+        if (!eaglrmPath.empty()) {
+            cout << "Found eaglrm.o" << endl;
+            ScanResult eaglrmResult;
+            get_o_info(eaglrmPath, eaglrmResult, true);
+            // merge order must not depend on directory enumeration order
+            sort(files.begin(), files.end(), [](pair<path, CachedScan> const &a, pair<path, CachedScan> const &b) {
+                return a.first < b.first;
+            });
+            path cachePath = "shaders_" + inPath.filename().string() + ".cache";
+            auto cache = LoadCache(cachePath, eaglrmKey);
+            vector<unsigned int> filesToScan;
+            for (unsigned int f = 0; f < files.size(); f++) {
+                auto it = cache.find(files[f].first.string());
+                if (it != cache.end() && (*it).second.fileSize == files[f].second.fileSize && (*it).second.fileTime == files[f].second.fileTime)
+                    files[f].second.result = move((*it).second.result);
+                else
+                    filesToScan.push_back(f);
+            }
+            cout << "Reading " << filesToScan.size() << " of " << files.size() << " files (" << (files.size() - filesToScan.size()) << " cached)" << endl;
+            atomic<unsigned int> nextFile = 0;
+            auto ScanFiles = [&] {
+                for (unsigned int n = nextFile++; n < filesToScan.size(); n = nextFile++) {
+                    auto &file = files[filesToScan[n]];
                     try {
-                        get_o_info(p, false);
+                        get_o_info(file.first, file.second.result, false);
                     }
-                    catch (exception e) {
-                        Error("Unable to get info from model %s", p.string().c_str());
+                    catch (exception &) {
+                        file.second.result = ScanResult();
+                        file.second.result.errors.push_back("Unable to get info from model " + file.first.string());
                     }
                 }
+            };
+            unsigned int numThreads = min(max(thread::hardware_concurrency(), 1u), max(unsigned int(filesToScan.size()), 1u));
+            vector<thread> threads;
+            for (unsigned int t = 1; t < numThreads; t++)
+                threads.emplace_back(ScanFiles);
+            ScanFiles();
+            for (auto &t : threads)
+                t.join();
+            ScanResult merged;
+            vector<pair<string, CachedScan const *>> cacheEntries;
+            for (auto const &[filePath, scan] : files) {
+                Merge(merged, scan.result);
+                cacheEntries.emplace_back(filePath.string(), &scan);
             }
+            SaveCache(cachePath, eaglrmKey, cacheEntries);
+            for (auto const &e : merged.errors)
+                Error(e);
+            for (auto const &shaderName : merged.notFoundShaders)
+                Error("Shader not found: " + shaderName);
+            shaders = move(merged.shaders);
+            shaderTextures = move(merged.shaderTextures);
             string targetName = "shaders_" + inPath.filename().string();
             string targetFileName = targetName + ".txt";
             cout << "Writing to " << targetFileName << endl;
@@ -1,7 +1,13 @@
 #include "main.h"
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include "binbuf.h"
 #include "jsonwriter.h"
+#include "stadfiles.h"
+#include "vertexcodec.h"
+#include "bounds.h"
+#include "meshjoin.h"
 #include <assimp\scene.h>
 #include "srgb/SrgbTransform.hpp"
 #include <assimp\Importer.hpp>
@@ -27,7 +33,7 @@ class exporter {
     struct BBOX { Vector3 min, max; };
 
     struct Model {
-        void *mModifiableData;
+        Ptr32<void> mModifiableData;
         unsigned int mNumModifiableDatas;
         unsigned int mNumVariations;
         Matrix4x4 mTransform;
@@ -37,18 +43,18 @@ class exporter {
         Vector4 mBoundMax;
         Vector4 mCenter;
         unsigned int mNumLayers;
-        char const **mLayerNames;
+        Ptr32<Ptr32<char const>> mLayerNames;
         unsigned int field_A4;
-        Model *field_A8;
-        Model *field_AC;
-        Model *mNext;
-        char const *mName;
-        void *pInterleavedVertices;
-        void *mTextures;
+        Ptr32<Model> field_A8;
+        Ptr32<Model> field_AC;
+        Ptr32<Model> mNext;
+        Ptr32<char const> mName;
+        Ptr32<void> pInterleavedVertices;
+        Ptr32<void> mTextures;
         unsigned int mVariationID;
-        void *mLayersStates;
+        Ptr32<void> mLayersStates;
         unsigned int mIsRenderable;
-        void *mLayers;
+        Ptr32<void> mLayers;
         unsigned int field_D0;
         unsigned int field_D4;
         unsigned int mSkeletonVersion;
@@ -56,19 +62,19 @@ class exporter {
     };
 
     struct RenderMethod {
-        unsigned char *mCodeBlock;
-        unsigned char **mCodeToUse;
-        void *mMicroCode;
-        void *mETTObject;
-        RenderMethod *mNext;
-        char const **mpParameterNames;
+        Ptr32<unsigned char> mCodeBlock;
+        Ptr32<Ptr32<unsigned char>> mCodeToUse;
+        Ptr32<void> mMicroCode;
+        Ptr32<void> mETTObject;
+        Ptr32<RenderMethod> mNext;
+        Ptr32<Ptr32<char const>> mpParameterNames;
         unsigned int field_18;
         int field_1C;
-        RenderMethod *mParent;
-        void *mGeoPrimDataBuffer;
+        Ptr32<RenderMethod> mParent;
+        Ptr32<void> mGeoPrimDataBuffer;
         int mCurrentTechnique;
-        char const *mShaderName;
-        void *mEAGLModel;
+        Ptr32<char const> mShaderName;
+        Ptr32<void> mEAGLModel;
     };
 
     struct GeometryInfo {
@@ -98,7 +104,7 @@ class exporter {
         unsigned short unknown1;
         unsigned int mSignature2;
         unsigned int mNumBones;
-        void *unknown2;
+        Ptr32<void> unknown2;
     };
 
     struct Buffer {
@@ -238,6 +244,95 @@ class exporter {
         vector<unsigned short> edgeIndexBuffer;
     };
 
+    // parsed -skeleton file; shared read-only by all exports that use the same file
+    struct SkeletonFile {
+        unique_ptr<unsigned char[]> fileData;
+        Skeleton *skeleton = nullptr;
+        vector<Bone *> bones;
+        vector<string> boneNames;
+        vector<Matrix4x4> inverseBindMatrices;
+    };
+
+    static shared_ptr<SkeletonFile const> parse_skeleton_file(path const &skeletonPath) {
+        auto skelFile = readofile(skeletonPath);
+        if (!skelFile.first)
+            return nullptr;
+        auto result = make_shared<SkeletonFile>();
+        result->fileData.reset(skelFile.first);
+        unsigned char *skel_data = nullptr;
+        Elf32_Sym *skel_symbolsData = nullptr;
+        unsigned int skel_numSymbols = 0;
+        char *skel_symbolNames = nullptr;
+        unsigned int skel_dataIndex = 0;
+
+        Elf32_Ehdr *skel_h = (Elf32_Ehdr *)skelFile.first;
+        Elf32_Shdr *skel_s = At<Elf32_Shdr>(skel_h, skel_h->e_shoff);
+        for (unsigned int i = 0; i < skel_h->e_shnum; i++) {
+            if (skel_s[i].sh_size > 0) {
+                if (skel_s[i].sh_type == 1 && !skel_data) {
+                    skel_data = At<unsigned char>(skel_h, skel_s[i].sh_offset);
+                    skel_dataIndex = i;
+                }
+                else if (skel_s[i].sh_type == 2) {
+                    skel_symbolsData = At<Elf32_Sym>(skel_h, skel_s[i].sh_offset);
+                    skel_numSymbols = skel_s[i].sh_size / 16;
+                }
+                else if (skel_s[i].sh_type == 3)
+                    skel_symbolNames = At<char>(skel_h, skel_s[i].sh_offset);
+            }
+        }
+        if (!skel_data || !skel_symbolNames)
+            return result;
+
+        for (unsigned int i = 0; i < skel_numSymbols; i++) {
+            auto const &sym = skel_symbolsData[i];
+            if ((sym.st_info & 0xF) == 0 || sym.st_shndx != skel_dataIndex)
+                continue;
+            string_view name = &skel_symbolNames[sym.st_name];
+            if (name.starts_with("__Bone:::")) {
+                result->bones.push_back(At<Bone>(skel_data, sym.st_value));
+                string boneName = string(name.substr(9));
+                auto dotPos = boneName.find_last_of('.');
+                if (dotPos != string::npos)
+                    boneName = boneName.substr(dotPos + 1);
+                result->boneNames.push_back(boneName);
+            }
+            else if (name.starts_with("__Skeleton:::")) {
+                if (!result->skeleton)
+                    result->skeleton = At<Skeleton>(skel_data, sym.st_value);
+            }
+        }
+        if (result->skeleton && result->skeleton->mNumBones == result->bones.size()) {
+            result->inverseBindMatrices.resize(result->bones.size());
+            for (unsigned int m = 0; m < result->bones.size(); m++)
+                result->inverseBindMatrices[m] = *At<Matrix4x4>(result->skeleton, 0x10 + 0x30 + sizeof(BoneState) * m);
+        }
+        return result;
+    }
+
+    // skeletons are cached by canonical path and modification time, so a folder of models sharing one skeleton parses it once
+    static shared_ptr<SkeletonFile const> load_skeleton_file(path const &skeletonPath) {
+        struct CacheEntry {
+            file_time_type time;
+            shared_ptr<SkeletonFile const> skeleton;
+        };
+        static map<path, CacheEntry> cache;
+        static mutex cacheMutex;
+        error_code ec;
+        path key = weakly_canonical(skeletonPath, ec);
+        if (ec)
+            key = absolute(skeletonPath);
+        auto time = last_write_time(key, ec);
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = cache.find(key);
+        if (it != cache.end() && (*it).second.time == time)
+            return (*it).second.skeleton;
+        auto &entry = cache[key];
+        entry.time = time;
+        entry.skeleton = parse_skeleton_file(key);
+        return entry.skeleton;
+    }
+
     template<typename T>
     static void convert_index_buffer_trilist(void *src_ib, void *dst_ib, unsigned int numIndices, unsigned int &indexCounter) {
         T *src = (T *)src_ib;
@@ -295,6 +390,8 @@ public:
         char *symbolNames = nullptr;
         unsigned int symbolNamesSize = 0;
         unsigned int dataIndex = 0;
+        // welded here for every target, the other formats are converted from this glTF
+        bool weldVertices = !options().noMeshJoin && (options().weld || options().targetFormat != "gltf");
         
         Elf32_Ehdr *h = (Elf32_Ehdr *)fileData;
         if (h->e_ident[0] != 0x7F || h->e_ident[1] != 'E' || h->e_ident[2] != 'L' || h->e_ident[3] != 'F')
@@ -352,96 +449,26 @@ public:
                 symbolRelocations[rel[i].r_offset] = symbols[rel[i].r_info_sym];
         }
         
-        // do relocations
+        // register relocations
         
+        RelocView view(data, dataSize);
         for (unsigned int i = 0; i < numRelocations; i++) {
             auto symbolId = rel[i].r_info_sym;
             if (symbolId < numSymbols && isSymbolDataPresent(symbols[symbolId]))
-                SetAt(data, rel[i].r_offset, &data[GetAt<unsigned int>(data, rel[i].r_offset)]);
+                view.AddRelocation(rel[i].r_offset);
         }
 
-        unsigned char *skeletonFileData = nullptr;
-        vector<FileSymbol> skelSymbols;
-        unsigned char *skel_data = nullptr;
+        shared_ptr<SkeletonFile const> skeletonFile;
 
         path skeletonPath = options().skeleton;
         if (!skeletonPath.empty()) {
             if (!exists(skeletonPath) && !skeletonPath.is_absolute())
                 skeletonPath = outDir / skeletonPath;
-            if (exists(skeletonPath)) {
-                auto skelFile = readofile(skeletonPath);
-                if (skelFile.first) {
-                    skeletonFileData = skelFile.first;
-                    unsigned int skel_dataSize = 0;
-                    Elf32_Sym *skel_symbolsData = nullptr;
-                    unsigned int skel_numSymbols = 0;
-                    Elf32_Rel *skel_rel = nullptr;
-                    unsigned int skel_numRelocations = 0;
-                    char *skel_symbolNames = nullptr;
-                    unsigned int skel_symbolNamesSize = 0;
-                    unsigned int skel_dataIndex = 0;
-
-                    Elf32_Ehdr *skel_h = (Elf32_Ehdr *)skeletonFileData;
-                    Elf32_Shdr *skel_s = At<Elf32_Shdr>(skel_h, skel_h->e_shoff);
-                    for (unsigned int i = 0; i < skel_h->e_shnum; i++) {
-                        if (skel_s[i].sh_size > 0) {
-                            if (skel_s[i].sh_type == 1 && !skel_data) {
-                                skel_data = At<unsigned char>(skel_h, skel_s[i].sh_offset);
-                                skel_dataSize = skel_s[i].sh_size;
-                                skel_dataIndex = i;
-                            }
-                            else if (skel_s[i].sh_type == 2) {
-                                skel_symbolsData = At<Elf32_Sym>(skel_h, skel_s[i].sh_offset);
-                                skel_numSymbols = skel_s[i].sh_size / 16;
-                            }
-                            else if (skel_s[i].sh_type == 3) {
-                                skel_symbolNames = At<char>(skel_h, skel_s[i].sh_offset);
-                                skel_symbolNamesSize = skel_s[i].sh_size;
-                            }
-                            else if (skel_s[i].sh_type == 9) {
-                                skel_rel = At<Elf32_Rel>(skel_h, skel_s[i].sh_offset);
-                                skel_numRelocations = skel_s[i].sh_size / 8;
-                            }
-                        }
-                    }
-
-                    // get symbols
-
-                    skelSymbols.resize(skel_numSymbols);
-
-                    for (unsigned int i = 0; i < skel_numSymbols; i++) {
-                        skelSymbols[i].st_info = skel_symbolsData[i].st_info;
-                        skelSymbols[i].st_name = skel_symbolsData[i].st_name;
-                        skelSymbols[i].st_other = skel_symbolsData[i].st_other;
-                        skelSymbols[i].st_shndx = skel_symbolsData[i].st_shndx;
-                        skelSymbols[i].st_size = skel_symbolsData[i].st_size;
-                        skelSymbols[i].st_value = skel_symbolsData[i].st_value;
-                        skelSymbols[i].name = &skel_symbolNames[skel_symbolsData[i].st_name];
-                        skelSymbols[i].id = i;
-                    }
-
-                    auto skel_isSymbolDataPresent = [&](FileSymbol const &s) {
-                        return (s.st_info & 0xF) != 0 && s.st_shndx == skel_dataIndex;
-                    };
-
-                    // get relocation symbols
-
-                    map<unsigned int, FileSymbol> skel_symbolRelocations;
-
-                    for (unsigned int i = 0; i < skel_numRelocations; i++) {
-                        if (skel_rel[i].r_info_sym < skelSymbols.size())
-                            skel_symbolRelocations[skel_rel[i].r_offset] = skelSymbols[skel_rel[i].r_info_sym];
-                    }
-
-                    // do relocations
-
-                    for (unsigned int i = 0; i < skel_numRelocations; i++) {
-                        auto skel_symbolId = skel_rel[i].r_info_sym;
-                        if (skel_symbolId < skel_numSymbols && skel_isSymbolDataPresent(skelSymbols[skel_symbolId]))
-                            SetAt(skel_data, skel_rel[i].r_offset, &skel_data[GetAt<unsigned int>(skel_data, skel_rel[i].r_offset)]);
-                    }
-                }
-            }
+            globalVars().dependencies.push_back(skeletonPath);
+            if (ToLower(skeletonPath.extension().string()) == ".ord")
+                globalVars().dependencies.push_back(path(skeletonPath).replace_extension(".orl"));
+            if (exists(skeletonPath))
+                skeletonFile = load_skeleton_file(skeletonPath);
         }
 
         // find model
@@ -462,6 +489,7 @@ public:
         vector<Buffer> colBuffers;
         vector<CollisionGeometry> colGeometries;
         vector<vector<unsigned char>> convertedIBs;
+        vector<vector<unsigned char>> convertedVBs;
 
         for (auto const &s : symbols) {
             if (isSymbolDataPresent(s)) {
@@ -472,7 +500,7 @@ public:
                 else if (s.name.starts_with("__geoprimdatabuffer"))
                     geoPrimDataBuffers.push_back(At<void>(data, s.st_value));
                 else if (s.name.starts_with("__Bone:::")) {
-                    if (!skeletonFileData) {
+                    if (!skeletonFile) {
                         bones.push_back(At<Bone>(data, s.st_value));
                         string boneName = s.name.substr(9);
                         auto dotPos = boneName.find_last_of('.');
@@ -482,7 +510,7 @@ public:
                     }
                 }
                 else if (s.name.starts_with("__Skeleton:::")) {
-                    if (!skeletonFileData) {
+                    if (!skeletonFile) {
                         if (!skeleton)
                             skeleton = At<Skeleton>(data, s.st_value);
                     }
@@ -490,23 +518,10 @@ public:
             }
         }
 
-        if (skeletonFileData) {
-            for (auto const &s : skelSymbols) {
-                if (isSymbolDataPresent(s)) {
-                    if (s.name.starts_with("__Bone:::")) {
-                        bones.push_back(At<Bone>(skel_data, s.st_value));
-                        string boneName = s.name.substr(9);
-                        auto dotPos = boneName.find_last_of('.');
-                        if (dotPos != string::npos)
-                            boneName = boneName.substr(dotPos + 1);
-                        boneNames.push_back(boneName);
-                    }
-                    else if (s.name.starts_with("__Skeleton:::")) {
-                        if (!skeleton)
-                            skeleton = At<Skeleton>(skel_data, s.st_value);
-                    }
-                }
-            }
+        if (skeletonFile) {
+            skeleton = skeletonFile->skeleton;
+            bones = skeletonFile->bones;
+            boneNames = skeletonFile->boneNames;
         }
 
         // TODO: validate skeleton
@@ -551,157 +566,81 @@ public:
                 auto originalFolder = originalFilePath.parent_path();
                 // flags
                 path stadFlagsPath = originalFolder / (stadType == STAD_DEFAULT ? Format("sle-%d-%d.loc", stadiumId, lightingId) : Format("flags_%d.loc", lightingId));
-                if (exists(stadFlagsPath)) {
-                    std::ifstream input(stadFlagsPath);
-                    if (input.is_open()) {
-                        hasFlags = true;
-                        for (std::string line; getline(input, line); ) {
-                            if (!line.empty()) {
-                                float a = 0.0f; float b = 0.0f; float c = 0.0f; int d = 0; float e = 0.0f; float f = 0.0f; float g = 0.0f;
-                                auto numParams = sscanf(line.c_str(), "%f %f %f %d %f %f %f", &a, &b, &c, &d, &e, &f, &g);
-                                bool isLineValid = false;
-                                if (numParams == 7)
-                                    isLineValid = true;
-                                else if (numParams == 3) {
-                                    d = 0;
-                                    e = 1.0f;
-                                    f = 1.0f;
-                                    g = 1.0f;
-                                    isLineValid = true;
-                                }
-                                if (isLineValid) {
-                                    Prop p;
-                                    p.pos.x = a * 100.0f; p.pos.y = b * 100.0f; p.pos.z = c * 100.0f; p.type = d; p.dir.x = e; p.dir.y = f; p.dir.z = g;
-                                    p.name = "Flag_" + to_string(flags.size() + 1);
-                                    if (d != 0)
-                                        p.name += " [type:" + to_string(d) + "]";
-                                    flags.push_back(p);
-                                }
-                            }
-                        }
+                globalVars().dependencies.push_back(stadFlagsPath);
+                vector<StadiumFlag> stadFlags;
+                if (exists(stadFlagsPath) && ReadStadiumFlags(stadFlagsPath, stadFlags)) {
+                    hasFlags = true;
+                    for (auto const &f : stadFlags) {
+                        Prop p;
+                        p.pos.x = f.pos[0] * 100.0f; p.pos.y = f.pos[1] * 100.0f; p.pos.z = f.pos[2] * 100.0f; p.type = f.type; p.dir.x = f.dir[0]; p.dir.y = f.dir[1]; p.dir.z = f.dir[2];
+                        p.name = "Flag_" + to_string(flags.size() + 1);
+                        if (f.type != 0)
+                            p.name += " [type:" + to_string(f.type) + "]";
+                        flags.push_back(p);
                     }
                 }
 
                 // effects
                 path stadLightsPath = originalFolder / (stadType == STAD_DEFAULT ? Format("tag-%d-%d.loc", stadiumId, lightingId) : Format("lights_%d.loc", lightingId));
-                if (exists(stadLightsPath)) {
-                    std::ifstream input(stadLightsPath);
-                    if (input.is_open()) {
-                        bool applyScaling = globalVars().target->Name() == "FM06" || globalVars().target->Name() == "FM13";
-                        hasEffects = true;
-                        for (std::string line; getline(input, line); ) {
-                            unsigned int numEffectTypes;
-                            if (sscanf(line.c_str(), "%d", &numEffectTypes) == 1 && numEffectTypes > 0) {
-                                map<string, size_t> effectTypes;
-                                for (unsigned int i = 0; i < numEffectTypes; i++) {
-                                    if (!getline(input, line))
-                                        break;
-                                    char effectType[32];
-                                    unsigned int numEffects = 0;
-                                    if (sscanf(line.c_str(), "%s %d", effectType, &numEffects) == 2 && effectType[0] && numEffects > 0) {
-                                        bool hasPosition = strstr(line.c_str(), "Position");
-                                        bool hasDirection = strstr(line.c_str(), "Direction");
-                                        bool eof = false;
-                                        unsigned int effectId = 1;
-                                        for (unsigned int e = 0; e < numEffects; e++) {
-                                            if (input.eof())
-                                                break;
-                                            getline(input, line);
-                                            Prop p;
-                                            if (hasPosition) {
-                                                if (hasDirection) {
-                                                    if (sscanf(line.c_str(), "%f %f %f %f %f %f", &p.pos.x, &p.pos.y, &p.pos.z, &p.dir.x, &p.dir.y, &p.dir.z) != 6)
-                                                        break;
-                                                    p.name = string(effectType) + "_" + to_string(++effectTypes[effectType]);
-                                                    if (p.dir.x == 0.0f && p.dir.y == 0.0f && p.dir.z == 0.0f) {
-                                                        p.name += " [dir:null]";
-                                                        p.type = 3;
-                                                    }
-                                                    else {
-                                                        p.name += " [dir]";
-                                                        p.type = 2;
-                                                    }
-                                                }
-                                                else {
-                                                    if (sscanf(line.c_str(), "%f %f %f", &p.pos.x, &p.pos.y, &p.pos.z) != 3)
-                                                        break;
-                                                    p.type = 1;
-                                                    p.name = string(effectType) + "_" + to_string(++effectTypes[effectType]);
-                                                }
-                                                if (applyScaling) {
-                                                    p.pos.x *= 1.12f;
-                                                    p.pos.y *= 1.12f;
-                                                    p.pos.z *= 1.12f;
-                                                }
-                                                effects.push_back(p);
-                                            }
-                                        }
-                                        if (eof)
-                                            break;
-                                    }
+                globalVars().dependencies.push_back(stadLightsPath);
+                vector<StadiumEffectGroup> stadEffects;
+                if (exists(stadLightsPath) && ReadStadiumEffects(stadLightsPath, stadEffects)) {
+                    bool applyScaling = globalVars().target->Name() == "FM06" || globalVars().target->Name() == "FM13";
+                    hasEffects = true;
+                    map<string, size_t> effectTypes; // effect numbers restart in each block of the file
+                    unsigned int effectTypesBlock = 0;
+                    for (auto const &g : stadEffects) {
+                        if (g.block != effectTypesBlock) {
+                            effectTypes.clear();
+                            effectTypesBlock = g.block;
+                        }
+                        unsigned int numGroupEffects = g.positions.size() / 3;
+                        for (unsigned int e = 0; e < numGroupEffects; e++) {
+                            Prop p;
+                            p.pos.x = g.positions[e * 3 + 0]; p.pos.y = g.positions[e * 3 + 1]; p.pos.z = g.positions[e * 3 + 2];
+                            p.name = g.type + "_" + to_string(++effectTypes[g.type]);
+                            if (g.hasDirection) {
+                                p.dir.x = g.directions[e * 3 + 0]; p.dir.y = g.directions[e * 3 + 1]; p.dir.z = g.directions[e * 3 + 2];
+                                if (p.dir.x == 0.0f && p.dir.y == 0.0f && p.dir.z == 0.0f) {
+                                    p.name += " [dir:null]";
+                                    p.type = 3;
                                 }
+                                else {
+                                    p.name += " [dir]";
+                                    p.type = 2;
+                                }
+                            }
+                            else
+                                p.type = 1;
+                            if (applyScaling) {
+                                p.pos.x *= 1.12f;
+                                p.pos.y *= 1.12f;
+                                p.pos.z *= 1.12f;
                             }
+                            effects.push_back(p);
                         }
                     }
                 }
 
                 // collision
                 path stadCollPath = originalFolder / (stadType == STAD_DEFAULT ? Format("coll-%d-%d.bin", stadiumId, lightingId) : Format("collision_%d.bin", lightingId));
-                if (exists(stadCollPath)) {
-                    FILE *collFile = nullptr;
-                    _wfopen_s(&collFile, stadCollPath.c_str(), L"rb");
-                    if (collFile) {
-                        bool isFileValid = false;
-                        unsigned int collHeader[3] = { 0, 0, 0 };
-                        if (fread(collHeader, 4, 3, collFile) == 3 && collHeader[0] == 2) {
-                            isFileValid = true;
-                            colGeometries.resize(collHeader[2]);
-                            for (unsigned int collg = 0; collg < collHeader[2]; collg++) {
-                                if (fseek(collFile, 24, SEEK_CUR) != 0) {
-                                    isFileValid = false;
-                                    break;
-                                }
-                                unsigned short desc[4] = { 0, 0, 0, 0 };
-                                if (fread(desc, 2, 4, collFile) != 4) {
-                                    isFileValid = false;
-                                    break;
-                                }
-                                if (desc[0] > 0) {
-                                    colGeometries[collg].positions.resize(desc[0]);
-                                    if (fread(colGeometries[collg].positions.data(), 12, desc[0], collFile) != desc[0]) {
-                                        isFileValid = false;
-                                        break;
-                                    }
-                                }
-                                if (desc[1] > 0) {
-                                    colGeometries[collg].normals.resize(desc[1]);
-                                    if (fread(colGeometries[collg].normals.data(), 12, desc[1], collFile) != desc[1]) {
-                                        isFileValid = false;
-                                        break;
-                                    }
-                                }
-                                if (desc[2] > 0) {
-                                    colGeometries[collg].triangles.resize(desc[2]);
-                                    if (fread(colGeometries[collg].triangles.data(), 8, desc[2], collFile) != desc[2]) {
-                                        isFileValid = false;
-                                        break;
-                                    }
-                                }
-                                if (desc[3] > 0) {
-                                    colGeometries[collg].edges.resize(desc[3]);
-                                    if (fread(colGeometries[collg].edges.data(), 4, desc[3], collFile) != desc[3]) {
-                                        isFileValid = false;
-                                        break;
-                                    }
-                                }
-                                colGeometries[collg].name = "Collision_" + to_string(collg + 1);
-                            }
-                        }
-                        if (isFileValid)
-                            hasCollision = true;
-                        else
-                            colGeometries.clear();
-                        fclose(collFile);
+                globalVars().dependencies.push_back(stadCollPath);
+                vector<StadiumCollisionGeometry> stadCollision;
+                if (exists(stadCollPath) && ReadStadiumCollision(stadCollPath, stadCollision)) {
+                    hasCollision = true;
+                    colGeometries.resize(stadCollision.size());
+                    for (unsigned int collg = 0; collg < stadCollision.size(); collg++) {
+                        auto const &src = stadCollision[collg];
+                        auto &dst = colGeometries[collg];
+                        dst.positions.resize(src.positions.size() / 3);
+                        Memory_Copy(dst.positions.data(), src.positions.data(), src.positions.size() * sizeof(float));
+                        dst.normals.resize(src.normals.size() / 3);
+                        Memory_Copy(dst.normals.data(), src.normals.data(), src.normals.size() * sizeof(float));
+                        dst.triangles.resize(src.triangles.size() / 4);
+                        Memory_Copy(dst.triangles.data(), src.triangles.data(), src.triangles.size() * sizeof(unsigned short));
+                        dst.edges.resize(src.edges.size() / 2);
+                        Memory_Copy(dst.edges.data(), src.edges.data(), src.edges.size() * sizeof(unsigned short));
+                        dst.name = "Collision_" + to_string(collg + 1);
                     }
                 }
             }
@@ -714,13 +653,13 @@ public:
         j.writeFieldString("version", "2.0");
         j.closeScope();
         j.writeFieldInt("scene", 0);
-        if ((model && model->mNumLayers && model->mLayers) || skeleton) {
+        if ((model && model->mNumLayers && view.Get(model->mLayers)) || skeleton) {
 
             // scenes
             j.openArray("scenes");
             j.openScope();
-            if (model && model->mName)
-                j.writeFieldString("name", model->mName);
+            if (model && view.Get(model->mName))
+                j.writeFieldString("name", view.Get(model->mName));
             j.openArray("nodes");
             unsigned int numNodes = (model ? model->mNumLayers : 0) + (skeleton ? 1 : 0);
             unsigned int numWrittenNodes = 0;
@@ -743,8 +682,9 @@ public:
                     j.writeFieldInt("mesh", i);
                     if (skeleton)
                         j.writeFieldInt("skin", 0);
-                    if (model->mLayerNames[i])
-                        j.writeFieldString("name", model->mLayerNames[i]);
+                    char const *layerName = view.Get(view.Get(model->mLayerNames)[i]);
+                    if (layerName)
+                        j.writeFieldString("name", layerName);
                     j.closeScope();
                     numWrittenNodes++;
                 }
@@ -954,12 +894,16 @@ public:
                     j.writeFieldInt("inverseBindMatrices", accessors.size());
                     Accessor a;
                     skinMatrices = new Matrix4x4[bones.size()];
-                    for (unsigned int m = 0; m < bones.size(); m++) {
-                        Matrix4x4 *unkMat = At<Matrix4x4>(skeleton, 0x10 + 0x30 + sizeof(BoneState) * m);
-                        //D3DXMatrixInverse(&skinMatrices[m], NULL, unkMat);
-                        //D3DXMATRIX tmpMat;
-                        //D3DXMatrixInverse(&tmpMat, NULL, &skinMatrices[m]);
-                        Memory_Copy(&skinMatrices[m], unkMat, 64);
+                    if (skeletonFile && skeletonFile->inverseBindMatrices.size() == bones.size())
+                        Memory_Copy(skinMatrices, skeletonFile->inverseBindMatrices.data(), bones.size() * sizeof(Matrix4x4));
+                    else {
+                        for (unsigned int m = 0; m < bones.size(); m++) {
+                            Matrix4x4 *unkMat = At<Matrix4x4>(skeleton, 0x10 + 0x30 + sizeof(BoneState) * m);
+                            //D3DXMatrixInverse(&skinMatrices[m], NULL, unkMat);
+                            //D3DXMATRIX tmpMat;
+                            //D3DXMatrixInverse(&tmpMat, NULL, &skinMatrices[m]);
+                            Memory_Copy(&skinMatrices[m], unkMat, 64);
+                        }
                     }
                     a.buffer = buffers.size();
                     a.componentType = 5126;
@@ -995,7 +939,7 @@ public:
             if ((model && model->mNumLayers) || !colGeometries.empty()) {
                 j.openArray("meshes");
                 if ((model && model->mNumLayers)) {
-                    unsigned int *modelLayers = (unsigned int *)(model->mLayers);
+                    unsigned int *modelLayers = (unsigned int *)view.Get(model->mLayers);
                     unsigned int modelLayersHeader = *modelLayers;
                     bool isOldFormat = modelLayersHeader == 0xA0000000;
                     modelLayers++;
@@ -1003,8 +947,9 @@ public:
                         modelLayers += 2;
                     for (unsigned int i = 0; i < model->mNumLayers; i++) {
                         j.openScope();
-                        if (model->mLayerNames[i])
-                            j.writeFieldString("name", model->mLayerNames[i]);
+                        char const *layerName = view.Get(view.Get(model->mLayerNames)[i]);
+                        if (layerName)
+                            j.writeFieldString("name", layerName);
                         j.openArray("primitives");
                         if (isOldFormat)
                             modelLayers += 2;
@@ -1013,10 +958,10 @@ public:
                             numPrimitives /= 2;
                         modelLayers++;
                         for (unsigned int p = 0; p < numPrimitives; p++) {
-                            void *renderDescriptor = GetAt<void *>(modelLayers, isOldFormat ? (p * 8 + 4) : (p * 4));
-                            void *renderMethod = GetAt<void *>(renderDescriptor, 0);
-                            void *globalParameters = At<void *>(renderDescriptor, 4);
-                            GeometryInfo *geometryInfo = GetAt<GeometryInfo *>(globalParameters, 4);
+                            void *renderDescriptor = view.Get<void>(modelLayers, isOldFormat ? (p * 8 + 4) : (p * 4));
+                            void *renderMethod = view.Get<void>(renderDescriptor, 0);
+                            void *globalParameters = At<void>(renderDescriptor, 4);
+                            GeometryInfo *geometryInfo = view.Get<GeometryInfo>(globalParameters, 4);
                             unsigned int rmCodeOffset = At<unsigned char>(renderMethod, 8) - data;
                             void *vertexBuffer = nullptr;
                             string texNameOriginal;
@@ -1047,7 +992,7 @@ public:
                                     if (shaderLowered == "cliptextureaddnodepthwrite" || shaderLowered == "cliptexturealphablend" || shaderLowered.find("transparent") != string::npos)
                                         mat.alphaMode = "BLEND";
                                     shader = globalVars().target->FindShader(shaderName);
-                                    void *renderCode = GetAt<void *>(renderMethod, 0);
+                                    void *renderCode = view.Get<void>(renderMethod, 0);
                                     unsigned int numCommands = 0;
                                     unsigned int commandOffset = 0;
                                     unsigned short id = GetAt<unsigned short>(renderCode, commandOffset + 2);
@@ -1057,14 +1002,14 @@ public:
                                         case 4:
                                         case 75: //TODO
                                             if (!vertexBuffer) {
-                                                vertexBuffer = GetAt<void *>(globalParameters, 4);
+                                                vertexBuffer = view.Get<void>(globalParameters, 4);
                                                 numVertices = GetAt<unsigned int>(globalParameters, 0);
                                                 vertexSize = GetAt<unsigned int>(renderCode, commandOffset + 8);
                                             }
                                             break;
                                         case 7:
                                             if (!indexBuffer) {
-                                                indexBuffer = GetAt<void *>(globalParameters, 4);
+                                                indexBuffer = view.Get<void>(globalParameters, 4);
                                                 numIndices = GetAt<unsigned int>(globalParameters, 0); // GetAt<unsigned int>(renderCode, commandOffset + 20) - 1;
                                                 indexSize = GetAt<unsigned int>(renderCode, commandOffset + 4);
                                             }
@@ -1072,11 +1017,11 @@ public:
                                         case 28:
                                             if (!skinVertexDataBuffer) {
                                                 numSkinVertexInfos = GetAt<unsigned int>(globalParameters, 0);
-                                                skinVertexDataBuffer = GetAt<VertexSkinDataPacked *>(globalParameters, 4);
+                                                skinVertexDataBuffer = view.Get<VertexSkinDataPacked>(globalParameters, 4);
                                             }
                                             break;
                                         case 33:
-                                            geoPrimState = GetAt<GeoPrimState *>(globalParameters, 4);
+                                            geoPrimState = view.Get<GeoPrimState>(globalParameters, 4);
                                             if (geoPrimState) {
                                                 if (geoPrimState->nPrimitiveType == 1)
                                                     geoPrimMode = 0;
@@ -1094,7 +1039,7 @@ public:
                                                     mat.doubleSided = false;
                                             }
                                             else {
-                                                it = symbolRelocations.find(unsigned int(At<GeoPrimState *>(globalParameters, 4)) - unsigned int(data));
+                                                it = symbolRelocations.find(view.OffsetOf(At<void>(globalParameters, 4)));
                                                 if (it != symbolRelocations.end() && (*it).second.st_info == 0x10) {
                                                     string format = (*it).second.name;
                                                     geoprimStateFormat = format;
@@ -1236,7 +1181,7 @@ public:
                                             unsigned int samplerIndex = GetAt<unsigned int>(renderCode, commandOffset + 4);
                                             if (samplerIndex < 4) {
                                                 Texture tex;
-                                                TAR const *tar = GetAt<TAR *>(globalParameters, 4);
+                                                TAR const *tar = view.Get<TAR>(globalParameters, 4);
                                                 FileSymbol const *texSymbol = nullptr;
                                                 string tarAttributes;
                                                 bool isGlobal = false;
@@ -1247,7 +1192,7 @@ public:
                                                     tex.name = texTag;
                                                 }
                                                 else { // global or runtime-constructed texture
-                                                    unsigned int tarOffset = unsigned int(At<TAR *>(globalParameters, 4)) - unsigned int(data);
+                                                    unsigned int tarOffset = view.OffsetOf(At<void>(globalParameters, 4));
                                                     auto it = symbolRelocations.find(tarOffset);
                                                     if (it != symbolRelocations.end()) {
                                                         auto const &s = (*it).second;
@@ -1468,7 +1413,7 @@ public:
                                         case 12:
                                         case 35:
                                             if (targetName == "NBA2003" || targetName == "NBA2004") {
-                                                it = symbolRelocations.find(unsigned int(At<void *>(globalParameters, 4)) - unsigned int(data));
+                                                it = symbolRelocations.find(view.OffsetOf(At<void>(globalParameters, 4)));
                                                 if (it != symbolRelocations.end() && (*it).second.st_info == 0x10) {
                                                     string format = (*it).second.name;
                                                     if (shaderName == "NBAUniformNumbers_Unlit") {
@@ -1532,7 +1477,7 @@ public:
                                             break;
                                         }
                                         if (numCommands != 0)
-                                            globalParameters = At<void *>(globalParameters, 8);
+                                            globalParameters = At<void>(globalParameters, 8);
                                         numCommands++;
                                         commandOffset += size * 4;
                                         id = GetAt<unsigned short>(renderCode, commandOffset + 2);
@@ -1601,6 +1546,10 @@ public:
                                 }
                             }
                             if (vertexBuffer) {
+                                // attributes are fixed up in place, work on a copy of the section data
+                                unsigned char *vertexData = At<unsigned char>(vertexBuffer, 0);
+                                auto &convertedVB = convertedVBs.emplace_back(vertexData, vertexData + vertexSize * numVertices);
+                                vertexBuffer = convertedVB.data();
                                 if (!shader) {
                                     if (skinVertexDataBuffer)
                                         shader = &DummyShader_Skin;
@@ -1619,6 +1568,8 @@ public:
                                 }
                                 bool uses2Streams = skinVertexDataBuffer && hasBlendIndices && hasBlendWeights;
                                 unsigned int streamNumber = 0;
+                                unsigned int firstAccessor = accessors.size();
+                                vector<WeldFloatRange> weldRanges;
                                 for (auto const &d : shader->declaration) {
                                     switch (d.usage) {
                                     case Shader::Position:
@@ -1683,6 +1634,8 @@ public:
                                         attrOffset += 4;
                                         break;
                                     }
+                                    if (!streamNumber && (d.type == Shader::Float4 || d.type == Shader::Float3 || d.type == Shader::Float2))
+                                        weldRanges.push_back({ a.offset, d.type == Shader::Float4 ? 4u : (d.type == Shader::Float3 ? 3u : 2u) });
                                     a.buffer = buffers.size() + streamNumber;
                                     a.count = numVertices;
                                     a.length = numVertices * (streamNumber ? 20 : vertexSize);
@@ -1691,79 +1644,37 @@ public:
                                     a.normalized = d.usage == Shader::Color0;
                                     if (d.usage == Shader::Position) {
                                         a.usesMinMax = true;
-                                        Vector3 boundMin = { 0.0f, 0.0f, 0.0f };
-                                        Vector3 boundMax = { 0.0f, 0.0f, 0.0f };
-                                        bool anyVertexProcessed = false;
-                                        Vector3 *posn = (Vector3 *)(unsigned int(vertexBuffer) + a.offset);
-                                        //posn->y = -posn->y;
-                                        for (unsigned int vert = 0; vert < numVertices; vert++) {
-                                            if (!anyVertexProcessed) {
-                                                boundMin = *posn;
-                                                boundMax = *posn;
-                                                anyVertexProcessed = true;
-                                            }
-                                            else {
-                                                if (posn->x < boundMin.x)
-                                                    boundMin.x = posn->x;
-                                                if (posn->y < boundMin.y)
-                                                    boundMin.y = posn->y;
-                                                if (posn->z < boundMin.z)
-                                                    boundMin.z = posn->z;
-                                                if (posn->x > boundMax.x)
-                                                    boundMax.x = posn->x;
-                                                if (posn->y > boundMax.y)
-                                                    boundMax.y = posn->y;
-                                                if (posn->z > boundMax.z)
-                                                    boundMax.z = posn->z;
-                                            }
-                                            posn = (Vector3 *)(unsigned int(posn) + a.stride);
-                                        }
-                                        a.min = boundMin;
-                                        a.max = boundMax;
+                                        Bounds bounds;
+                                        bounds.AddBox(At<unsigned char>(vertexBuffer, a.offset), a.stride, numVertices);
+                                        a.min = { bounds.min.x, bounds.min.y, bounds.min.z };
+                                        a.max = { bounds.max.x, bounds.max.y, bounds.max.z };
                                     }
                                     else if (d.usage == Shader::Normal) {
-                                        float *nrm = (float *)(unsigned int(vertexBuffer) + a.offset);
-                                        for (unsigned int vert = 0; vert < numVertices; vert++) {
-                                            //nrm[1] = -nrm[1];
-                                            if (options().flipNormals) {
-                                                nrm[0] = -nrm[0];
-                                                nrm[1] = -nrm[1];
-                                                nrm[2] = -nrm[2];
-                                            }
-                                            nrm = (float *)(unsigned int(nrm) + a.stride);
-                                        }
+                                        if (options().flipNormals)
+                                            DecodeFlipVectors(At<unsigned char>(vertexBuffer, a.offset), a.stride, numVertices);
                                     }
                                     else if (d.usage == Shader::Color0) {
-                                        unsigned char *clr = (unsigned char *)(unsigned int(vertexBuffer) + a.offset);
-                                        for (unsigned int vert = 0; vert < numVertices; vert++) {
-                                            swap(clr[0], clr[2]);
-                                            if (options().srgb) {
-                                                for (unsigned int ci = 0; ci < 3; ci++)
-                                                    clr[ci] = unsigned char(SrgbTransform::srgbToLinear(double(clr[ci]) / 255.0) * 255.0);
-                                            }
-                                            clr = (unsigned char *)(unsigned int(clr) + a.stride);
-                                        }
+                                        DecodeSwapRB(At<unsigned char>(vertexBuffer, a.offset), a.stride, numVertices);
+                                        if (options().srgb)
+                                            SrgbTransform::srgbToLinear8bitStream(At<unsigned char>(vertexBuffer, a.offset), numVertices, a.stride, 3);
                                     }
                                     else if (options().updateOldStadium && d.usage == Shader::Texcoord0) {
                                         if (bannersTex) {
-                                            float *uv = (float *)(unsigned int(vertexBuffer) + a.offset);
-                                            for (unsigned int vert = 0; vert < numVertices; vert++) {
-                                                uv[0] *= 0.25f;
-                                                uv[1] *= 0.25f;
-                                                if (texNameOriginal == "_bnb" || texNameOriginal == "hbnb" || texNameOriginal == "abnb")
-                                                    uv[0] += 0.25f;
-                                                else if (texNameOriginal == "_bnc" || texNameOriginal == "hbnc" || texNameOriginal == "abnc")
-                                                    uv[0] += 0.5f;
-                                                else if (texNameOriginal == "_fla" || texNameOriginal == "hfla" || texNameOriginal == "afla")
-                                                    uv[0] += 0.75f;
-                                                else if (texNameOriginal == "_flb" || texNameOriginal == "hflb" || texNameOriginal == "aflb")
-                                                    uv[1] += 0.25f;
-                                                else if (texNameOriginal == "_flc" || texNameOriginal == "hflc" || texNameOriginal == "aflc") {
-                                                    uv[0] += 0.25f;
-                                                    uv[1] += 0.5f;
-                                                }
-                                                uv = (float *)(unsigned int(uv) + a.stride);
+                                            float offsetU = 0.0f;
+                                            float offsetV = 0.0f;
+                                            if (texNameOriginal == "_bnb" || texNameOriginal == "hbnb" || texNameOriginal == "abnb")
+                                                offsetU = 0.25f;
+                                            else if (texNameOriginal == "_bnc" || texNameOriginal == "hbnc" || texNameOriginal == "abnc")
+                                                offsetU = 0.5f;
+                                            else if (texNameOriginal == "_fla" || texNameOriginal == "hfla" || texNameOriginal == "afla")
+                                                offsetU = 0.75f;
+                                            else if (texNameOriginal == "_flb" || texNameOriginal == "hflb" || texNameOriginal == "aflb")
+                                                offsetV = 0.25f;
+                                            else if (texNameOriginal == "_flc" || texNameOriginal == "hflc" || texNameOriginal == "aflc") {
+                                                offsetU = 0.25f;
+                                                offsetV = 0.5f;
                                             }
+                                            DecodeOffsetTexcoords(At<unsigned char>(vertexBuffer, a.offset), a.stride, numVertices, 0.25f, offsetU, offsetV);
                                         }
                                         else if (texNameOriginal == "adba" || texNameOriginal == "adbb" || texNameOriginal == "adbc") {
                                             vector<pair<float, bool>> uvVertMap(numVertices);
@@ -1789,7 +1700,7 @@ public:
                                                             float *uvData[3] = {};
                                                             float maxV = -99999.0f;
                                                             for (unsigned int uvx = 0; uvx < 3; uvx++) {
-                                                                uvData[uvx] = (float *)(unsigned int(vertexBuffer) + a.offset + a.stride * vertId[uvx]);
+                                                                uvData[uvx] = At<float>(vertexBuffer, a.offset + a.stride * vertId[uvx]);
                                                                 if (uvData[uvx][1] > maxV)
                                                                     maxV = uvData[uvx][1];
                                                             }
@@ -1822,12 +1733,12 @@ public:
                                                     }
                                                 }
                                             }
-                                            float *uv = (float *)(unsigned int(vertexBuffer) + a.offset);
+                                            float *uv = At<float>(vertexBuffer, a.offset);
                                             for (unsigned int vert = 0; vert < numVertices; vert++) {
                                                 if (uvVertMap[vert].second && uvVertMap[vert].first != 0.0f)
                                                     uv[1] += uvVertMap[vert].first;
                                                 uv[1] *= 0.1875f;
-                                                uv = (float *)(unsigned int(uv) + a.stride);
+                                                uv = At<float>(uv, a.stride);
                                             }
                                         }
 
@@ -1835,6 +1746,18 @@ public:
                                     accessors.push_back(a);
                                 }
                                 j.closeScope();
+                                if (weldVertices && indexSize == 2 && numIndices >= 3 && numVertices > 1) {
+                                    unsigned int numWelded = WeldVertices((unsigned char *)vertexBuffer, vertexSize, numVertices,
+                                        (unsigned short *)indexBuffer, numIndices, weldRanges, options().weldEpsilon);
+                                    if (numWelded != numVertices) {
+                                        // bounds stay the same, only the duplicates are gone
+                                        numVertices = numWelded;
+                                        for (unsigned int ai = firstAccessor; ai < accessors.size(); ai++) {
+                                            accessors[ai].count = numVertices;
+                                            accessors[ai].length = numVertices * accessors[ai].stride;
+                                        }
+                                    }
+                                }
                                 Buffer b;
                                 b.data = vertexBuffer;
                                 b.length = vertexSize * numVertices;
@@ -2369,7 +2292,6 @@ public:
         delete[] skinMatrices;
         for (auto const &e : textures)
             delete e.second;
-        delete skeletonFileData;
     }
 
     void convert_o_to_gltf(path const &inPath, path const &outPath, path const &outDir) {
@@ -2383,14 +2305,14 @@ public:
     void convert_gltf_to_format(path const &inPathGltf, path const &outPathFmt) {
         Assimp::Importer importer;
         importer.SetPropertyInteger(AI_CONFIG_IMPORT_REMOVE_EMPTY_BONES, 0);
-        unsigned int flags = aiProcess_PopulateArmatureData;
-        if (!options().noMeshJoin)
-            flags |= aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes;
-        const aiScene *scene = importer.ReadFile(inPathGltf.string(), flags);
-        if (!scene)
+        // vertices were welded by convert_o_to_gltf, meshes are merged with MergeMeshes
+        if (!importer.ReadFile(inPathGltf.string(), aiProcess_PopulateArmatureData))
             throw runtime_error("convert_gltf_to_format: Unable to load scene");
+        unique_ptr<aiScene> scene(importer.GetOrphanedScene());
         if (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)
             throw runtime_error("convert_gltf_to_format: Unable to load a complete scene");
+        if (!options().noMeshJoin)
+            MergeMeshes(scene.get(), 1'000'000);
         Assimp::Exporter exporter;
         string assimpFormat = "gltf";
         if (options().targetFormat == "fbx")
@@ -2411,7 +2333,7 @@ public:
             assimpFormat = "x";
         else if (options().targetFormat == "x3d")
             assimpFormat = "x3d";
-        if (exporter.Export(scene, assimpFormat, outPathFmt.string()) != AI_SUCCESS)
+        if (exporter.Export(scene.get(), assimpFormat, outPathFmt.string()) != AI_SUCCESS)
             throw runtime_error("convert_gltf_to_format: Unable to save a scene");
     }
 
@@ -2472,10 +2394,11 @@ public:
             if (rel[i].r_info_sym < symbols.size())
                 symbolRelocations[rel[i].r_offset] = symbols[rel[i].r_info_sym];
         }
+        RelocView view(data, dataSize);
         for (unsigned int i = 0; i < numRelocations; i++) {
             auto symbolId = rel[i].r_info_sym;
             if (symbolId < numSymbols && isSymbolDataPresent(symbols[symbolId]))
-                SetAt(data, rel[i].r_offset, &data[GetAt<unsigned int>(data, rel[i].r_offset)]);
+                view.AddRelocation(rel[i].r_offset);
         }
         vector<Model *> models;
         for (auto const &s : symbols) {
@@ -2490,8 +2413,8 @@ public:
                 sort(models.begin(), models.end(), [](Model *a, Model *b) { return a->mVariationID <= b->mVariationID; });
             model = models[0];
         }
-        if (model && model->mNumLayers && model->mLayers) {
-            unsigned int *modelLayers = (unsigned int *)(model->mLayers);
+        if (model && model->mNumLayers && view.Get(model->mLayers)) {
+            unsigned int *modelLayers = (unsigned int *)view.Get(model->mLayers);
             unsigned int modelLayersHeader = *modelLayers;
             bool isOldFormat = modelLayersHeader == 0xA0000000;
             modelLayers++;
@@ -2505,10 +2428,10 @@ public:
                     numPrimitives /= 2;
                 modelLayers++;
                 for (unsigned int p = 0; p < numPrimitives; p++) {
-                    void *renderDescriptor = GetAt<void *>(modelLayers, isOldFormat ? (p * 8 + 4) : (p * 4));
-                    void *renderMethod = GetAt<void *>(renderDescriptor, 0);
-                    void *globalParameters = At<void *>(renderDescriptor, 4);
-                    GeometryInfo *geometryInfo = GetAt<GeometryInfo *>(globalParameters, 4);
+                    void *renderDescriptor = view.Get<void>(modelLayers, isOldFormat ? (p * 8 + 4) : (p * 4));
+                    void *renderMethod = view.Get<void>(renderDescriptor, 0);
+                    void *globalParameters = At<void>(renderDescriptor, 4);
+                    GeometryInfo *geometryInfo = view.Get<GeometryInfo>(globalParameters, 4);
                     unsigned int rmCodeOffset = At<unsigned char>(renderMethod, 8) - data;
                     void *vertexBuffer = nullptr;
                     string texName;
@@ -2527,7 +2450,7 @@ public:
                         if (codeName.ends_with("__EAGLMicroCode")) {
                             shaderName = codeName.substr(0, codeName.length() - 15);
                             shader = globalVars().target->FindShader(shaderName);
-                            void *renderCode = GetAt<void *>(renderMethod, 0);
+                            void *renderCode = view.Get<void>(renderMethod, 0);
                             unsigned int numCommands = 0;
                             unsigned int commandOffset = 0;
                             unsigned short id = GetAt<unsigned short>(renderCode, commandOffset + 2);
@@ -2537,20 +2460,20 @@ public:
                                 case 4:
                                 case 75: //TODO
                                     if (!vertexBuffer) {
-                                        vertexBuffer = GetAt<void *>(globalParameters, 4);
+                                        vertexBuffer = view.Get<void>(globalParameters, 4);
                                         numVertices = GetAt<unsigned int>(globalParameters, 0);
                                         vertexSize = GetAt<unsigned int>(renderCode, commandOffset + 8);
                                     }
                                     break;
                                 case 7:
                                     if (!indexBuffer) {
-                                        indexBuffer = GetAt<void *>(globalParameters, 4);
+                                        indexBuffer = view.Get<void>(globalParameters, 4);
                                         numIndices = GetAt<unsigned int>(globalParameters, 0); // GetAt<unsigned int>(renderCode, commandOffset + 20) - 1;
                                         indexSize = GetAt<unsigned int>(renderCode, commandOffset + 4);
                                     }
                                     break;
                                 case 33:
-                                    geoPrimState = GetAt<GeoPrimState *>(globalParameters, 4);
+                                    geoPrimState = view.Get<GeoPrimState>(globalParameters, 4);
                                     if (geoPrimState) {
                                         if (geoPrimState->nPrimitiveType == 1)
                                             geoPrimMode = 0;
@@ -2566,7 +2489,7 @@ public:
                                             geoPrimMode = 6;
                                     }
                                     else {
-                                        it = symbolRelocations.find(unsigned int(At<GeoPrimState *>(globalParameters, 4)) - unsigned int(data));
+                                        it = symbolRelocations.find(view.OffsetOf(At<void>(globalParameters, 4)));
                                         if (it != symbolRelocations.end() && (*it).second.st_info == 0x10) {
                                             string format = (*it).second.name;
                                             auto primTypePos = format.rfind("SetPrimitiveType=");
@@ -2593,7 +2516,7 @@ public:
                                 {
                                     unsigned int samplerIndex = GetAt<unsigned int>(renderCode, commandOffset + 4);
                                     if (samplerIndex == 0) {
-                                        TAR const *tar = GetAt<TAR *>(globalParameters, 4);
+                                        TAR const *tar = view.Get<TAR>(globalParameters, 4);
                                         FileSymbol const *texSymbol = nullptr;
                                         if (tar) { // local texture
                                             char texTag[5];
@@ -2602,7 +2525,7 @@ public:
                                             texName = texTag;
                                         }
                                         else { // global or runtime-constructed texture
-                                            unsigned int tarOffset = unsigned int(At<TAR *>(globalParameters, 4)) - unsigned int(data);
+                                            unsigned int tarOffset = view.OffsetOf(At<void>(globalParameters, 4));
                                             auto it = symbolRelocations.find(tarOffset);
                                             if (it != symbolRelocations.end()) {
                                                 auto const &s = (*it).second;
@@ -2629,7 +2552,7 @@ public:
                                 break;
                                 }
                                 if (numCommands != 0)
-                                    globalParameters = At<void *>(globalParameters, 8);
+                                    globalParameters = At<void>(globalParameters, 8);
                                 numCommands++;
                                 commandOffset += size * 4;
                                 id = GetAt<unsigned short>(renderCode, commandOffset + 2);
@@ -2680,8 +2603,9 @@ public:
                     numIndices = indexCounter;
 
                     if (vertexBuffer) {
-                        if (model->mLayerNames[i])
-                            fprintf(out, "// %s %u\n", model->mLayerNames[i], p + 1);;
+                        char const *layerName = view.Get(view.Get(model->mLayerNames)[i]);
+                        if (layerName)
+                            fprintf(out, "// %s %u\n", layerName, p + 1);
                         fputs("Mesh {\n", out);
                         auto WriteVertexData = [&out](char const *tabs, float *vdata, unsigned int velements, unsigned int vcount,
                             unsigned int vsize, unsigned char *idata, unsigned int icount, unsigned int isize, bool translate)
@@ -2703,7 +2627,7 @@ public:
                                     else
                                         fprintf(out, "%s%.6f; %.6f; %.6f;,\n", tabs, posn.x, posn.y, posn.z);
                                 }
-                                vdata = (float *)((unsigned int)vdata + vsize);
+                                vdata = At<float>(vdata, vsize);
                             }
                             if (idata) {
                                 unsigned int numFaces = icount / 3;
@@ -2747,11 +2671,11 @@ public:
                             else if (d.usage == Shader::BlendIndices || d.usage == Shader::BlendWeight)
                                 break;
                             else if (d.usage == Shader::Position)
-                                positions = (float *)(unsigned int(vertexBuffer) + attrOffset);
+                                positions = At<float>(vertexBuffer, attrOffset);
                             else if (d.usage == Shader::Normal)
-                                normals = (float *)(unsigned int(vertexBuffer) + attrOffset);
+                                normals = At<float>(vertexBuffer, attrOffset);
                             else if (d.usage == Shader::Texcoord0)
-                                texCoords = (float *)(unsigned int(vertexBuffer) + attrOffset);
+                                texCoords = At<float>(vertexBuffer, attrOffset);
                             switch (d.type) {
                             case Shader::Float4:
                                 attrOffset += 16;
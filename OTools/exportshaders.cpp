@@ -172,11 +172,6 @@ namespace shaderexport {
             if (rel[i].r_info_sym < symbols.size())
                 symbolRelocations[rel[i].r_offset] = symbols[rel[i].r_info_sym];
         }
-        for (unsigned int i = 0; i < numRelocations; i++) {
-            auto symbolId = rel[i].r_info_sym;
-            if (symbolId < numSymbols && isSymbolDataPresent(symbols[symbolId]))
-                SetAt(data, rel[i].r_offset, &data[GetAt<unsigned int>(data, rel[i].r_offset)]);
-        }
         for (auto const &s : symbols) {
             if (isSymbolDataPresent(s)) {
                 if (s.name.ends_with("__EAGLMicroCode"))
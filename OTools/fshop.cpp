@@ -52,7 +52,18 @@ void packfsh_pack() {
             fshFinalPath = fshPath.parent_path() / (fshPath.filename().string() + fshExtension);
         else
             fshFinalPath = fshPath / (fshPath.filename().string() + fshExtension);
+        auto manifest = globalVars().manifest;
+        string imagesKey;
+        if (manifest) {
+            for (auto const &[k, img] : fshImages)
+                imagesKey += " " + img.name + "=" + absolute(img.filepath).string();
+            if (manifest->IsUpToDate(fshFinalPath, fshPath, imagesKey))
+                continue;
+        }
+        globalVars().dependencies.clear();
         WriteFsh(fshFinalPath, fshPath, fshImages, nullptr, nullptr);
+        if (manifest)
+            manifest->Record(fshFinalPath, fshPath, globalVars().dependencies, imagesKey);
     }
 }
 
@@ -171,6 +182,8 @@ void WriteFsh(path const &fshFilePath, path const &searchDir, map<string, Textur
                         break;
                 }
             }
+            if (loadingInfo.fileExists)
+                globalVars().dependencies.push_back(loadingInfo.filepath);
             if (loadingInfo.fileData || loadingInfo.data || loadingInfo.fileExists) {
                 auto &image = fsh.AddImage();
                 image.Load(loadingInfo, options().platform, img.format, img.levels, options().fshRescale, options().fshForceAlphaCheck, options().fshPalette);
@@ -0,0 +1,997 @@
+#include "gltfreader.h"
+#include "main.h"
+#include <assimp\postprocess.h>
+#include <assimp\pbrmaterial.h>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <string>
+#include <vector>
+#include <charconv>
+
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+
+const unsigned int GLB_MAGIC = 0x46546C67; // 'glTF'
+const unsigned int GLB_CHUNK_JSON = 0x4E4F534A; // 'JSON'
+const unsigned int GLB_CHUNK_BIN = 0x004E4942; // 'BIN'
+const unsigned int MAX_JSON_DEPTH = 256;
+
+// post-processing steps which are applied here, or which have nothing to do for the geometry accepted by this reader
+const unsigned int SUPPORTED_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_GenUVCoords | aiProcess_SplitLargeMeshes |
+    aiProcess_SortByPType | aiProcess_PopulateArmatureData | aiProcess_FlipWindingOrder | aiProcess_FlipUVs | aiProcess_LimitBoneWeights;
+
+enum ComponentType {
+    COMPONENT_BYTE = 5120,
+    COMPONENT_UNSIGNED_BYTE = 5121,
+    COMPONENT_SHORT = 5122,
+    COMPONENT_UNSIGNED_SHORT = 5123,
+    COMPONENT_UNSIGNED_INT = 5125,
+    COMPONENT_FLOAT = 5126
+};
+
+enum PrimitiveMode {
+    MODE_TRIANGLES = 4,
+    MODE_TRIANGLE_STRIP = 5
+};
+
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object };
+    Type type = Null;
+    bool boolean = false;
+    double number = 0.0;
+    string str;
+    vector<JsonValue> items; // array items or object values
+    vector<string> keys; // object keys, parallel to items
+
+    JsonValue const *Find(char const *key) const {
+        if (type == Object) {
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (keys[i] == key)
+                    return &items[i];
+            }
+        }
+        return nullptr;
+    }
+
+    JsonValue const *FindArray(char const *key) const {
+        auto v = Find(key);
+        return (v && v->type == Array) ? v : nullptr;
+    }
+
+    JsonValue const *FindObject(char const *key) const {
+        auto v = Find(key);
+        return (v && v->type == Object) ? v : nullptr;
+    }
+
+    double GetNumber(char const *key, double defaultValue) const {
+        auto v = Find(key);
+        return (v && v->type == Number) ? v->number : defaultValue;
+    }
+
+    int GetIndex(char const *key) const {
+        auto v = Find(key);
+        return (v && v->type == Number && v->number >= 0 && v->number < INT_MAX) ? int(v->number) : -1;
+    }
+
+    string GetString(char const *key) const {
+        auto v = Find(key);
+        return (v && v->type == String) ? v->str : string();
+    }
+
+    bool GetBool(char const *key, bool defaultValue) const {
+        auto v = Find(key);
+        return (v && v->type == Bool) ? v->boolean : defaultValue;
+    }
+
+    // reads up to 'count' numbers from an array member, returns false if the member is present but malformed
+    bool GetNumbers(char const *key, float *out, size_t count) const {
+        auto v = Find(key);
+        if (!v)
+            return true;
+        if (v->type != Array || v->items.size() != count)
+            return false;
+        for (size_t i = 0; i < count; i++) {
+            if (v->items[i].type != Number)
+                return false;
+            out[i] = float(v->items[i].number);
+        }
+        return true;
+    }
+};
+
+// object at 'index' of an array, null when out of range or not an object
+JsonValue const *ArrayItem(JsonValue const *arr, int index) {
+    if (!arr || index < 0 || size_t(index) >= arr->items.size() || arr->items[index].type != JsonValue::Object)
+        return nullptr;
+    return &arr->items[index];
+}
+
+class JsonParser {
+    char const *mPos;
+    char const *mEnd;
+    unsigned int mDepth = 0;
+
+    void SkipWhitespace() {
+        while (mPos < mEnd && (*mPos == ' ' || *mPos == '\t' || *mPos == '\n' || *mPos == '\r'))
+            mPos++;
+    }
+
+    bool Match(char const *word) {
+        size_t len = strlen(word);
+        if (size_t(mEnd - mPos) < len || memcmp(mPos, word, len))
+            return false;
+        mPos += len;
+        return true;
+    }
+
+    static void AppendUtf8(string &out, unsigned int cp) {
+        if (cp < 0x80)
+            out += char(cp);
+        else if (cp < 0x800) {
+            out += char(0xC0 | (cp >> 6));
+            out += char(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            out += char(0xE0 | (cp >> 12));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        }
+        else {
+            out += char(0xF0 | (cp >> 18));
+            out += char(0x80 | ((cp >> 12) & 0x3F));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool ParseHex4(unsigned int &out) {
+        if (mEnd - mPos < 4)
+            return false;
+        auto result = from_chars(mPos, mPos + 4, out, 16);
+        if (result.ec != errc() || result.ptr != mPos + 4)
+            return false;
+        mPos += 4;
+        return true;
+    }
+
+    bool ParseString(string &out) {
+        mPos++; // '"'
+        out.clear();
+        while (mPos < mEnd) {
+            char c = *mPos++;
+            if (c == '"')
+                return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (mPos >= mEnd)
+                return false;
+            c = *mPos++;
+            switch (c) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned int cp = 0;
+                if (!ParseHex4(cp))
+                    return false;
+                if (cp >= 0xD800 && cp < 0xDC00) {
+                    unsigned int low = 0;
+                    if (!Match("\\u") || !ParseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                        return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool ParseValue(JsonValue &out) {
+        SkipWhitespace();
+        if (mPos >= mEnd)
+            return false;
+        char c = *mPos;
+        if (c == '{') {
+            if (++mDepth > MAX_JSON_DEPTH)
+                return false;
+            mPos++;
+            out.type = JsonValue::Object;
+            SkipWhitespace();
+            if (mPos < mEnd && *mPos == '}') {
+                mPos++;
+                mDepth--;
+                return true;
+            }
+            while (true) {
+                SkipWhitespace();
+                if (mPos >= mEnd || *mPos != '"')
+                    return false;
+                out.keys.emplace_back();
+                if (!ParseString(out.keys.back()))
+                    return false;
+                SkipWhitespace();
+                if (mPos >= mEnd || *mPos++ != ':')
+                    return false;
+                out.items.emplace_back();
+                if (!ParseValue(out.items.back()))
+                    return false;
+                SkipWhitespace();
+                if (mPos >= mEnd)
+                    return false;
+                c = *mPos++;
+                if (c == '}')
+                    break;
+                if (c != ',')
+                    return false;
+            }
+            mDepth--;
+            return true;
+        }
+        if (c == '[') {
+            if (++mDepth > MAX_JSON_DEPTH)
+                return false;
+            mPos++;
+            out.type = JsonValue::Array;
+            SkipWhitespace();
+            if (mPos < mEnd && *mPos == ']') {
+                mPos++;
+                mDepth--;
+                return true;
+            }
+            while (true) {
+                out.items.emplace_back();
+                if (!ParseValue(out.items.back()))
+                    return false;
+                SkipWhitespace();
+                if (mPos >= mEnd)
+                    return false;
+                c = *mPos++;
+                if (c == ']')
+                    break;
+                if (c != ',')
+                    return false;
+            }
+            mDepth--;
+            return true;
+        }
+        if (c == '"') {
+            out.type = JsonValue::String;
+            return ParseString(out.str);
+        }
+        if (Match("true")) {
+            out.type = JsonValue::Bool;
+            out.boolean = true;
+            return true;
+        }
+        if (Match("false")) {
+            out.type = JsonValue::Bool;
+            return true;
+        }
+        if (Match("null"))
+            return true;
+        char const *numStart = mPos;
+        if (*numStart == '-')
+            numStart++;
+        auto result = from_chars(numStart, mEnd, out.number);
+        if (result.ec != errc() || result.ptr == numStart)
+            return false;
+        if (numStart != mPos)
+            out.number = -out.number;
+        out.type = JsonValue::Number;
+        mPos = result.ptr;
+        return true;
+    }
+public:
+    JsonParser(char const *data, size_t size) : mPos(data), mEnd(data + size) {}
+
+    bool Parse(JsonValue &root) {
+        if (!ParseValue(root))
+            return false;
+        SkipWhitespace();
+        while (mPos < mEnd && *mPos == '\0') // padding left by some .glb writers
+            mPos++;
+        return mPos == mEnd;
+    }
+};
+
+bool ReadFileData(path const &filePath, vector<unsigned char> &out) {
+    FILE *f = _wfopen(filePath.c_str(), L"rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long fileSize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool result = fileSize >= 0;
+    if (result) {
+        out.resize(fileSize);
+        result = fileSize == 0 || fread(out.data(), 1, fileSize, f) == size_t(fileSize);
+    }
+    fclose(f);
+    return result;
+}
+
+bool DecodeBase64(char const *data, size_t size, vector<unsigned char> &out) {
+    auto decodeChar = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+    while (size > 0 && data[size - 1] == '=')
+        size--;
+    out.clear();
+    out.reserve(size * 3 / 4);
+    unsigned int acc = 0;
+    unsigned int bits = 0;
+    for (size_t i = 0; i < size; i++) {
+        int v = decodeChar(data[i]);
+        if (v < 0)
+            return false;
+        acc = (acc << 6) | unsigned int(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(unsigned char((acc >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+string DecodeUri(string const &uri) {
+    string result;
+    for (size_t i = 0; i < uri.size(); i++) {
+        unsigned int c = 0;
+        if (uri[i] == '%' && i + 2 < uri.size() && from_chars(uri.data() + i + 1, uri.data() + i + 3, c, 16).ptr == uri.data() + i + 3) {
+            result += char(c);
+            i += 2;
+        }
+        else
+            result += uri[i];
+    }
+    return result;
+}
+
+unsigned int ComponentSize(unsigned int componentType) {
+    switch (componentType) {
+    case COMPONENT_BYTE:
+    case COMPONENT_UNSIGNED_BYTE:
+        return 1;
+    case COMPONENT_SHORT:
+    case COMPONENT_UNSIGNED_SHORT:
+        return 2;
+    case COMPONENT_UNSIGNED_INT:
+    case COMPONENT_FLOAT:
+        return 4;
+    }
+    return 0;
+}
+
+unsigned int NumComponents(string const &type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT2") return 4;
+    if (type == "MAT3") return 9;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+// typed view over accessor data, which stays in the loaded buffer
+struct AccessorView {
+    unsigned char const *data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;
+    unsigned int componentType = 0;
+    unsigned int numComponents = 0;
+
+    bool Is(unsigned int type, unsigned int components) const {
+        return componentType == type && numComponents == components;
+    }
+
+    float GetFloat(size_t i, unsigned int c) const {
+        unsigned char const *p = data + i * stride;
+        if (componentType == COMPONENT_FLOAT) {
+            float value;
+            memcpy(&value, p + c * 4, 4);
+            return value;
+        }
+        if (componentType == COMPONENT_UNSIGNED_SHORT) {
+            unsigned short value;
+            memcpy(&value, p + c * 2, 2);
+            return value / 65535.0f;
+        }
+        return p[c] / 255.0f;
+    }
+
+    unsigned int GetUInt(size_t i) const {
+        unsigned char const *p = data + i * stride;
+        if (componentType == COMPONENT_UNSIGNED_INT) {
+            unsigned int value;
+            memcpy(&value, p, 4);
+            return value;
+        }
+        if (componentType == COMPONENT_UNSIGNED_SHORT) {
+            unsigned short value;
+            memcpy(&value, p, 2);
+            return value;
+        }
+        return p[0];
+    }
+};
+
+aiTextureMapMode ConvertWrapMode(int wrap) {
+    if (wrap == 33071) // CLAMP_TO_EDGE
+        return aiTextureMapMode_Clamp;
+    if (wrap == 33648) // MIRRORED_REPEAT
+        return aiTextureMapMode_Mirror;
+    return aiTextureMapMode_Wrap;
+}
+
+class GltfReader {
+    path mDir;
+    unsigned int mFlags = 0;
+    unsigned int mMaxVertices = 0;
+    vector<unsigned char> mFileData;
+    JsonValue mRoot;
+    vector<vector<unsigned char>> mBufferStorage; // external files and data URIs; a .glb BIN chunk is used in place
+    vector<pair<unsigned char const *, size_t>> mBuffers;
+    vector<unsigned int> mMeshOffsets;
+    vector<bool> mNodeVisited;
+
+    bool LoadBuffers(unsigned char const *binChunk, size_t binSize) {
+        auto buffers = mRoot.FindArray("buffers");
+        if (!buffers)
+            return true;
+        mBufferStorage.resize(buffers->items.size());
+        for (size_t b = 0; b < buffers->items.size(); b++) {
+            auto const &buffer = buffers->items[b];
+            if (buffer.type != JsonValue::Object)
+                return false;
+            double byteLength = buffer.GetNumber("byteLength", -1.0);
+            if (byteLength < 0)
+                return false;
+            string uri = buffer.GetString("uri");
+            unsigned char const *data = nullptr;
+            size_t size = 0;
+            if (uri.empty()) {
+                if (b != 0 || !binChunk)
+                    return false;
+                data = binChunk;
+                size = binSize;
+            }
+            else {
+                auto &storage = mBufferStorage[b];
+                if (uri.starts_with("data:")) {
+                    auto comma = uri.find(',');
+                    if (comma == string::npos || uri.rfind(";base64", comma) == string::npos)
+                        return false;
+                    if (!DecodeBase64(uri.data() + comma + 1, uri.size() - comma - 1, storage))
+                        return false;
+                }
+                else {
+                    path bufferPath = mDir / uri;
+                    if (!ReadFileData(bufferPath, storage)) {
+                        bufferPath = mDir / DecodeUri(uri);
+                        if (!ReadFileData(bufferPath, storage))
+                            return false;
+                    }
+                    globalVars().dependencies.push_back(bufferPath); // -incremental
+                }
+                data = storage.data();
+                size = storage.size();
+            }
+            if (size < size_t(byteLength))
+                return false;
+            mBuffers.emplace_back(data, size_t(byteLength));
+        }
+        return true;
+    }
+
+    bool GetAccessor(int index, AccessorView &view) {
+        auto accessor = ArrayItem(mRoot.FindArray("accessors"), index);
+        if (!accessor || accessor->Find("sparse"))
+            return false;
+        auto bufferView = ArrayItem(mRoot.FindArray("bufferViews"), accessor->GetIndex("bufferView"));
+        if (!bufferView)
+            return false;
+        int bufferIndex = bufferView->GetIndex("buffer");
+        if (bufferIndex < 0 || size_t(bufferIndex) >= mBuffers.size())
+            return false;
+        view.componentType = unsigned int(accessor->GetNumber("componentType", 0));
+        view.numComponents = NumComponents(accessor->GetString("type"));
+        unsigned int elementSize = ComponentSize(view.componentType) * view.numComponents;
+        if (elementSize == 0)
+            return false;
+        double count = accessor->GetNumber("count", -1.0);
+        double viewOffset = bufferView->GetNumber("byteOffset", 0.0);
+        double viewLength = bufferView->GetNumber("byteLength", -1.0);
+        double accessorOffset = accessor->GetNumber("byteOffset", 0.0);
+        double stride = bufferView->GetNumber("byteStride", 0.0);
+        if (count < 1 || viewOffset < 0 || viewLength < 0 || accessorOffset < 0 || stride < 0)
+            return false;
+        auto const &buffer = mBuffers[bufferIndex];
+        if (viewOffset + viewLength > double(buffer.second))
+            return false;
+        view.count = size_t(count);
+        view.stride = stride > 0 ? size_t(stride) : elementSize;
+        if (view.stride < elementSize || accessorOffset + double(view.stride) * (count - 1) + elementSize > viewLength)
+            return false;
+        view.data = buffer.first + size_t(viewOffset) + size_t(accessorOffset);
+        return true;
+    }
+
+    void AddTexture(aiMaterial *mat, JsonValue const *textureInfo, aiTextureType texType) {
+        auto texture = ArrayItem(mRoot.FindArray("textures"), textureInfo->GetIndex("index"));
+        auto image = texture ? ArrayItem(mRoot.FindArray("images"), texture->GetIndex("source")) : nullptr;
+        if (!image)
+            return;
+        aiString uri(image->GetString("uri"));
+        mat->AddProperty(&uri, AI_MATKEY_TEXTURE(texType, 0));
+        int uvIndex = textureInfo->GetIndex("texCoord");
+        if (uvIndex < 0)
+            uvIndex = 0;
+        mat->AddProperty(&uvIndex, 1, AI_MATKEY_UVWSRC(texType, 0));
+        if (auto sampler = ArrayItem(mRoot.FindArray("samplers"), texture->GetIndex("sampler"))) {
+            aiTextureMapMode wrapS = ConvertWrapMode(int(sampler->GetNumber("wrapS", 10497)));
+            aiTextureMapMode wrapT = ConvertWrapMode(int(sampler->GetNumber("wrapT", 10497)));
+            mat->AddProperty(&wrapS, 1, AI_MATKEY_MAPPINGMODE_U(texType, 0));
+            mat->AddProperty(&wrapT, 1, AI_MATKEY_MAPPINGMODE_V(texType, 0));
+        }
+    }
+
+    // same properties the Assimp glTF 2.0 importer sets for the material, limited to the ones OTools reads
+    bool ReadMaterial(JsonValue const *m, unique_ptr<aiMaterial> &out) {
+        static JsonValue emptyObject = [] { JsonValue v; v.type = JsonValue::Object; return v; }();
+        if (!m)
+            m = &emptyObject;
+        out = make_unique<aiMaterial>();
+        aiMaterial *mat = out.get();
+        string name = m->GetString("name");
+        if (!name.empty()) {
+            aiString matName(name);
+            mat->AddProperty(&matName, AI_MATKEY_NAME);
+        }
+        float baseColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        float metallicFactor = 1.0f;
+        float roughnessFactor = 1.0f;
+        auto pbr = m->FindObject("pbrMetallicRoughness");
+        if (pbr) {
+            if (!pbr->GetNumbers("baseColorFactor", baseColor, 4))
+                return false;
+            metallicFactor = float(pbr->GetNumber("metallicFactor", 1.0));
+            roughnessFactor = float(pbr->GetNumber("roughnessFactor", 1.0));
+        }
+        aiColor4D color(baseColor[0], baseColor[1], baseColor[2], baseColor[3]);
+        mat->AddProperty(&color, 1, AI_MATKEY_BASE_COLOR);
+        mat->AddProperty(&color, 1, AI_MATKEY_COLOR_DIFFUSE);
+        if (auto baseColorTexture = pbr ? pbr->FindObject("baseColorTexture") : nullptr) {
+            AddTexture(mat, baseColorTexture, aiTextureType_BASE_COLOR);
+            AddTexture(mat, baseColorTexture, aiTextureType_DIFFUSE);
+        }
+        mat->AddProperty(&metallicFactor, 1, AI_MATKEY_METALLIC_FACTOR);
+        mat->AddProperty(&roughnessFactor, 1, AI_MATKEY_ROUGHNESS_FACTOR);
+        float roughnessAsShininess = 1 - roughnessFactor;
+        roughnessAsShininess *= roughnessAsShininess * 1000;
+        mat->AddProperty(&roughnessAsShininess, 1, AI_MATKEY_SHININESS);
+        float emissive[3] = { 0.0f, 0.0f, 0.0f };
+        if (!m->GetNumbers("emissiveFactor", emissive, 3))
+            return false;
+        aiColor4D emissiveColor(emissive[0], emissive[1], emissive[2], 1.0f);
+        mat->AddProperty(&emissiveColor, 1, AI_MATKEY_COLOR_EMISSIVE);
+        int doubleSided = m->GetBool("doubleSided", false) ? 1 : 0;
+        mat->AddProperty(&doubleSided, 1, AI_MATKEY_TWOSIDED);
+        mat->AddProperty(&baseColor[3], 1, AI_MATKEY_OPACITY);
+        string alphaModeStr = m->GetString("alphaMode");
+        aiString alphaMode(alphaModeStr.empty() ? "OPAQUE" : alphaModeStr);
+        mat->AddProperty(&alphaMode, AI_MATKEY_GLTF_ALPHAMODE);
+        float alphaCutoff = float(m->GetNumber("alphaCutoff", 0.5));
+        mat->AddProperty(&alphaCutoff, 1, AI_MATKEY_GLTF_ALPHACUTOFF);
+        auto extensions = m->FindObject("extensions");
+        bool unlit = extensions && extensions->FindObject("KHR_materials_unlit");
+        int shadingMode = aiShadingMode_PBR_BRDF;
+        if (unlit) {
+            mat->AddProperty(&unlit, 1, AI_MATKEY_GLTF_UNLIT);
+            shadingMode = aiShadingMode_Unlit;
+        }
+        mat->AddProperty(&shadingMode, 1, AI_MATKEY_SHADING_MODEL);
+        return true;
+    }
+
+    bool ReadPrimitive(JsonValue const &prim, string const &name, unsigned int defaultMaterial, unique_ptr<aiMesh> &out) {
+        if (prim.type != JsonValue::Object || prim.Find("targets"))
+            return false;
+        int mode = int(prim.GetNumber("mode", MODE_TRIANGLES));
+        if (mode != MODE_TRIANGLES && mode != MODE_TRIANGLE_STRIP)
+            return false;
+        auto attributes = prim.FindObject("attributes");
+        if (!attributes)
+            return false;
+        AccessorView positions, normals;
+        AccessorView texcoords[AI_MAX_NUMBER_OF_TEXTURECOORDS];
+        AccessorView colors[AI_MAX_NUMBER_OF_COLOR_SETS];
+        unsigned int numTexcoords = 0;
+        unsigned int numColors = 0;
+        for (size_t a = 0; a < attributes->keys.size(); a++) {
+            string const &attrName = attributes->keys[a];
+            auto const &attrValue = attributes->items[a];
+            if (attrValue.type != JsonValue::Number)
+                return false;
+            int accessorIndex = int(attrValue.number);
+            if (attrName == "POSITION") {
+                if (!GetAccessor(accessorIndex, positions) || !positions.Is(COMPONENT_FLOAT, 3))
+                    return false;
+            }
+            else if (attrName == "NORMAL") {
+                if (!GetAccessor(accessorIndex, normals) || !normals.Is(COMPONENT_FLOAT, 3))
+                    return false;
+            }
+            else if (attrName == "TEXCOORD_" + to_string(numTexcoords) && numTexcoords < AI_MAX_NUMBER_OF_TEXTURECOORDS) {
+                if (!GetAccessor(accessorIndex, texcoords[numTexcoords]) || !texcoords[numTexcoords].Is(COMPONENT_FLOAT, 2))
+                    return false;
+                numTexcoords++;
+            }
+            else if (attrName == "COLOR_" + to_string(numColors) && numColors < AI_MAX_NUMBER_OF_COLOR_SETS) {
+                auto &c = colors[numColors];
+                if (!GetAccessor(accessorIndex, c) || !(c.Is(COMPONENT_FLOAT, 4) || c.Is(COMPONENT_UNSIGNED_BYTE, 4) || c.Is(COMPONENT_UNSIGNED_SHORT, 4)))
+                    return false;
+                numColors++;
+            }
+            else // tangents, skinning, out-of-order sets, custom attributes
+                return false;
+        }
+        // GenSmoothNormals would have to compute them
+        if (!positions.data || !normals.data || normals.count != positions.count)
+            return false;
+        for (unsigned int t = 0; t < numTexcoords; t++) {
+            if (texcoords[t].count != positions.count)
+                return false;
+        }
+        for (unsigned int c = 0; c < numColors; c++) {
+            if (colors[c].count != positions.count)
+                return false;
+        }
+
+        // like Assimp, only the vertices referenced by the indices are kept, in the order of their first use
+        vector<unsigned int> indices;
+        vector<unsigned int> usedVertices;
+        int indicesIndex = prim.GetIndex("indices");
+        if (indicesIndex >= 0) {
+            AccessorView indexView;
+            if (!GetAccessor(indicesIndex, indexView) || indexView.numComponents != 1 || (indexView.componentType != COMPONENT_UNSIGNED_BYTE &&
+                indexView.componentType != COMPONENT_UNSIGNED_SHORT && indexView.componentType != COMPONENT_UNSIGNED_INT))
+            {
+                return false;
+            }
+            static const unsigned int UNUSED = UINT_MAX;
+            vector<unsigned int> remap(positions.count, UNUSED);
+            indices.resize(indexView.count);
+            for (size_t i = 0; i < indexView.count; i++) {
+                unsigned int index = indexView.GetUInt(i);
+                if (index >= positions.count)
+                    return false;
+                if (remap[index] == UNUSED) {
+                    remap[index] = unsigned int(usedVertices.size());
+                    usedVertices.push_back(index);
+                }
+                indices[i] = remap[index];
+            }
+        }
+        else {
+            usedVertices.resize(positions.count);
+            for (size_t i = 0; i < positions.count; i++)
+                usedVertices[i] = unsigned int(i);
+            indices = usedVertices;
+        }
+        // SplitLargeMeshes would split it
+        bool splitLimits = (mFlags & aiProcess_SplitLargeMeshes) != 0;
+        if (splitLimits && usedVertices.size() > mMaxVertices)
+            return false;
+        size_t numFaces = 0;
+        if (mode == MODE_TRIANGLES) {
+            if (indices.size() % 3)
+                return false;
+            numFaces = indices.size() / 3;
+        }
+        else {
+            if (indices.size() < 3)
+                return false;
+            numFaces = indices.size() - 2;
+        }
+        if (numFaces == 0 || (splitLimits && numFaces > AI_SLM_DEFAULT_MAX_TRIANGLES))
+            return false;
+
+        out = make_unique<aiMesh>();
+        aiMesh *mesh = out.get();
+        mesh->mName = name;
+        mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        int material = prim.GetIndex("material");
+        mesh->mMaterialIndex = material >= 0 ? unsigned int(material) : defaultMaterial;
+        if (mesh->mMaterialIndex > defaultMaterial)
+            return false;
+        unsigned int numVertices = unsigned int(usedVertices.size());
+        mesh->mNumVertices = numVertices;
+        mesh->mVertices = new aiVector3D[numVertices];
+        mesh->mNormals = new aiVector3D[numVertices];
+        for (unsigned int v = 0; v < numVertices; v++) {
+            size_t src = usedVertices[v];
+            mesh->mVertices[v].Set(positions.GetFloat(src, 0), positions.GetFloat(src, 1), positions.GetFloat(src, 2));
+            mesh->mNormals[v].Set(normals.GetFloat(src, 0), normals.GetFloat(src, 1), normals.GetFloat(src, 2));
+        }
+        bool flipUVs = (mFlags & aiProcess_FlipUVs) != 0;
+        for (unsigned int t = 0; t < numTexcoords; t++) {
+            mesh->mTextureCoords[t] = new aiVector3D[numVertices];
+            mesh->mNumUVComponents[t] = 2;
+            for (unsigned int v = 0; v < numVertices; v++) {
+                size_t src = usedVertices[v];
+                // the glTF importer flips V to the Assimp convention and FlipUVs flips it back
+                float texV = 1.0f - texcoords[t].GetFloat(src, 1);
+                if (flipUVs)
+                    texV = 1.0f - texV;
+                mesh->mTextureCoords[t][v].Set(texcoords[t].GetFloat(src, 0), texV, 0.0f);
+            }
+        }
+        for (unsigned int c = 0; c < numColors; c++) {
+            mesh->mColors[c] = new aiColor4D[numVertices];
+            for (unsigned int v = 0; v < numVertices; v++) {
+                size_t src = usedVertices[v];
+                mesh->mColors[c][v] = aiColor4D(colors[c].GetFloat(src, 0), colors[c].GetFloat(src, 1), colors[c].GetFloat(src, 2), colors[c].GetFloat(src, 3));
+            }
+        }
+        mesh->mNumFaces = unsigned int(numFaces);
+        mesh->mFaces = new aiFace[numFaces];
+        bool flipWinding = (mFlags & aiProcess_FlipWindingOrder) != 0;
+        for (size_t f = 0; f < numFaces; f++) {
+            unsigned int a, b, c;
+            if (mode == MODE_TRIANGLES) {
+                a = indices[f * 3];
+                b = indices[f * 3 + 1];
+                c = indices[f * 3 + 2];
+            }
+            else if (f % 2) { // keep the orientation of odd strip triangles
+                a = indices[f + 1];
+                b = indices[f];
+                c = indices[f + 2];
+            }
+            else {
+                a = indices[f];
+                b = indices[f + 1];
+                c = indices[f + 2];
+            }
+            if (flipWinding)
+                swap(a, c);
+            aiFace &face = mesh->mFaces[f];
+            face.mNumIndices = 3;
+            face.mIndices = new unsigned int[3] { a, b, c };
+        }
+        return true;
+    }
+
+    aiNode *ReadNode(int index, aiNode *parent) {
+        auto node = ArrayItem(mRoot.FindArray("nodes"), index);
+        // unnamed nodes would get generated names, a node used twice would be instanced; both are left to Assimp
+        if (!node || mNodeVisited[index] || node->GetString("name").empty() || node->Find("skin") || node->Find("weights"))
+            return nullptr;
+        mNodeVisited[index] = true;
+        auto aiNodePtr = make_unique<aiNode>(node->GetString("name"));
+        aiNode *n = aiNodePtr.get();
+        n->mParent = parent;
+        float matrix[16];
+        if (node->Find("matrix")) {
+            if (!node->GetNumbers("matrix", matrix, 16))
+                return nullptr;
+            // column-major
+            n->mTransformation = aiMatrix4x4(matrix[0], matrix[4], matrix[8], matrix[12], matrix[1], matrix[5], matrix[9], matrix[13],
+                matrix[2], matrix[6], matrix[10], matrix[14], matrix[3], matrix[7], matrix[11], matrix[15]);
+        }
+        else {
+            float t[3] = { 0.0f, 0.0f, 0.0f };
+            float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            float s[3] = { 1.0f, 1.0f, 1.0f };
+            if (!node->GetNumbers("translation", t, 3) || !node->GetNumbers("rotation", r, 4) || !node->GetNumbers("scale", s, 3))
+                return nullptr;
+            aiMatrix4x4 tm, sm;
+            if (node->Find("translation"))
+                n->mTransformation *= aiMatrix4x4::Translation(aiVector3D(t[0], t[1], t[2]), tm);
+            if (node->Find("rotation"))
+                n->mTransformation *= aiMatrix4x4(aiQuaternion(r[3], r[0], r[1], r[2]).GetMatrix());
+            if (node->Find("scale"))
+                n->mTransformation *= aiMatrix4x4::Scaling(aiVector3D(s[0], s[1], s[2]), sm);
+        }
+        int meshIndex = node->GetIndex("mesh");
+        if (node->Find("mesh")) {
+            if (meshIndex < 0 || size_t(meshIndex) + 1 >= mMeshOffsets.size())
+                return nullptr;
+            n->mNumMeshes = mMeshOffsets[meshIndex + 1] - mMeshOffsets[meshIndex];
+            n->mMeshes = new unsigned int[n->mNumMeshes];
+            for (unsigned int m = 0; m < n->mNumMeshes; m++)
+                n->mMeshes[m] = mMeshOffsets[meshIndex] + m;
+        }
+        if (auto children = node->FindArray("children")) {
+            vector<aiNode *> childNodes;
+            for (auto const &c : children->items) {
+                aiNode *child = c.type == JsonValue::Number ? ReadNode(int(c.number), n) : nullptr;
+                if (!child) {
+                    for (auto cn : childNodes)
+                        delete cn;
+                    return nullptr;
+                }
+                childNodes.push_back(child);
+            }
+            n->addChildren(unsigned int(childNodes.size()), childNodes.data());
+        }
+        return aiNodePtr.release();
+    }
+public:
+    unique_ptr<aiScene> Read(path const &filePath, unsigned int postProcessFlags, unsigned int maxVerticesPerMesh) {
+        if (postProcessFlags & ~SUPPORTED_FLAGS)
+            return nullptr;
+        mFlags = postProcessFlags;
+        mMaxVertices = maxVerticesPerMesh;
+        mDir = filePath.parent_path();
+        if (!ReadFileData(filePath, mFileData))
+            return nullptr;
+        char const *json = (char const *)mFileData.data();
+        size_t jsonSize = mFileData.size();
+        unsigned char const *binChunk = nullptr;
+        size_t binSize = 0;
+        unsigned int header[3] = {};
+        if (mFileData.size() >= 12)
+            memcpy(header, mFileData.data(), 12);
+        if (header[0] == GLB_MAGIC) {
+            if (header[1] != 2 || header[2] > mFileData.size())
+                return nullptr;
+            size_t pos = 12;
+            json = nullptr;
+            while (pos + 8 <= header[2]) {
+                unsigned int chunk[2];
+                memcpy(chunk, mFileData.data() + pos, 8);
+                pos += 8;
+                if (chunk[0] > header[2] - pos)
+                    return nullptr;
+                if (chunk[1] == GLB_CHUNK_JSON && !json) {
+                    json = (char const *)mFileData.data() + pos;
+                    jsonSize = chunk[0];
+                }
+                else if (chunk[1] == GLB_CHUNK_BIN && !binChunk) {
+                    binChunk = mFileData.data() + pos;
+                    binSize = chunk[0];
+                }
+                pos += (chunk[0] + 3) & ~3u;
+            }
+            if (!json)
+                return nullptr;
+        }
+        if (jsonSize >= 3 && !memcmp(json, "\xEF\xBB\xBF", 3)) {
+            json += 3;
+            jsonSize -= 3;
+        }
+        JsonParser parser(json, jsonSize);
+        if (!parser.Parse(mRoot) || mRoot.type != JsonValue::Object)
+            return nullptr;
+        auto asset = mRoot.FindObject("asset");
+        if (!asset || !asset->GetString("version").starts_with("2"))
+            return nullptr;
+        if (auto required = mRoot.FindArray("extensionsRequired"); required && !required->items.empty())
+            return nullptr;
+        if (auto used = mRoot.FindArray("extensionsUsed")) {
+            for (auto const &e : used->items) {
+                if (e.type != JsonValue::String || e.str != "KHR_materials_unlit")
+                    return nullptr;
+            }
+        }
+        for (auto key : { "skins", "animations" }) {
+            if (auto arr = mRoot.FindArray(key); arr && !arr->items.empty())
+                return nullptr;
+        }
+        // images stored in the file itself would become embedded textures
+        if (auto images = mRoot.FindArray("images")) {
+            for (auto const &image : images->items) {
+                if (image.type != JsonValue::Object || image.Find("bufferView") || image.GetString("uri").starts_with("data:"))
+                    return nullptr;
+            }
+        }
+        if (!LoadBuffers(binChunk, binSize))
+            return nullptr;
+
+        auto materials = mRoot.FindArray("materials");
+        unsigned int numMaterials = materials ? unsigned int(materials->items.size()) : 0;
+        vector<unique_ptr<aiMaterial>> sceneMaterials(numMaterials + 1); // + default material
+        for (unsigned int m = 0; m <= numMaterials; m++) {
+            JsonValue const *mat = nullptr;
+            if (m < numMaterials) {
+                mat = ArrayItem(materials, int(m));
+                if (!mat)
+                    return nullptr;
+            }
+            if (!ReadMaterial(mat, sceneMaterials[m]))
+                return nullptr;
+        }
+
+        vector<unique_ptr<aiMesh>> sceneMeshes;
+        auto meshes = mRoot.FindArray("meshes");
+        size_t numMeshes = meshes ? meshes->items.size() : 0;
+        mMeshOffsets.assign(1, 0);
+        for (size_t m = 0; m < numMeshes; m++) {
+            auto mesh = ArrayItem(meshes, int(m));
+            auto primitives = mesh ? mesh->FindArray("primitives") : nullptr;
+            if (!primitives || primitives->items.empty())
+                return nullptr;
+            string meshName = mesh->GetString("name");
+            if (meshName.empty())
+                meshName = "meshes_" + to_string(m);
+            for (size_t p = 0; p < primitives->items.size(); p++) {
+                string name = primitives->items.size() > 1 ? meshName + "-" + to_string(p) : meshName;
+                sceneMeshes.emplace_back();
+                if (!ReadPrimitive(primitives->items[p], name, numMaterials, sceneMeshes.back()))
+                    return nullptr;
+            }
+            mMeshOffsets.push_back(unsigned int(sceneMeshes.size()));
+        }
+
+        auto scenes = mRoot.FindArray("scenes");
+        int sceneIndex = mRoot.Find("scene") ? mRoot.GetIndex("scene") : 0;
+        auto gltfScene = ArrayItem(scenes, sceneIndex);
+        auto rootNodes = gltfScene ? gltfScene->FindArray("nodes") : nullptr;
+        if (!rootNodes || rootNodes->items.empty())
+            return nullptr;
+        auto nodes = mRoot.FindArray("nodes");
+        mNodeVisited.assign(nodes ? nodes->items.size() : 0, false);
+        auto scene = make_unique<aiScene>();
+        if (rootNodes->items.size() == 1) {
+            auto const &r = rootNodes->items[0];
+            scene->mRootNode = r.type == JsonValue::Number ? ReadNode(int(r.number), nullptr) : nullptr;
+            if (!scene->mRootNode)
+                return nullptr;
+        }
+        else {
+            scene->mRootNode = new aiNode("ROOT");
+            vector<aiNode *> children;
+            for (auto const &r : rootNodes->items) {
+                aiNode *child = r.type == JsonValue::Number ? ReadNode(int(r.number), scene->mRootNode) : nullptr;
+                if (!child) {
+                    for (auto c : children)
+                        delete c;
+                    return nullptr;
+                }
+                children.push_back(child);
+            }
+            scene->mRootNode->addChildren(unsigned int(children.size()), children.data());
+        }
+
+        scene->mNumMaterials = unsigned int(sceneMaterials.size());
+        scene->mMaterials = new aiMaterial *[scene->mNumMaterials];
+        for (unsigned int m = 0; m < scene->mNumMaterials; m++)
+            scene->mMaterials[m] = sceneMaterials[m].release();
+        if (!sceneMeshes.empty()) {
+            scene->mNumMeshes = unsigned int(sceneMeshes.size());
+            scene->mMeshes = new aiMesh *[scene->mNumMeshes];
+            for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+                scene->mMeshes[m] = sceneMeshes[m].release();
+        }
+        return scene;
+    }
+};
+
+}
+
+unique_ptr<aiScene> ReadGltfScene(path const &filePath, unsigned int postProcessFlags, unsigned int maxVerticesPerMesh) {
+    GltfReader reader;
+    return reader.Read(filePath, postProcessFlags, maxVerticesPerMesh);
+}
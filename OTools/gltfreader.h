@@ -0,0 +1,11 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <assimp/scene.h>
+
+// Native glTF 2.0 reader (.gltf/.glb), used by oimport ahead of Assimp. The file and its buffers are read once and the
+// accessors are walked through typed views straight into the aiScene arrays, with the post-processing requested in
+// postProcessFlags applied on the fly, so the result matches what Assimp would return for the same flags.
+// Returns null when the file (or a flag) needs something this reader doesn't handle: skins, morph targets, animations,
+// compressed or quantized geometry, embedded images, extensions... The caller falls back to Assimp then.
+std::unique_ptr<aiScene> ReadGltfScene(std::filesystem::path const &filePath, unsigned int postProcessFlags, unsigned int maxVerticesPerMesh);
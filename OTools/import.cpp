@@ -9,8 +9,16 @@
 #include <iostream>
 #include <cassert>
 #include <cstdlib>
+#include <climits>
+#include <unordered_map>
+#include <unordered_set>
 #include "binbuf.h"
 #include "shaders.h"
+#include "vertexcodec.h"
+#include "bounds.h"
+#include "gltfreader.h"
+#include "scenecache.h"
+#include "simplify.h"
 #include "NvTriStrip/NvTriStrip.h"
 #include "Fsh\Fsh.h"
 #include "srgb/SrgbTransform.hpp"
@@ -73,6 +81,85 @@ struct CollLine {
     unsigned short vertPos[2];
 };
 
+// spatial hash weld for collision vertices - points closer than epsilon (or bitwise equal when epsilon is 0) share an id
+class CollWelder {
+    float mEpsilon = 0.0f;
+    float mCellScale = 0.0f;
+    unordered_map<unsigned long long, unsigned int> mCellHeads;
+    vector<unsigned int> mNext;
+
+    unsigned long long CellKey(int x, int y, int z) const {
+        return (unsigned long long(x & 0x1FFFFF) << 42) | (unsigned long long(y & 0x1FFFFF) << 21) | unsigned long long(z & 0x1FFFFF);
+    }
+
+    unsigned long long ExactKey(aiVector3D const &p) const {
+        unsigned int bits[3];
+        Memory_Copy(bits, &p, 12);
+        return ((unsigned long long(bits[0]) << 32) | bits[1]) ^ (unsigned long long(bits[2]) * 0x9E3779B97F4A7C15ull);
+    }
+public:
+    vector<aiVector3D> points;
+
+    CollWelder(float epsilon) {
+        mEpsilon = epsilon;
+        mCellScale = epsilon > 0.0f ? 1.0f / epsilon : 0.0f;
+    }
+
+    unsigned int Add(aiVector3D p) {
+        // -0.0 and 0.0 must weld together
+        p.x += 0.0f;
+        p.y += 0.0f;
+        p.z += 0.0f;
+        unsigned long long key;
+        if (mEpsilon > 0.0f) {
+            int cell[3];
+            for (unsigned int a = 0; a < 3; a++)
+                cell[a] = int(floorf(p[a] * mCellScale));
+            float maxDistSq = mEpsilon * mEpsilon;
+            for (int z = -1; z <= 1; z++) {
+                for (int y = -1; y <= 1; y++) {
+                    for (int x = -1; x <= 1; x++) {
+                        auto it = mCellHeads.find(CellKey(cell[0] + x, cell[1] + y, cell[2] + z));
+                        if (it != mCellHeads.end()) {
+                            for (unsigned int i = (*it).second; i != UINT_MAX; i = mNext[i]) {
+                                if ((points[i] - p).SquareLength() <= maxDistSq)
+                                    return i;
+                            }
+                        }
+                    }
+                }
+            }
+            key = CellKey(cell[0], cell[1], cell[2]);
+        }
+        else {
+            key = ExactKey(p);
+            auto it = mCellHeads.find(key);
+            if (it != mCellHeads.end()) {
+                for (unsigned int i = (*it).second; i != UINT_MAX; i = mNext[i]) {
+                    if (points[i] == p)
+                        return i;
+                }
+            }
+        }
+        unsigned int newId = points.size();
+        points.push_back(p);
+        auto head = mCellHeads.try_emplace(key, UINT_MAX);
+        mNext.push_back((*head.first).second);
+        (*head.first).second = newId;
+        return newId;
+    }
+};
+
+aiVector3D QuantizeCollNormal(aiVector3D const &normal) {
+    if (options().collisionNormalSteps == 0)
+        return normal;
+    float steps = float(options().collisionNormalSteps);
+    aiVector3D result;
+    for (unsigned int a = 0; a < 3; a++)
+        result[a] = roundf(normal[a] * steps) / steps;
+    return result.NormalizeSafe();
+}
+
 void GetMatColorAndAlphaProperties(aiMaterial *mat, aiColor3D &matColor, float &alpha, AlphaMode &alphaMode, int &blendFunc) {
     matColor.r = 255;
     matColor.g = 255;
@@ -100,9 +187,9 @@ struct Node {
     string name;
     aiNode *node = nullptr;
     vector<unsigned int> renderDescriptorsOffsets;
-    aiVector3D boundMin = { 0.0f, 0.0f, 0.0f };
-    aiVector3D boundMax = { 0.0f, 0.0f, 0.0f };
-    bool anyVertexProcessed = false;
+    Bounds bounds;
+    bool hasTransparency = false; // filled by HasTransparency() before sorting by alpha
+    unsigned int lodLevel = 0; // -lods: 0 for the original layers
     static aiScene const *scene;
 
     Node(aiNode *_node) {
@@ -111,7 +198,7 @@ struct Node {
     }
 
     static bool SortByName(Node const &a, Node const &b) {
-        return a.name <= b.name;
+        return a.name < b.name;
     }
 
     bool HasTransparency() const {
@@ -133,15 +220,13 @@ struct Node {
     }
 
     static bool SortByAlpha(Node const &a, Node const &b) {
-        return a.HasTransparency() <= b.HasTransparency();
+        return a.hasTransparency < b.hasTransparency;
     }
 
     static bool SortByNameAndAlpha(Node const &a, Node const &b) {
-        bool atp = a.HasTransparency();
-        bool btp = b.HasTransparency();
-        if (atp == btp)
+        if (a.hasTransparency == b.hasTransparency)
             return SortByName(a, b);
-        return atp <= btp;
+        return a.hasTransparency < b.hasTransparency;
     }
 };
 
@@ -309,43 +394,94 @@ struct ModData {
 
 struct Modifiables {
     vector<ModData> vec;
+    unordered_map<string, unsigned int> pool; // name + content -> offset of the object
 
     GlobalArg GetArg(string const &name, string const &_runtimeConstructorLine, unsigned int _runtimeSize) {
-        bool isPresent = false;
-        for (auto const &m : vec) {
-            if (m.name == name && m.runtimeConstructorLine == _runtimeConstructorLine && m.runtimeSize == _runtimeSize) {
-                isPresent = true;
-                break;
-            }
-        }
-        if (!isPresent)
+        string key = name + '\0' + 'R' + _runtimeConstructorLine + '\0' + to_string(_runtimeSize);
+        if (pool.try_emplace(key, 0).second)
             vec.emplace_back(name, _runtimeConstructorLine, _runtimeSize);
         return GlobalArg(_runtimeConstructorLine);
     }
 
     template<typename T>
     GlobalArg GetArg(string const &name, BinaryBuffer &buf, T const &obj, bool putZero = false, bool align = false) {
-        vector<unsigned char> newVec(sizeof(T));
-        Memory_Copy(&newVec[0], &obj, sizeof(T));
-        bool isPresent = false;
-        unsigned int offset = 0;
-        for (auto const &m : vec) {
-            if (m.name == name && m.data == newVec) {
-                isPresent = true;
-                offset = m.offset;
-                break;
-            }
-        }
-        if (!isPresent) {
+        string key = name + '\0' + 'D';
+        key.append((char const *)&obj, sizeof(T));
+        auto [it, isNew] = pool.try_emplace(key, 0);
+        if (isNew) {
             if (align)
                 buf.Align(16);
-            offset = buf.Position();
-            vec.emplace_back(name, buf.Position(), newVec);
+            (*it).second = buf.Position();
+            vector<unsigned char> data(sizeof(T));
+            Memory_Copy(&data[0], &obj, sizeof(T));
+            vec.emplace_back(name, buf.Position(), data);
             buf.Put(obj);
             if (putZero)
                 buf.Put(int(0));
         }
-        return GlobalArg(offset);
+        return GlobalArg((*it).second);
+    }
+};
+
+// content-addressed vertex/index buffers (-shareGeometry): byte-identical buffers are written once and referenced by offset.
+// Repeated triangle lists (copies of a mesh) also reuse the strips generated for the first one. Copies placed with a different
+// transform can only share their index buffers: render descriptors have no transform of their own (gpModelMatrix is set per
+// model), so their vertices are stored in model space.
+struct GeometryPool {
+    struct Strip {
+        vector<unsigned short> sourceIndices;
+        vector<unsigned short> indices;
+    };
+
+    bool enabled = false;
+    unordered_multimap<unsigned long long, pair<unsigned int, unsigned int>> blocks; // content hash -> offset, size
+    unordered_multimap<unsigned long long, Strip> strips; // triangle list hash -> strip
+
+    static unsigned long long HashData(void const *data, unsigned int size) {
+        unsigned long long hash = 14695981039346656037ull;
+        auto bytes = (unsigned char const *)data;
+        for (unsigned int i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // writes the data followed by 1, as the geometry buffers are stored
+    unsigned int Put(BinaryBuffer &buf, void const *data, unsigned int size) {
+        unsigned long long hash = 0;
+        if (enabled) {
+            hash = HashData(data, size);
+            auto range = blocks.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                auto [offset, blockSize] = (*it).second;
+                if (blockSize == size && !memcmp(buf.Data() + offset, data, size))
+                    return offset;
+            }
+        }
+        unsigned int offset = buf.Position();
+        buf.Put(data, size);
+        buf.Put(unsigned int(1));
+        if (enabled)
+            blocks.emplace(hash, make_pair(offset, size));
+        return offset;
+    }
+
+    // null when no strip was generated for this triangle list
+    vector<unsigned short> const *FindStrip(vector<unsigned short> const &sourceIndices) const {
+        if (!enabled)
+            return nullptr;
+        auto range = strips.equal_range(HashData(sourceIndices.data(), unsigned int(sourceIndices.size() * 2)));
+        for (auto it = range.first; it != range.second; ++it) {
+            if ((*it).second.sourceIndices == sourceIndices)
+                return &(*it).second.indices;
+        }
+        return nullptr;
+    }
+
+    void AddStrip(vector<unsigned short> const &sourceIndices, vector<unsigned short> const &indices) {
+        if (enabled)
+            strips.emplace(HashData(sourceIndices.data(), unsigned int(sourceIndices.size() * 2)), Strip{ sourceIndices, indices });
     }
 };
 
@@ -417,15 +553,6 @@ struct IrradLight {
     }
 };
 
-struct VertexBoneInfo {
-    float weight;
-    unsigned char boneIndex;
-};
-
-struct VertexWeightInfo {
-    vector<VertexBoneInfo> bones;
-};
-
 union VertexBoneInfoLayout {
     float fValue;
     unsigned int uiValue;
@@ -440,17 +567,6 @@ struct VertexWeightInfoLayout {
         Memory_Zero(*this);
     }
 
-    VertexWeightInfoLayout(VertexWeightInfo const &w) {
-        Memory_Zero(*this);
-        if (w.bones.size() > 3)
-            throw runtime_error("more than 3 bones in VertexWeightInfo (VertexWeightInfoLayout(VertexWeightInfo const &w))");
-        numBones = w.bones.size();
-        for (unsigned int wb = 0; wb < w.bones.size(); wb++) {
-            bones[wb].fValue = w.bones[wb].weight;
-            bones[wb].ucValue = w.bones[wb].boneIndex;
-        }       
-    }
-
     VertexWeightInfoLayout(VertexWeightInfoLayout const &w) {
         Memory_Copy(this, &w, sizeof(VertexWeightInfoLayout));
     }
@@ -461,14 +577,6 @@ struct VertexWeightInfoLayout {
     }
 };
 
-bool operator<(VertexBoneInfo const &a, VertexBoneInfo const &b) {
-    return a.weight > b.weight;
-}
-
-bool operator>(VertexBoneInfo const &a, VertexBoneInfo const &b) {
-    return a.weight < b.weight;
-}
-
 bool operator<(VertexBoneInfoLayout const &a, VertexBoneInfoLayout const &b) {
     return a.uiValue > b.uiValue;
 }
@@ -491,6 +599,156 @@ bool operator<(VertexWeightInfoLayout const &a, VertexWeightInfoLayout const &b)
     return false;
 }
 
+// Skin weights of all vertices of a mesh in fixed slots, one lane per slot: slot k of vertex v is boneIndices[k][v] and
+// weights[k][v]. Slots are sorted by weight (strongest first), unused slots have zero weight.
+struct VertexWeights {
+    static const unsigned int MaxBones = 3;
+
+    vector<unsigned char> numBones;
+    vector<unsigned char> boneIndices[MaxBones];
+    vector<float> weights[MaxBones];
+    vector<unsigned int> keys; // vertex > index in layouts, filled by BuildKeys()
+    vector<VertexWeightInfoLayout> layouts; // unique, sorted
+
+    unsigned int NumVertices() const {
+        return unsigned int(numBones.size());
+    }
+
+    void Resize(unsigned int numVertices) {
+        numBones.assign(numVertices, 0);
+        for (unsigned int k = 0; k < MaxBones; k++) {
+            boneIndices[k].assign(numVertices, 0);
+            weights[k].assign(numVertices, 0.0f);
+        }
+    }
+
+    void Clear(unsigned int v) {
+        numBones[v] = 0;
+        for (unsigned int k = 0; k < MaxBones; k++) {
+            boneIndices[k][v] = 0;
+            weights[k][v] = 0.0f;
+        }
+    }
+
+    // insertion into the sorted slots, bones with the same weight keep the order they were added in; the weakest bone is
+    // dropped when all slots are used
+    void Add(unsigned int v, unsigned char boneIndex, float weight) {
+        unsigned int count = numBones[v];
+        if (count == MaxBones && !(weight > weights[MaxBones - 1][v]))
+            return;
+        unsigned int k = count < MaxBones ? count : MaxBones - 1;
+        for (; k > 0 && weight > weights[k - 1][v]; k--) {
+            boneIndices[k][v] = boneIndices[k - 1][v];
+            weights[k][v] = weights[k - 1][v];
+        }
+        boneIndices[k][v] = boneIndex;
+        weights[k][v] = weight;
+        if (count < MaxBones)
+            numBones[v] = count + 1;
+    }
+
+    // vertices without bones get bone 0; then truncated to 'maxBones', normalized and quantized with -vertexWeightPaletteSize
+    void Finalize(unsigned int maxBones, unsigned int paletteSize) {
+        unsigned int numVertices = NumVertices();
+        if (maxBones > MaxBones)
+            maxBones = MaxBones;
+        for (unsigned int v = 0; v < numVertices; v++) {
+            if (numBones[v] == 0) {
+                numBones[v] = 1;
+                boneIndices[0][v] = 0;
+                weights[0][v] = 1.0f;
+            }
+            else if (numBones[v] > maxBones)
+                numBones[v] = maxBones;
+        }
+        for (unsigned int k = maxBones; k < MaxBones; k++) {
+            fill(boneIndices[k].begin(), boneIndices[k].end(), 0);
+            fill(weights[k].begin(), weights[k].end(), 0.0f);
+        }
+        Normalize();
+        if (paletteSize > 0) {
+            if (paletteSize == 1) {
+                for (unsigned int k = 0; k < MaxBones; k++) {
+                    float *w = weights[k].data();
+                    for (unsigned int v = 0; v < numVertices; v++)
+                        w[v] = k < numBones[v] ? 1.0f : 0.0f;
+                }
+            }
+            else {
+                // flooring keeps the order, so the bones which are still used stay in the first slots
+                float palette = float(paletteSize);
+                for (unsigned int k = 0; k < MaxBones; k++) {
+                    float *w = weights[k].data();
+                    for (unsigned int v = 0; v < numVertices; v++)
+                        w[v] = floor(w[v] * palette);
+                }
+                for (unsigned int v = 0; v < numVertices; v++) {
+                    unsigned int count = 0;
+                    for (unsigned int k = 0; k < MaxBones; k++)
+                        count += weights[k][v] > 0.0f;
+                    if (count == 0) {
+                        count = 1;
+                        weights[0][v] = 1.0f;
+                    }
+                    for (unsigned int k = count; k < MaxBones; k++)
+                        boneIndices[k][v] = 0;
+                    numBones[v] = count;
+                }
+            }
+            Normalize();
+        }
+    }
+
+    // dedupe of the per-vertex layouts; keys are given in the layouts order, so maps keyed by them iterate the layouts sorted
+    void BuildKeys() {
+        unsigned int numVertices = NumVertices();
+        vector<VertexWeightInfoLayout> vertexLayouts(numVertices);
+        for (unsigned int v = 0; v < numVertices; v++)
+            vertexLayouts[v] = Layout(v);
+        vector<unsigned int> order(numVertices);
+        for (unsigned int v = 0; v < numVertices; v++)
+            order[v] = v;
+        stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+            return vertexLayouts[a] < vertexLayouts[b];
+        });
+        keys.resize(numVertices);
+        layouts.clear();
+        for (unsigned int i = 0; i < numVertices; i++) {
+            if (layouts.empty() || layouts.back() < vertexLayouts[order[i]])
+                layouts.push_back(vertexLayouts[order[i]]);
+            keys[order[i]] = unsigned int(layouts.size() - 1);
+        }
+    }
+
+    VertexWeightInfoLayout Layout(unsigned int v) const {
+        VertexWeightInfoLayout layout;
+        layout.numBones = numBones[v];
+        for (unsigned int k = 0; k < numBones[v]; k++) {
+            layout.bones[k].fValue = weights[k][v];
+            layout.bones[k].ucValue = boneIndices[k][v];
+        }
+        return layout;
+    }
+
+private:
+    void Normalize() {
+        unsigned int numVertices = NumVertices();
+        vector<float> totals(numVertices, 0.0f);
+        for (unsigned int k = 0; k < MaxBones; k++) {
+            float const *w = weights[k].data();
+            for (unsigned int v = 0; v < numVertices; v++)
+                totals[v] += w[v];
+        }
+        for (unsigned int v = 0; v < numVertices; v++)
+            totals[v] = totals[v] > 0.0f ? totals[v] : 1.0f;
+        for (unsigned int k = 0; k < MaxBones; k++) {
+            float *w = weights[k].data();
+            for (unsigned int v = 0; v < numVertices; v++)
+                w[v] /= totals[v];
+        }
+    }
+};
+
 struct BoneInfo {
     unsigned char index = 0;
     aiBone *bone = nullptr;
@@ -506,7 +764,7 @@ struct BoneInfo {
 };
 
 struct MeshInfo {
-    map<VertexWeightInfoLayout, vector<unsigned int>> weightsMap;
+    map<unsigned int, vector<unsigned int>> weightsMap; // VertexWeights key > vertices
     map<unsigned int, unsigned int> verticesMap; // original vertex index > new vertex index
     unsigned int startFace = 0;
     unsigned int numFaces = 0;
@@ -632,38 +890,49 @@ void NodeAddCallback(aiNode *node, vector<Node> &nodes, StadiumExtra &stadExtra)
     }
 }
 
-void ProcessBoundBox(aiVector3D &boundMin, aiVector3D &boundMax, bool &anyVertexProcessed, aiVector3D const &pos) {
-    if (!anyVertexProcessed) {
-        boundMin = pos;
-        boundMax = pos;
-        anyVertexProcessed = true;
-    }
-    else {
-        if (pos.x < boundMin.x)
-            boundMin.x = pos.x;
-        if (pos.y < boundMin.y)
-            boundMin.y = pos.y;
-        if (pos.z < boundMin.z)
-            boundMin.z = pos.z;
-        if (pos.x > boundMax.x)
-            boundMax.x = pos.x;
-        if (pos.y > boundMax.y)
-            boundMax.y = pos.y;
-        if (pos.z > boundMax.z)
-            boundMax.z = pos.z;
-    }
-}
-
-void ScaleBoundBox(aiVector3D& boundMin, aiVector3D& boundMax) {
-    aiVector3D boundCenter = boundMax - boundMin;
-    boundCenter /= 2.0f;
-    boundCenter += boundMin;
-    aiVector3D boundUp = boundMax - boundCenter;
-    aiVector3D boundLow = boundMin - boundCenter;
-    boundUp *= options().bboxScale;
-    boundLow *= options().bboxScale;
-    boundMax = boundCenter + boundUp;
-    boundMin = boundCenter + boundLow;
+// -lods: every mesh node gets simplified copies as child nodes '<name>_lod<N>', which are written as separate layers.
+// The LOD layers are written hidden, the game switches between the levels through the layer visibility.
+void AddLodNodes(aiScene *scene, vector<Node> &nodes) {
+    vector<aiMesh *> lodMeshes;
+    vector<Node> result;
+    for (auto const &n : nodes) {
+        result.push_back(n);
+        vector<aiNode *> lodNodes;
+        for (unsigned int l = 0; l < options().lods.size(); l++) {
+            vector<unsigned int> meshIndices;
+            bool anySimplified = false;
+            for (unsigned int m = 0; m < n.node->mNumMeshes; m++) {
+                aiMesh *lodMesh = SimplifyMesh(scene->mMeshes[n.node->mMeshes[m]], options().lods[l]);
+                if (lodMesh) {
+                    meshIndices.push_back(scene->mNumMeshes + unsigned int(lodMeshes.size()));
+                    lodMeshes.push_back(lodMesh);
+                    anySimplified = true;
+                }
+                else
+                    meshIndices.push_back(n.node->mMeshes[m]); // too small to simplify - shares the buffers of the original layer
+            }
+            if (!anySimplified)
+                break;
+            aiNode *lodNode = new aiNode(n.name.empty() ? string() : n.name + "_lod" + to_string(l + 1));
+            lodNode->mNumMeshes = unsigned int(meshIndices.size());
+            lodNode->mMeshes = new unsigned int[lodNode->mNumMeshes];
+            copy(meshIndices.begin(), meshIndices.end(), lodNode->mMeshes);
+            lodNodes.push_back(lodNode);
+            result.emplace_back(lodNode);
+            result.back().lodLevel = l + 1;
+        }
+        if (!lodNodes.empty())
+            n.node->addChildren(unsigned int(lodNodes.size()), lodNodes.data());
+    }
+    if (!lodMeshes.empty()) {
+        aiMesh **meshes = new aiMesh *[scene->mNumMeshes + lodMeshes.size()];
+        copy(scene->mMeshes, scene->mMeshes + scene->mNumMeshes, meshes);
+        copy(lodMeshes.begin(), lodMeshes.end(), meshes + scene->mNumMeshes);
+        delete[] scene->mMeshes;
+        scene->mMeshes = meshes;
+        scene->mNumMeshes += unsigned int(lodMeshes.size());
+    }
+    nodes = result;
 }
 
 unsigned int SamplerIndex(unsigned int argType) {
@@ -822,13 +1091,38 @@ void oimport(path const &out, path const &in) {
         sceneLoadingFlags |= aiProcess_CalcTangentSpace;
     if (inExt == ".fbx")
         sceneLoadingFlags |= aiProcess_JoinIdenticalVertices;
-    const aiScene *scene = importer.ReadFile(in.string(), sceneLoadingFlags);
+    // glTF files are read natively when possible, Assimp handles everything else
+    unique_ptr<aiScene> loadedScene;
+    if ((inExt == ".gltf" || inExt == ".glb") && !options().assimpGltf)
+        loadedScene = ReadGltfScene(in, sceneLoadingFlags, 32'767);
+    SceneCache sceneCache;
+    vector<path> sceneSideFiles;
+    bool useSceneCache = !loadedScene && !options().sceneCache.empty() && sceneCache.Init(options().sceneCache, in, sceneLoadingFlags, importer);
+    if (useSceneCache)
+        loadedScene = sceneCache.Load(sceneSideFiles);
+    const aiScene *scene = loadedScene.get();
+    if (!scene) {
+        auto sideFileRecorder = new SideFileRecorder(in);
+        importer.SetIOHandler(sideFileRecorder);
+        scene = importer.ReadFile(in.string(), sceneLoadingFlags);
+        sceneSideFiles = sideFileRecorder->SideFiles();
+        if (useSceneCache && scene && !(scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) && !sceneCache.Store(scene, sceneSideFiles))
+            InfoMessage("Unable to write scene cache for " + in.string());
+    }
+    // -incremental: side files read by Assimp (.mtl, external buffers...)
+    for (auto const &sideFile : sceneSideFiles)
+        globalVars().dependencies.push_back(sideFile);
     if (!scene)
         throw runtime_error("Unable to load scene");
     if (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)
         throw runtime_error("Unable to load a complete scene");
     if (!scene->mRootNode)
         throw runtime_error("Unable to find scene root node");
+    // generated LODs are added to the scene, so it must be owned here
+    if (!options().lods.empty() && !loadedScene) {
+        loadedScene.reset(importer.GetOrphanedScene());
+        scene = loadedScene.get();
+    }
     Node::scene = scene;
     // TODO: axis detection
 
@@ -882,6 +1176,9 @@ void oimport(path const &out, path const &in) {
     vector<Symbol> symbols;
     map<string, vector<unsigned int>> relocations;
     Modifiables modifiables;
+    GeometryPool geometryPool;
+    // -lods: meshes which can't be simplified are written again in the LOD layers and must point to the same buffers
+    geometryPool.enabled = options().shareGeometry || !options().lods.empty();
     unsigned int numVariations = 1;
     if (options().instances != 0)
         numVariations = options().instances;
@@ -908,37 +1205,39 @@ void oimport(path const &out, path const &in) {
     }
 
     NodeAddCallback(scene->mRootNode, nodes, stadExtra);
+    if (!options().lods.empty())
+        AddLodNodes(loadedScene.get(), nodes);
 
     unsigned int nodeCounter = 0;
     unsigned int meshCounter = 0;
     // generate node names for unnamed nodes
     unsigned int nextSortgroup = 0;
+    unordered_set<string> usedNodeNames; // lowered
+    for (auto const &n : nodes) {
+        if (!n.name.empty())
+            usedNodeNames.insert(ToLower(n.name));
+    }
     for (auto &n : nodes) {
         if (n.name.empty()) {
             string newname = "sortgroup" + to_string(nextSortgroup++);
-            while (nextSortgroup < 10'000) {
-                bool exists = false;
-                for (auto const &nn : nodes) {
-                    if (ToLower(nn.name) == newname) {
-                        exists = true;
-                        break;
-                    }
-                }
-                if (!exists)
-                    break;
+            while (nextSortgroup < 10'000 && usedNodeNames.contains(newname))
                 newname = "sortgroup" + to_string(nextSortgroup++);
-            }
+            usedNodeNames.insert(newname);
             n.name = newname;
         }
     }
+    if (options().sortByAlpha) {
+        for (auto &n : nodes)
+            n.hasTransparency = n.HasTransparency();
+    }
     if (options().sortByName) {
         if (options().sortByAlpha)
-            sort(nodes.begin(), nodes.end(), Node::SortByNameAndAlpha);
+            stable_sort(nodes.begin(), nodes.end(), Node::SortByNameAndAlpha);
         else
-            sort(nodes.begin(), nodes.end(), Node::SortByName);
+            stable_sort(nodes.begin(), nodes.end(), Node::SortByName);
     }
     else if (options().sortByAlpha)
-        sort(nodes.begin(), nodes.end(), Node::SortByAlpha);
+        stable_sort(nodes.begin(), nodes.end(), Node::SortByAlpha);
 
     map<string, string> generatedTexNames; // key: lowered original filename, value - 4-byte name
     if (options().genTexNames && scene->mNumMaterials) {
@@ -1312,7 +1611,7 @@ void oimport(path const &out, path const &in) {
             isMeshSkinned = shader->HasAttribute(Shader::BlendWeight) && shader->HasAttribute(Shader::BlendIndices) && shader->HasAttribute(Shader::Color1);
             bool useSkinning = !uvSkinning.empty() || (isMeshSkinned && meshHasBones);
             
-            vector<VertexWeightInfo> allMeshesVertexWeights;
+            VertexWeights allMeshesVertexWeights;
             if (useSkinning) {
                 if (!hasSkeleton)
                     hasSkeleton = true;
@@ -1381,66 +1680,33 @@ void oimport(path const &out, path const &in) {
                     }
                 }
                 // Find weights for all vertices
-                allMeshesVertexWeights.resize(mesh->mNumVertices);
+                allMeshesVertexWeights.Resize(mesh->mNumVertices);
+                struct SourceBone { unsigned char index = 0; BoneTargets const *targets = nullptr; bool use = false; };
+                struct SourceWeight { unsigned int bone; float weight; };
+                vector<SourceBone> sourceBones(mesh->mNumBones);
+                vector<unsigned int> vertexWeightsStart(mesh->mNumVertices + 1, 0);
                 for (unsigned int b = 0; b < mesh->mNumBones; b++) {
                     aiBone *bone = mesh->mBones[b];
                     if (bone->mNumWeights > 1 || (bone->mNumWeights == 1 && bone->mWeights[0].mWeight > 0.0f)) {
                         if (bones.contains(bone->mNode->mName.C_Str())) {
                             auto const &boneInfo = bones[bone->mNode->mName.C_Str()];
-                            BoneTargets *targets = nullptr;
-                            bool use = true;
+                            auto &sb = sourceBones[b];
+                            sb.index = boneInfo.index;
+                            sb.use = true;
                             if (!options().boneRemap.empty()) {
                                 if (globalVars().boneRemap.contains(boneInfo.name))
-                                    targets = &globalVars().boneRemap[boneInfo.name];
+                                    sb.targets = &globalVars().boneRemap[boneInfo.name];
                                 else {
-                                    use = false; // false
+                                    sb.use = false; // false
                                     //throw runtime_error(Format("No remap info for bone %s", bone->mNode->mName.C_Str()));
                                     InfoMessage(Format("No remap info for bone %s (%d weights) in %s", bone->mNode->mName.C_Str(), bone->mNumWeights,
                                         in.string().c_str()));
                                 }
                             }
-                            if (use) {
+                            if (sb.use) {
                                 for (unsigned int w = 0; w < bone->mNumWeights; w++) {
-                                    if (bone->mWeights[w].mWeight > 0) {
-                                        auto &vw = allMeshesVertexWeights[bone->mWeights[w].mVertexId];
-                                        if (targets) {
-                                            auto const &targetBones = targets->targetBones;
-                                            for (auto const &tb : targetBones) {
-                                                float weight = bone->mWeights[w].mWeight * tb.factor;
-                                                bool found = false;
-                                                for (auto &b : vw.bones) {
-                                                    if (b.boneIndex == tb.boneIndex) {
-                                                        b.weight += weight;
-                                                        found = true;
-                                                        break;
-                                                    }
-                                                }
-                                                if (!found) {
-                                                    VertexBoneInfo vwi;
-                                                    vwi.weight = weight;
-                                                    vwi.boneIndex = tb.boneIndex;
-                                                    vw.bones.push_back(vwi);
-                                                }
-                                            }
-                                        }
-                                        else {
-                                            float weight = bone->mWeights[w].mWeight;
-                                            bool found = false;
-                                            for (auto &b : vw.bones) {
-                                                if (b.boneIndex == boneInfo.index) {
-                                                    b.weight += weight;
-                                                    found = true;
-                                                    break;
-                                                }
-                                            }
-                                            if (!found) {
-                                                VertexBoneInfo vwi;
-                                                vwi.weight = weight;
-                                                vwi.boneIndex = boneInfo.index;
-                                                vw.bones.push_back(vwi);
-                                            }
-                                        }
-                                    }
+                                    if (bone->mWeights[w].mWeight > 0)
+                                        vertexWeightsStart[bone->mWeights[w].mVertexId + 1]++;
                                 }
                             }
                         }
@@ -1448,6 +1714,56 @@ void oimport(path const &out, path const &in) {
                             throw runtime_error("Unable to find bone in bones array");
                     }
                 }
+                for (unsigned int v = 0; v < mesh->mNumVertices; v++)
+                    vertexWeightsStart[v + 1] += vertexWeightsStart[v];
+                // source weights grouped by vertex, in bone order
+                vector<SourceWeight> sourceWeights(vertexWeightsStart[mesh->mNumVertices]);
+                {
+                    vector<unsigned int> vertexWeightsPos(vertexWeightsStart.begin(), vertexWeightsStart.end() - 1);
+                    for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+                        if (sourceBones[b].use) {
+                            aiBone *bone = mesh->mBones[b];
+                            for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+                                if (bone->mWeights[w].mWeight > 0)
+                                    sourceWeights[vertexWeightsPos[bone->mWeights[w].mVertexId]++] = { b, bone->mWeights[w].mWeight };
+                            }
+                        }
+                    }
+                }
+                // accumulate into a fixed per-bone-index array, keeping the first-touch order
+                float vertexBoneWeights[256] = {};
+                bool vertexBoneUsed[256] = {};
+                unsigned char vertexBoneOrder[256];
+                vector<unsigned short> vertexTargets;
+                for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
+                    unsigned int numVertexBones = 0;
+                    auto AddWeight = [&](unsigned char boneIndex, float weight) {
+                        if (!vertexBoneUsed[boneIndex]) {
+                            vertexBoneUsed[boneIndex] = true;
+                            vertexBoneOrder[numVertexBones++] = boneIndex;
+                        }
+                        vertexBoneWeights[boneIndex] += weight;
+                    };
+                    for (unsigned int sw = vertexWeightsStart[v]; sw < vertexWeightsStart[v + 1]; sw++) {
+                        auto const &sb = sourceBones[sourceWeights[sw].bone];
+                        float weight = sourceWeights[sw].weight;
+                        if (sb.targets) {
+                            sb.targets->FindTargets(mesh->mVertices[v], vertexTargets);
+                            for (auto t : vertexTargets) {
+                                auto const &tb = sb.targets->targetBones[t];
+                                AddWeight(unsigned char(tb.boneIndex), weight * tb.factor);
+                            }
+                        }
+                        else
+                            AddWeight(sb.index, weight);
+                    }
+                    for (unsigned int vb = 0; vb < numVertexBones; vb++) {
+                        unsigned char boneIndex = vertexBoneOrder[vb];
+                        allMeshesVertexWeights.Add(v, boneIndex, vertexBoneWeights[boneIndex]);
+                        vertexBoneWeights[boneIndex] = 0.0f;
+                        vertexBoneUsed[boneIndex] = false;
+                    }
+                }
                 if (!uvSkinning.empty() && mesh->HasTextureCoords(0)) {
                     static set<string> shownBoneInfoMessages;
                     auto FindUVBoneByName = [&bones](string const &boneName, int &boneId) {
@@ -1474,102 +1790,61 @@ void oimport(path const &out, path const &in) {
                     int defaultBoneId = 0; // -1
                     if (!uvSkinningDefaultBone.empty())
                         FindUVBoneByName(uvSkinningDefaultBone, defaultBoneId);
-                    auto const &skinSet = UVSkinning::Instance().GetSkinSet(uvSkinning);
-                    if (!skinSet.empty()) {
+                    auto const &skinAtlas = UVSkinning::Instance().GetSkinAtlas(uvSkinning);
+                    for (auto const &skinFile : UVSkinning::Instance().GetSkinSetFiles(uvSkinning))
+                        globalVars().dependencies.push_back(skinFile);
+                    if (!skinAtlas.boneNames.empty()) {
+                        // atlas bone slot > bone index, resolved on first use (-2 - not resolved yet, -1 - not found)
+                        vector<int> atlasBoneIds(skinAtlas.boneNames.size(), -2);
+                        UVSkinning::UVSkinSample sample;
                         for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
-                            auto &vw = allMeshesVertexWeights[v];
-                            vw.bones.clear();
-                            for (auto const &[texMapName, texMap] : skinSet) {
-                                float weight = texMap.GetWeight(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y);
-                                if (weight > 0.0f) {
-                                    int texMapBoneId = 0;
-                                    if (FindUVBoneByName(texMapName, texMapBoneId)) {
-                                        VertexBoneInfo bi;
-                                        bi.boneIndex = (unsigned char)texMapBoneId;
-                                        bi.weight = weight;
-                                        vw.bones.push_back(bi);
+                            allMeshesVertexWeights.Clear(v);
+                            skinAtlas.Sample(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y, sample);
+                            unsigned int numSampledBones = 0;
+                            float totalBoneWeights = 0.0f;
+                            // with uvSkinningMode 1 the default bone is added last, after its weight is completed to 1
+                            bool hasDefaultBone = false;
+                            float defaultBoneWeight = 0.0f;
+                            for (unsigned int sb = 0; sb < sample.numBones; sb++) {
+                                if (sample.weights[sb] > 0.0f) {
+                                    int &texMapBoneId = atlasBoneIds[sample.bones[sb]];
+                                    if (texMapBoneId == -2) {
+                                        int boneId = 0;
+                                        texMapBoneId = FindUVBoneByName(skinAtlas.boneNames[sample.bones[sb]], boneId) ? boneId : -1;
+                                    }
+                                    if (texMapBoneId != -1) {
+                                        numSampledBones++;
+                                        totalBoneWeights += sample.weights[sb];
+                                        if (uvSkinningMode == 1 && !hasDefaultBone && defaultBoneId != -1 && (unsigned char)texMapBoneId == defaultBoneId) {
+                                            hasDefaultBone = true;
+                                            defaultBoneWeight = sample.weights[sb];
+                                        }
+                                        else
+                                            allMeshesVertexWeights.Add(v, (unsigned char)texMapBoneId, sample.weights[sb]);
                                     }
                                 }
-                                //::Warning("Vertex [%g,%g] bone %s weight %g", mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y, texMapName.c_str(), weight);
                             }
-                            if (vw.bones.empty()) {
-                                if (defaultBoneId != -1) {
-                                    VertexBoneInfo bi;
-                                    bi.boneIndex = (unsigned char)defaultBoneId;
-                                    bi.weight = 1.0;
-                                    vw.bones.push_back(bi);
-                                }
+                            if (numSampledBones == 0) {
+                                if (defaultBoneId != -1)
+                                    allMeshesVertexWeights.Add(v, (unsigned char)defaultBoneId, 1.0f);
                             }
                             else if (uvSkinningMode == 1) {
-                                float totalBoneWeights = 0.0f;
-                                VertexBoneInfo *pDefaultBone = nullptr;
-                                for (auto &b : vw.bones) {
-                                    totalBoneWeights += b.weight;
-                                    if (!pDefaultBone && defaultBoneId != -1 && b.boneIndex == defaultBoneId)
-                                        pDefaultBone = &b;
-                                }
                                 if (totalBoneWeights < (1.0f - 0.05f)) {
-                                    if (pDefaultBone)
-                                        pDefaultBone->weight += (1.0 - totalBoneWeights);
+                                    if (hasDefaultBone)
+                                        defaultBoneWeight += (1.0 - totalBoneWeights);
                                     else if (defaultBoneId != -1) {
-                                        VertexBoneInfo bi;
-                                        bi.boneIndex = defaultBoneId;
-                                        bi.weight = (1.0 - totalBoneWeights);
-                                        vw.bones.push_back(bi);
+                                        hasDefaultBone = true;
+                                        defaultBoneWeight = (1.0 - totalBoneWeights);
                                     }
                                 }
+                                if (hasDefaultBone)
+                                    allMeshesVertexWeights.Add(v, (unsigned char)defaultBoneId, defaultBoneWeight);
                             }
                         }
                     }
                 }
-                // Sort weights in vertices
-                for (auto &vw : allMeshesVertexWeights) {
-                    if (vw.bones.empty()) {
-                        VertexBoneInfo bi;
-                        bi.boneIndex = 0;
-                        bi.weight = 1.0f;
-                        vw.bones.push_back(bi);
-                    }
-                    if (vw.bones.size() > 1)
-                        sort(vw.bones.begin(), vw.bones.end());
-                    if (vw.bones.size() > maxBones)
-                        vw.bones.resize(maxBones);
-                    float totalBoneWeights = 0.0f;
-                    for (auto &b : vw.bones)
-                        totalBoneWeights += b.weight;
-                    if (totalBoneWeights != 1.0f) {
-                        for (auto &b : vw.bones)
-                            b.weight /= totalBoneWeights;
-                    }
-                    if (options().vertexWeightPaletteSize > 0) {
-                        if (options().vertexWeightPaletteSize == 1) {
-                            for (auto &b : vw.bones)
-                                b.weight = 1.0f;
-                        }
-                        else {
-                            VertexWeightInfo newvw;
-                            for (VertexBoneInfo b : vw.bones) {
-                                b.weight = floor(b.weight * options().vertexWeightPaletteSize);
-                                if (b.weight > 0.0f)
-                                    newvw.bones.push_back(b);
-                            }
-                            if (newvw.bones.empty()) {
-                                VertexBoneInfo bi;
-                                bi.boneIndex = vw.bones[0].boneIndex;
-                                bi.weight = 1.0f;
-                                newvw.bones.push_back(bi);
-                            }
-                            vw = newvw;
-                        }
-                        totalBoneWeights = 0.0f;
-                        for (auto &b : vw.bones)
-                            totalBoneWeights += b.weight;
-                        if (totalBoneWeights != 1.0f) {
-                            for (auto &b : vw.bones)
-                                b.weight /= totalBoneWeights;
-                        }
-                    }
-                }
+                allMeshesVertexWeights.Finalize(maxBones, options().vertexWeightPaletteSize);
+                allMeshesVertexWeights.BuildKeys();
             }
 
             unsigned int vertexSize = shader->VertexSize();
@@ -1636,8 +1911,7 @@ void oimport(path const &out, path const &in) {
                         unsigned int maxNumBoneWeightsToAdd = target->GetMaxVertexWeightsPerMesh() - numBoneWeights;
                         unsigned int numWeightsToAdd = 0;
                         for (unsigned int ind = 0; ind < 3; ind++) {
-                            VertexWeightInfoLayout vwl(allMeshesVertexWeights[tri[ind]]);
-                            if (!meshes.back().weightsMap.contains(vwl)) {
+                            if (!meshes.back().weightsMap.contains(allMeshesVertexWeights.keys[tri[ind]])) {
                                 numWeightsToAdd++;
                                 if (numWeightsToAdd > maxNumBoneWeightsToAdd) {
                                     meshes.back().numFaces = f - meshes.back().startFace;
@@ -1648,10 +1922,8 @@ void oimport(path const &out, path const &in) {
                             }
                         }
                     }
-                    for (unsigned int ind = 0; ind < 3; ind++) {
-                        VertexWeightInfoLayout vwl(allMeshesVertexWeights[tri[ind]]);
-                        meshes.back().weightsMap[vwl].push_back(tri[ind]);
-                    }
+                    for (unsigned int ind = 0; ind < 3; ind++)
+                        meshes.back().weightsMap[allMeshesVertexWeights.keys[tri[ind]]].push_back(tri[ind]);
                 }
                 for (unsigned int ind = 0; ind < 3; ind++)
                     meshes.back().verticesMap[tri[ind]] = 0;
@@ -1689,8 +1961,18 @@ void oimport(path const &out, path const &in) {
                 unsigned int vertexWeightsNumBones2 = 0;
                 unsigned int vertexWeightsNumBones1 = 0;
 
-                // generate tristrips
-                if (options().tristrip) {
+                // generate tristrips; copies of a mesh reuse the strips of the first one
+                vector<unsigned short> const *cachedStrip = options().tristrip ? geometryPool.FindStrip(indexBuffer) : nullptr;
+                if (cachedStrip) {
+                    indexBuffer = *cachedStrip;
+                    numIndices = unsigned int(indexBuffer.size());
+                    numFaces = numIndices - 2;
+                    indexBufferSize = indexSize * numIndices;
+                }
+                else if (options().tristrip) {
+                    vector<unsigned short> sourceIndices;
+                    if (geometryPool.enabled)
+                        sourceIndices = indexBuffer;
                     SetListsOnly(false);
                     SetCacheSize(CACHESIZE_GEFORCE3);
                     PrimitiveGroup *prims = nullptr;
@@ -1702,6 +1984,7 @@ void oimport(path const &out, path const &in) {
                     indexBuffer.resize(numIndices);
                     Memory_Copy(indexBuffer.data(), prims[0].indices, indexBufferSize);
                     delete[] prims;
+                    geometryPool.AddStrip(sourceIndices, indexBuffer);
                 }
 
                 vector<VertexWeightInfoLayout> skinVertexWeights;
@@ -1711,7 +1994,8 @@ void oimport(path const &out, path const &in) {
                     skinVertexWeights.resize(m.weightsMap.size());
                     skinVertexWeightsIndices.resize(numVertices);
                     unsigned int weightInfoIndex = 0;
-                    for (auto const &[w, vertIndices] : m.weightsMap) {
+                    for (auto const &[key, vertIndices] : m.weightsMap) {
+                        VertexWeightInfoLayout const &w = allMeshesVertexWeights.layouts[key];
                         skinVertexWeights[weightInfoIndex] = w;
                         if (w.numBones == 3)
                             vertexWeightsNumBones3++;
@@ -1729,173 +2013,147 @@ void oimport(path const &out, path const &in) {
                         weightInfoIndex++;
                     }
                 }
-                unsigned int vertexDataOffset = 0;
-                for (auto const &[v, vi] : m.verticesMap) {
-                    unsigned int vertexOffset = vertexDataOffset;
-                    for (auto const &d : shader->declaration) {
-                        switch (d.usage) {
-                        case Shader::Position:
-                            if (d.type == Shader::Float3 && mesh->mVertices) {
-                                aiVector3D vecPos = mesh->mVertices[v];
-                                if (doScale && options().scaleXYZ) {
-                                    vecPos.x *= options().scale.x;
-                                    vecPos.y *= options().scale.y;
-                                    vecPos.z *= options().scale.z;
-                                }
-                                if (doTranslate) {
-                                    vecPos.x += options().translate.x;
-                                    vecPos.y += options().translate.y;
-                                    vecPos.z += options().translate.z;
-                                }
-                                if (flipAxis)
-                                    swap(vecPos.y, vecPos.z);
-                                Memory_Copy(&vertexBuffer.data()[vertexOffset], &vecPos, 12);
-                                ProcessBoundBox(n.boundMin, n.boundMax, n.anyVertexProcessed, vecPos);
-                            }
-                            break;
-                        case Shader::Normal:
-                            if (d.type == Shader::Float3 && mesh->mNormals) {
-                                aiVector3D vecNormal = mesh->mNormals[v];
-                                if (flipAxis)
-                                    swap(vecNormal.y, vecNormal.z);
-                                if (options().flipNormals)
-                                    vecNormal = -vecNormal;
-                                Memory_Copy(&vertexBuffer.data()[vertexOffset], &vecNormal, 12);
+                // encode attribute by attribute; vertex vi of the buffer comes from mesh vertex sourceVertices[vi]
+                vector<unsigned int> sourceVertices;
+                sourceVertices.reserve(numVertices);
+                for (auto const &[v, vi] : m.verticesMap)
+                    sourceVertices.push_back(v);
+                for (auto const &e : GetVertexLayout(*shader).elements) {
+                    unsigned char *dst = &vertexBuffer.data()[e.offset];
+                    switch (e.attribute) {
+                    case VertexLayout::Position:
+                        if (mesh->mVertices) {
+                            PositionTransform transform;
+                            transform.scale = doScale && options().scaleXYZ;
+                            transform.translate = doTranslate;
+                            transform.swapYZ = flipAxis;
+                            transform.scaleValue = { options().scale.x, options().scale.y, options().scale.z };
+                            transform.translateValue = { options().translate.x, options().translate.y, options().translate.z };
+                            Bounds primBounds;
+                            EncodePositions(dst, vertexSize, mesh->mVertices, sourceVertices, transform, primBounds);
+                            n.bounds.Merge(primBounds);
+                        }
+                        break;
+                    case VertexLayout::Normal:
+                        if (mesh->mNormals)
+                            EncodeNormals(dst, vertexSize, mesh->mNormals, sourceVertices, flipAxis, options().flipNormals);
+                        break;
+                    case VertexLayout::Color:
+                    {
+                        vector<aiColor4D> colors(numVertices);
+                        bool colorPostProcess = false;
+                        // a source layer in buffer order; -srgb converts the whole layer in one pass, before merging and scaling
+                        auto GetMeshVCols = [&](unsigned int index, vector<aiColor4D> &out) {
+                            out.resize(numVertices);
+                            for (unsigned int vi = 0; vi < numVertices; vi++) {
+                                out[vi] = mesh->mColors[index][sourceVertices[vi]];
+                                swap(out[vi].r, out[vi].b);
                             }
-                            break;
-                        case Shader::Color0:
-                            if (d.type == Shader::D3DColor || d.type == Shader::UByte4) {
-                                aiColor4D vertexColor;
-                                if (tangents) {
-                                    if (mesh->mTangents) {
-                                        vertexColor = { mesh->mTangents[v].x, mesh->mTangents[v].y, mesh->mTangents[v].z, 1.0f };
-                                        for (unsigned int ci = 0; ci < 3; ci++)
-                                            vertexColor[ci] = (clamp(vertexColor[ci], -1.0f, 1.0f) + 1.0f) / 2.0f;
-                                    }
-                                    else
-                                        vertexColor = { 0.5f, 0.5f, 0.5f, 1.0f };
+                            if (options().srgb && numVertices)
+                                SrgbTransform::linearToSrgbStream(&out[0].r, numVertices, 4, 3);
+                        };
+                        if (tangents) {
+                            if (mesh->mTangents) {
+                                for (unsigned int vi = 0; vi < numVertices; vi++) {
+                                    auto const &t = mesh->mTangents[sourceVertices[vi]];
+                                    colors[vi] = { t.x, t.y, t.z, 1.0f };
+                                    for (unsigned int ci = 0; ci < 3; ci++)
+                                        colors[vi][ci] = (clamp(colors[vi][ci], -1.0f, 1.0f) + 1.0f) / 2.0f;
                                 }
-                                else if (options().hasSetVCol)
-                                    vertexColor = options().setVCol;
-                                else {
-                                    auto GetMeshVCol = [](aiMesh *colMesh, unsigned int index, unsigned int vertexId, bool swapRB, bool srgb) {
-                                        aiColor4D out = colMesh->mColors[index][vertexId];
-                                        if (swapRB)
-                                            swap(out.r, out.b);
-                                        if (srgb) {
-                                            for (unsigned int ci = 0; ci < 3; ci++)
-                                                out[ci] = SrgbTransform::linearToSrgb(out[ci]);
-                                        }
-                                        return out;
-                                    };
-                                    bool colorPostProcess = true;
-                                    if (options().mergeVCols) {
-                                        bool hasVColMergeConfig = !options().vColMergeConfig.empty();
-                                        vertexColor = { 1.0f, 1.0f, 1.0f, 1.0f };
-                                        unsigned int startColIndex = hasVColMergeConfig ? 0 : 1;
-                                        unsigned int endColIndex = hasVColMergeConfig ? options().vColMergeConfig.size() : AI_MAX_NUMBER_OF_COLOR_SETS;
-                                        for (unsigned int colIndex = 0; colIndex < AI_MAX_NUMBER_OF_COLOR_SETS; colIndex++) {
-                                            if (numColors > colIndex &&mesh->HasVertexColors(colIndex) && mesh->mColors[colIndex]) {
-                                                bool colIndexUsed = hasVColMergeConfig ? options().vColMergeConfig.contains(colIndex) : true;
-                                                if (colIndexUsed) {
-                                                    auto vColLayer = GetMeshVCol(mesh, colIndex, v, true, options().srgb);
-                                                    if (hasVColMergeConfig) {
-                                                        auto const &config = options().vColMergeConfig[colIndex];
-                                                        vColLayer = config.bottomRange + vColLayer * (config.topRange - config.bottomRange);
-                                                    }
-                                                    for (unsigned int clrComp = 0; clrComp < 4; clrComp++)
-                                                        vertexColor[clrComp] *= vColLayer[clrComp];
-                                                }
-                                            }
-                                        }
-                                    }
-                                    else {
-                                        if (numColors > 0 && mesh->HasVertexColors(0) && mesh->mColors[0])
-                                            vertexColor = GetMeshVCol(mesh, 0, v, true, options().srgb);
-                                        else {
-                                            if (options().hasDefaultVCol)
-                                                vertexColor = options().defaultVCol;
-                                            else
-                                                vertexColor = DEFAULT_COLOR;
-                                            colorPostProcess = false;
-                                        }
-                                    }
-                                    if (colorPostProcess) {                                        
-                                        if (options().vColScale != 0.0f) {
-                                            vertexColor.r *= options().vColScale;
-                                            vertexColor.g *= options().vColScale;
-                                            vertexColor.b *= options().vColScale;
-                                        }
-                                        if (options().hasMinVCol) {
-                                            if (vertexColor.r < options().minVCol.r)
-                                                vertexColor.r = options().minVCol.r;
-                                            if (vertexColor.g < options().minVCol.g)
-                                                vertexColor.g = options().minVCol.g;
-                                            if (vertexColor.b < options().minVCol.b)
-                                                vertexColor.b = options().minVCol.b;
-                                        }
-                                        if (options().hasMaxVCol) {
-                                            if (vertexColor.r > options().maxVCol.r)
-                                                vertexColor.r = options().maxVCol.r;
-                                            if (vertexColor.g > options().maxVCol.g)
-                                                vertexColor.g = options().maxVCol.g;
-                                            if (vertexColor.b > options().maxVCol.b)
-                                                vertexColor.b = options().maxVCol.b;
-                                        }
+                            }
+                            else
+                                fill(colors.begin(), colors.end(), aiColor4D(0.5f, 0.5f, 0.5f, 1.0f));
+                        }
+                        else if (options().hasSetVCol)
+                            fill(colors.begin(), colors.end(), options().setVCol);
+                        else if (options().mergeVCols) {
+                            bool hasVColMergeConfig = !options().vColMergeConfig.empty();
+                            fill(colors.begin(), colors.end(), aiColor4D(1.0f, 1.0f, 1.0f, 1.0f));
+                            vector<aiColor4D> layerColors;
+                            for (unsigned int colIndex = 0; colIndex < AI_MAX_NUMBER_OF_COLOR_SETS; colIndex++) {
+                                if (numColors > colIndex && mesh->HasVertexColors(colIndex) && mesh->mColors[colIndex]) {
+                                    if (hasVColMergeConfig && !options().vColMergeConfig.contains(colIndex))
+                                        continue;
+                                    VColMergeLayerConfig config;
+                                    if (hasVColMergeConfig)
+                                        config = options().vColMergeConfig[colIndex];
+                                    GetMeshVCols(colIndex, layerColors);
+                                    for (unsigned int vi = 0; vi < numVertices; vi++) {
+                                        auto vColLayer = layerColors[vi];
+                                        if (hasVColMergeConfig)
+                                            vColLayer = config.bottomRange + vColLayer * (config.topRange - config.bottomRange);
+                                        for (unsigned int clrComp = 0; clrComp < 4; clrComp++)
+                                            colors[vi][clrComp] *= vColLayer[clrComp];
                                     }
                                 }
-                                if (options().useMatColor) {
-                                    if (hasMatColor) {
-                                        vertexColor.r *= matColor.r;
-                                        vertexColor.g *= matColor.g;
-                                        vertexColor.b *= matColor.b;
-                                    }
-                                    if (hasMatAlpha)
-                                        vertexColor.a *= matAlpha;
+                            }
+                            colorPostProcess = true;
+                        }
+                        else if (numColors > 0 && mesh->HasVertexColors(0) && mesh->mColors[0]) {
+                            GetMeshVCols(0, colors);
+                            colorPostProcess = true;
+                        }
+                        else
+                            fill(colors.begin(), colors.end(), options().hasDefaultVCol ? options().defaultVCol : DEFAULT_COLOR);
+                        if (colorPostProcess) {
+                            if (options().vColScale != 0.0f) {
+                                float vColScale = options().vColScale;
+                                for (auto &c : colors) {
+                                    c.r *= vColScale;
+                                    c.g *= vColScale;
+                                    c.b *= vColScale;
                                 }
-                                unsigned char rgba[4];
-                                for (unsigned int clr = 0; clr < 4; clr++)
-                                    rgba[clr] = unsigned char(clamp(vertexColor[clr], 0.0f, 1.0f) * 255);
-                                Memory_Copy(&vertexBuffer.data()[vertexOffset], rgba, 4);
                             }
-                            break;
-                        case Shader::Color1:
-                            if (useSkinning)
-                                Memory_Copy(&vertexBuffer.data()[vertexOffset], &skinVertexWeightsIndices.data()[vi], 4);
-                            break;
-                        case Shader::Texcoord0:
-                            if (d.type == Shader::Float2) {
-                                unsigned int channel = 0;
-                                if (numTexCoords > channel && mesh->mTextureCoords[channel])
-                                    Memory_Copy(&vertexBuffer.data()[vertexOffset], &mesh->mTextureCoords[channel][v], 8);
+                            if (options().hasMinVCol) {
+                                aiColor4D minVCol = options().minVCol;
+                                for (auto &c : colors) {
+                                    c.r = max(c.r, minVCol.r);
+                                    c.g = max(c.g, minVCol.g);
+                                    c.b = max(c.b, minVCol.b);
+                                }
                             }
-                            break;
-                        case Shader::Texcoord1:
-                            if (d.type == Shader::Float2) {
-                                unsigned int channel = 1;
-                                if (numTexCoords <= channel || !mesh->mTextureCoords[channel])
-                                    channel = 0;
-                                if (numTexCoords > channel && mesh->mTextureCoords[channel])
-                                    Memory_Copy(&vertexBuffer.data()[vertexOffset], &mesh->mTextureCoords[channel][v], 8);
+                            if (options().hasMaxVCol) {
+                                aiColor4D maxVCol = options().maxVCol;
+                                for (auto &c : colors) {
+                                    c.r = min(c.r, maxVCol.r);
+                                    c.g = min(c.g, maxVCol.g);
+                                    c.b = min(c.b, maxVCol.b);
+                                }
                             }
-                            break;
-                        case Shader::Texcoord2:
-                            if (d.type == Shader::Float2) {
-                                unsigned int channel = 2;
-                                if (numTexCoords <= channel || !mesh->mTextureCoords[channel])
-                                    channel = 0;
-                                if (numTexCoords > channel && mesh->mTextureCoords[channel])
-                                    Memory_Copy(&vertexBuffer.data()[vertexOffset], &mesh->mTextureCoords[channel][v], 8);
+                        }
+                        if (options().useMatColor && (hasMatColor || hasMatAlpha)) {
+                            for (auto &c : colors) {
+                                if (hasMatColor) {
+                                    c.r *= matColor.r;
+                                    c.g *= matColor.g;
+                                    c.b *= matColor.b;
+                                }
+                                if (hasMatAlpha)
+                                    c.a *= matAlpha;
                             }
-                            break;
-                        case Shader::BlendIndices:
-                            break;
-                        case Shader::BlendWeight:
-                            break;
                         }
-                        vertexOffset += d.Size();
+                        for (unsigned int vi = 0; vi < numVertices; vi++) {
+                            unsigned char *rgba = &dst[vi * vertexSize];
+                            for (unsigned int clr = 0; clr < 4; clr++)
+                                rgba[clr] = unsigned char(clamp(colors[vi][clr], 0.0f, 1.0f) * 255);
+                        }
+                    }
+                    break;
+                    case VertexLayout::SkinIndex:
+                        if (useSkinning && skinVertexWeightsIndices.size() == numVertices)
+                            EncodeUInt32(dst, vertexSize, skinVertexWeightsIndices.data(), numVertices);
+                        break;
+                    case VertexLayout::Texcoord:
+                    {
+                        // missing channels 1 and 2 fall back to channel 0
+                        unsigned int channel = e.channel;
+                        if (channel != 0 && (numTexCoords <= channel || !mesh->mTextureCoords[channel]))
+                            channel = 0;
+                        if (numTexCoords > channel && mesh->mTextureCoords[channel])
+                            EncodeTexcoords(dst, vertexSize, mesh->mTextureCoords[channel], sourceVertices);
+                    }
+                    break;
                     }
-                    vertexDataOffset += vertexSize;
                 }
                 vector<GlobalArg> globalArgs;
                 for (auto const &arg : shader->globalArguments) {
@@ -1915,16 +2173,12 @@ void oimport(path const &out, path const &in) {
                     }
                     break;
                     case Shader::VertexData:
-                        vertexBufferOffset = bufData.Position();
-                        globalArgs.emplace_back(bufData.Position(), numVertices);
-                        bufData.Put(vertexBuffer.data(), vertexBufferSize);
-                        bufData.Put(ONE);
+                        vertexBufferOffset = geometryPool.Put(bufData, vertexBuffer.data(), vertexBufferSize);
+                        globalArgs.emplace_back(vertexBufferOffset, numVertices);
                         break;
                     case Shader::IndexData:
-                        indexBufferOffset = bufData.Position();
-                        globalArgs.emplace_back(bufData.Position(), numIndices);
-                        bufData.Put(indexBuffer.data(), indexBufferSize);
-                        bufData.Put(ONE);
+                        indexBufferOffset = geometryPool.Put(bufData, indexBuffer.data(), indexBufferSize);
+                        globalArgs.emplace_back(indexBufferOffset, numIndices);
                         break;
                     case Shader::VertexSkinData:
                         globalArgs.emplace_back(bufData.Position(), skinVertexWeights.size());
@@ -2595,22 +2849,18 @@ void oimport(path const &out, path const &in) {
             }
         }
         if (options().bboxScale != 0.0f && options().bboxScale != 1.0f)
-            ScaleBoundBox(n.boundMin, n.boundMax);
+            n.bounds.Scale(options().bboxScale);
         nodeCounter++;
     }
     // BBOX
     //Error("%d %d", bufData.Position(), bufData.Capacity());
     bufData.Align(16);
     symbols.emplace_back("__BBOX:::" + modelName + ".tagged", bufData.Position());
-    aiVector3D boundMin = { 0.0f, 0.0f, 0.0f };
-    aiVector3D boundMax = { 0.0f, 0.0f, 0.0f };
-    bool anyNodeProcessed = false;
-    for (auto const &n : nodes) {
-        if (n.anyVertexProcessed) {
-            ProcessBoundBox(boundMin, boundMax, anyNodeProcessed, n.boundMin);
-            ProcessBoundBox(boundMin, boundMax, anyNodeProcessed, n.boundMax);
-        }
-    }
+    Bounds modelBounds;
+    for (auto const &n : nodes)
+        modelBounds.Merge(n.bounds);
+    aiVector3D boundMin = modelBounds.min;
+    aiVector3D boundMax = modelBounds.max;
     bufData.Put(boundMin);
     bufData.Put(boundMax);
     // Skeleton
@@ -2869,20 +3119,16 @@ void oimport(path const &out, path const &in) {
         bufData.Put(options().layerFlags);
         for (auto const &n : nodes) {
             bufData.Put<unsigned short>(ONE); // TODO
-            bufData.Put<unsigned short>(ONE);
+            bufData.Put<unsigned short>(n.lodLevel == 0 ? ONE : ZERO); // visibility
         }
         // Model layer boundings
         for (auto const &n : nodes) {
-            bufData.Put(n.boundMin);
+            bufData.Put(n.bounds.min);
             bufData.Put(FONE);
-            bufData.Put(n.boundMax);
+            bufData.Put(n.bounds.max);
             bufData.Put(FONE);
-            aiVector3D nodeVecCenter = n.boundMax - n.boundMin;
-            float nodeBoundRadius = nodeVecCenter.Length() / 2;
-            nodeVecCenter /= 2;
-            nodeVecCenter += n.boundMin;
-            bufData.Put(nodeVecCenter);
-            bufData.Put(nodeBoundRadius);
+            bufData.Put(n.bounds.Center());
+            bufData.Put(n.bounds.radius);
         }
         // Model
         auto modelSymbolName = "__Model:::" + modelName + ".tagged";
@@ -2909,12 +3155,8 @@ void oimport(path const &out, path const &in) {
         bufData.Put(FONE);
         bufData.Put(boundMax);
         bufData.Put(FONE);
-        aiVector3D modelVecCenter = boundMax - boundMin;
-        float boundRadius = modelVecCenter.Length() / 2;
-        modelVecCenter /= 2;
-        modelVecCenter += boundMin;
-        bufData.Put(modelVecCenter);
-        bufData.Put(boundRadius);
+        bufData.Put(modelBounds.Center());
+        bufData.Put(modelBounds.radius);
         bufData.Put(nodes.size());
         relocations[""].push_back(bufData.Position());
         bufData.Put(layersNamesOffsetsOffset);
@@ -3263,29 +3505,33 @@ void oimport(path const &out, path const &in) {
                         colNodes.push_back(stadExtra.collision->mChildren[c]);
                 }
             }
+            struct CollPrimitive {
+                unsigned int verts[3];
+                unsigned int normal;
+                bool isLine;
+                aiVector3D center;
+            };
+            // per-geometry limits of the collision format (counts are stored as 16-bit values)
+            const unsigned int maxCollCount = 0xFFFF;
+            unsigned int maxCollTriangles = maxCollCount;
+            if (options().collisionChunkTriangles != 0 && options().collisionChunkTriangles < maxCollTriangles)
+                maxCollTriangles = options().collisionChunkTriangles;
             BinaryBuffer colFile;
             colFile.Put<unsigned int>(2);
             colFile.Put<unsigned int>(0);
-            colFile.Put<unsigned int>(colNodes.size());
+            colFile.Put<unsigned int>(0);
+            unsigned int numColGeometries = 0;
             for (unsigned int n = 0; n < colNodes.size(); n++) {
                 auto const &node = colNodes[n];
-                map<aiVector3D, unsigned int> uniquePos;
-                map<aiVector3D, unsigned int> uniqueNormal;
-                vector<CollTriangle> triangles;
-                vector<CollLine> lines;
-                auto AddCollVert = [](map<aiVector3D, unsigned int> &uniqueMap, aiVector3D const &collVec) {
-                    auto it = uniqueMap.find(collVec);
-                    if (it == uniqueMap.end()) {
-                        unsigned int newId = uniqueMap.size();
-                        uniqueMap[collVec] = newId;
-                        return newId;
-                    }
-                    return (*it).second;
-                };
+                CollWelder uniquePos(options().collisionWeld);
+                CollWelder uniqueNormal(0.0f);
+                vector<CollPrimitive> prims;
                 for (unsigned int m = 0; m < node->mNumMeshes; m++) {
                     auto const &mesh = scene->mMeshes[node->mMeshes[m]];
                     for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
                         auto const &face = mesh->mFaces[f];
+                        if (face.mNumIndices != 3)
+                            continue;
                         aiVector3D triPos[3];
                         for (unsigned int v = 0; v < 3; v++) {
                             triPos[v] = mesh->mVertices[face.mIndices[v]];
@@ -3300,74 +3546,154 @@ void oimport(path const &out, path const &in) {
                                 triPos[v].z += options().translate.z;
                             }
                         }
-                        if (triPos[0] == triPos[1] || triPos[1] == triPos[2]) {
-                            if (triPos[0] != triPos[2]) {
-                                CollLine line;
-                                line.vertPos[0] = AddCollVert(uniquePos, triPos[0]);
-                                line.vertPos[1] = AddCollVert(uniquePos, triPos[0] == triPos[1] ? triPos[2] : triPos[1]);
-                                lines.push_back(line);
-                            }
+                        CollPrimitive prim;
+                        for (unsigned int v = 0; v < 3; v++)
+                            prim.verts[v] = uniquePos.Add(triPos[v]);
+                        if (prim.verts[0] == prim.verts[1] || prim.verts[1] == prim.verts[2] || prim.verts[0] == prim.verts[2]) {
+                            if (prim.verts[0] == prim.verts[1] && prim.verts[1] == prim.verts[2])
+                                continue;
+                            prim.isLine = true;
+                            prim.normal = 0;
+                            if (prim.verts[0] == prim.verts[1])
+                                prim.verts[1] = prim.verts[2];
+                            prim.center = (triPos[0] + triPos[1] + triPos[2]) / 3.0f;
                         }
                         else {
-                            CollTriangle triangle;
-                            for (unsigned int v = 0; v < 3; v++)
-                                triangle.vertPos[v] = AddCollVert(uniquePos, triPos[v]);
                             aiVector3D normal;
                             aiVector3D a = triPos[1] - triPos[0];
                             aiVector3D b = triPos[2] - triPos[0];
                             normal.x = a.y * b.z - a.z * b.y;
                             normal.y = a.z * b.x - a.x * b.z;
                             normal.z = a.x * b.y - a.y * b.x;
-                            normal = normal.NormalizeSafe();
-                            triangle.normal = AddCollVert(uniqueNormal, normal);
-                            triangles.push_back(triangle);
+                            prim.isLine = false;
+                            prim.normal = uniqueNormal.Add(QuantizeCollNormal(normal.NormalizeSafe()));
+                            prim.center = (triPos[0] + triPos[1] + triPos[2]) / 3.0f;
                         }
+                        prims.push_back(prim);
                     }
                 }
-                vector<aiVector3D> positions(uniquePos.size());
-                vector<aiVector3D> normals(uniqueNormal.size());
-                aiVector3D min, max;
-                bool isFirstVec = true;
-                for (auto const &i : uniquePos) {
-                    positions[i.second] = i.first;
-                    if (isFirstVec) {
-                        min = i.first;
-                        max = i.first;
-                        isFirstVec = false;
+                if (prims.empty()) {
+                    // an empty geometry, as written for nodes without triangles before
+                    if (!options().collisionSkipEmpty) {
+                        colFile.Put(aiVector3D(0.0f, 0.0f, 0.0f));
+                        colFile.Put(aiVector3D(0.0f, 0.0f, 0.0f));
+                        for (unsigned int c = 0; c < 4; c++)
+                            colFile.Put(unsigned short(0));
+                        numColGeometries++;
                     }
-                    else {
-                        if (i.first.x < min.x)
-                            min.x = i.first.x;
-                        if (i.first.y < min.y)
-                            min.y = i.first.y;
-                        if (i.first.z < min.z)
-                            min.z = i.first.z;
-                        if (i.first.x > max.x)
-                            max.x = i.first.x;
-                        if (i.first.y > max.y)
-                            max.y = i.first.y;
-                        if (i.first.z > max.z)
-                            max.z = i.first.z;
+                    continue;
+                }
+                // split the node into spatially coherent chunks which fit the format limits
+                vector<unsigned int> posStamp(uniquePos.points.size(), UINT_MAX);
+                vector<unsigned int> normalStamp(uniqueNormal.points.size(), UINT_MAX);
+                vector<unsigned int> posLocal(uniquePos.points.size());
+                vector<unsigned int> normalLocal(uniqueNormal.points.size());
+                unsigned int stamp = 0;
+                vector<pair<unsigned int, unsigned int>> ranges = { { 0, prims.size() } };
+                while (!ranges.empty()) {
+                    auto [first, last] = ranges.back();
+                    ranges.pop_back();
+                    stamp++;
+                    unsigned int numPositions = 0, numNormals = 0, numTriangles = 0, numLines = 0;
+                    for (unsigned int p = first; p < last; p++) {
+                        auto const &prim = prims[p];
+                        for (unsigned int v = 0; v < (prim.isLine ? 2u : 3u); v++) {
+                            if (posStamp[prim.verts[v]] != stamp) {
+                                posStamp[prim.verts[v]] = stamp;
+                                numPositions++;
+                            }
+                        }
+                        if (prim.isLine)
+                            numLines++;
+                        else {
+                            if (normalStamp[prim.normal] != stamp) {
+                                normalStamp[prim.normal] = stamp;
+                                numNormals++;
+                            }
+                            numTriangles++;
+                        }
+                    }
+                    if ((last - first) > 1 && (numPositions > maxCollCount || numNormals > maxCollCount || numTriangles > maxCollTriangles || numLines > maxCollCount)) {
+                        aiVector3D centerMin = prims[first].center;
+                        aiVector3D centerMax = prims[first].center;
+                        for (unsigned int p = first + 1; p < last; p++) {
+                            for (unsigned int a = 0; a < 3; a++) {
+                                centerMin[a] = min(centerMin[a], prims[p].center[a]);
+                                centerMax[a] = max(centerMax[a], prims[p].center[a]);
+                            }
+                        }
+                        unsigned int axis = 0;
+                        aiVector3D extent = centerMax - centerMin;
+                        if (extent.y > extent[axis])
+                            axis = 1;
+                        if (extent.z > extent[axis])
+                            axis = 2;
+                        unsigned int middle = first + (last - first) / 2;
+                        nth_element(prims.begin() + first, prims.begin() + middle, prims.begin() + last, [axis](CollPrimitive const &a, CollPrimitive const &b) {
+                            return a.center[axis] < b.center[axis];
+                        });
+                        ranges.emplace_back(middle, last);
+                        ranges.emplace_back(first, middle);
+                        continue;
+                    }
+                    // write the chunk
+                    stamp++;
+                    vector<aiVector3D> positions;
+                    vector<aiVector3D> normals;
+                    vector<CollTriangle> triangles;
+                    vector<CollLine> lines;
+                    auto LocalPos = [&](unsigned int id) {
+                        if (posStamp[id] != stamp) {
+                            posStamp[id] = stamp;
+                            posLocal[id] = positions.size();
+                            positions.push_back(uniquePos.points[id]);
+                        }
+                        return unsigned short(posLocal[id]);
+                    };
+                    for (unsigned int p = first; p < last; p++) {
+                        auto const &prim = prims[p];
+                        if (prim.isLine) {
+                            CollLine line;
+                            line.vertPos[0] = LocalPos(prim.verts[0]);
+                            line.vertPos[1] = LocalPos(prim.verts[1]);
+                            lines.push_back(line);
+                        }
+                        else {
+                            CollTriangle triangle;
+                            for (unsigned int v = 0; v < 3; v++)
+                                triangle.vertPos[v] = LocalPos(prim.verts[v]);
+                            if (normalStamp[prim.normal] != stamp) {
+                                normalStamp[prim.normal] = stamp;
+                                normalLocal[prim.normal] = normals.size();
+                                normals.push_back(uniqueNormal.points[prim.normal]);
+                            }
+                            triangle.normal = unsigned short(normalLocal[prim.normal]);
+                            triangles.push_back(triangle);
+                        }
                     }
+                    Bounds bounds;
+                    bounds.AddBox((unsigned char const *)positions.data(), sizeof(aiVector3D), unsigned int(positions.size()));
+                    colFile.Put(bounds.min);
+                    colFile.Put(bounds.max);
+                    colFile.Put(unsigned short(positions.size()));
+                    colFile.Put(unsigned short(normals.size()));
+                    colFile.Put(unsigned short(triangles.size()));
+                    colFile.Put(unsigned short(lines.size()));
+                    for (auto const &i : positions)
+                        colFile.Put(i);
+                    for (auto const &i : normals)
+                        colFile.Put(i);
+                    for (auto const &i : triangles)
+                        colFile.Put(i);
+                    for (auto const &i : lines)
+                        colFile.Put(i);
+                    numColGeometries++;
                 }
-                for (auto const &i : uniqueNormal)
-                    normals[i.second] = i.first;
-
-                colFile.Put(min);
-                colFile.Put(max);
-                colFile.Put(unsigned short(positions.size()));
-                colFile.Put(unsigned short(normals.size()));
-                colFile.Put(unsigned short(triangles.size()));
-                colFile.Put(unsigned short(lines.size()));
-                for (auto const &i : positions)
-                    colFile.Put(i);
-                for (auto const &i : normals)
-                    colFile.Put(i);
-                for (auto const &i : triangles)
-                    colFile.Put(i);
-                for (auto const &i : lines)
-                    colFile.Put(i);
             }
+            unsigned int colFileEnd = colFile.Position();
+            colFile.MoveTo(8);
+            colFile.Put(numColGeometries);
+            colFile.MoveTo(colFileEnd);
             colFile.WriteToFile(stadCollPath);
         }
     }
@@ -0,0 +1,481 @@
+#include "main.h"
+#include "binbuf.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+
+// Asset index: per-file metadata for .o/.ord and .fsh files in a folder tree, stored in one binary file.
+// 'index' refreshes only the files whose size or modification time changed, 'query' answers questions from the stored data.
+
+namespace {
+
+const unsigned int INDEX_SIGNATURE = 0x58444E49; // 'INDX'
+const unsigned int INDEX_VERSION = 1;
+const char INDEX_DEFAULT_FILENAME[] = "otools.index";
+
+struct IndexedImage {
+    string tag;
+    string format;
+    unsigned int width = 0;
+    unsigned int height = 0;
+};
+
+struct IndexedFile {
+    string path; // relative to the indexed folder
+    unsigned long long fileSize = 0;
+    long long fileTime = 0;
+    vector<string> models;
+    vector<string> renderMethods;
+    vector<string> shaders;
+    vector<string> textures;
+    vector<string> bones;
+    vector<unsigned int> skeletons; // number of bones in each skeleton
+    vector<IndexedImage> images;
+    string error;
+};
+
+void AddUnique(vector<string> &vec, string const &value) {
+    if (!value.empty() && find(vec.begin(), vec.end(), value) == vec.end())
+        vec.push_back(value);
+}
+
+string TagString(void const *tag) {
+    char str[5];
+    Memory_Copy(str, tag, 4);
+    str[4] = '\0';
+    return str;
+}
+
+// same naming as -fshFormat
+string FshFormatName(unsigned char format) {
+    switch (format) {
+    case ea::FshPixelData::PIXEL_DXT1:
+        return "dxt1";
+    case ea::FshPixelData::PIXEL_DXT3:
+        return "dxt3";
+    case ea::FshPixelData::PIXEL_DXT5:
+        return "dxt5";
+    case ea::FshPixelData::PIXEL_8888:
+        return "8888";
+    case ea::FshPixelData::PIXEL_888:
+        return "888";
+    case ea::FshPixelData::PIXEL_4444:
+    case ea::FshPixelData::PIXEL_4444_PSP:
+        return "4444";
+    case ea::FshPixelData::PIXEL_5551:
+        return "5551";
+    case ea::FshPixelData::PIXEL_565:
+        return "565";
+    case ea::FshPixelData::PIXEL_PAL4:
+    case ea::FshPixelData::PIXEL_PAL4_PSP:
+        return "pal4";
+    case ea::FshPixelData::PIXEL_PAL8:
+    case ea::FshPixelData::PIXEL_PAL8_PSP:
+        return "pal8";
+    }
+    char str[8];
+    snprintf(str, sizeof(str), "0x%02X", format);
+    return str;
+}
+
+// texture name from a "__EAGL::TAR:::" symbol (global texture or runtime-constructed texture)
+string TextureNameFromTarSymbol(string const &symbolName) {
+    string tarAttributes = symbolName.substr(14);
+    if (!tarAttributes.starts_with("RUNTIME_ALLOC"))
+        return tarAttributes;
+    auto shapenamePos = tarAttributes.find("SHAPENAME=");
+    if (shapenamePos == string::npos)
+        return string();
+    auto endPos = tarAttributes.find_first_of(",;", shapenamePos + 10);
+    if (endPos == string::npos)
+        return tarAttributes.substr(shapenamePos + 10);
+    return tarAttributes.substr(shapenamePos + 10, endPos - shapenamePos - 10);
+}
+
+void IndexOFile(path const &filePath, IndexedFile &file) {
+    auto fileData = readofile(filePath);
+    if (!fileData.first) {
+        file.error = "unable to read file";
+        return;
+    }
+    unsigned char *data = nullptr;
+    unsigned int dataSize = 0;
+    Elf32_Sym *symbols = nullptr;
+    unsigned int numSymbols = 0;
+    Elf32_Rel *rel = nullptr;
+    unsigned int numRelocations = 0;
+    char *symbolNames = nullptr;
+    unsigned int dataIndex = 0;
+
+    Elf32_Ehdr *h = (Elf32_Ehdr *)fileData.first;
+    if (fileData.second < sizeof(Elf32_Ehdr) || h->e_shoff + h->e_shnum * sizeof(Elf32_Shdr) > fileData.second) {
+        file.error = "not an ELF file";
+        delete[] fileData.first;
+        return;
+    }
+    Elf32_Shdr *s = At<Elf32_Shdr>(h, h->e_shoff);
+    for (unsigned int i = 0; i < h->e_shnum; i++) {
+        if (s[i].sh_size > 0 && s[i].sh_offset + s[i].sh_size <= fileData.second) {
+            if (s[i].sh_type == 1) {
+                data = At<unsigned char>(h, s[i].sh_offset);
+                dataSize = s[i].sh_size;
+                dataIndex = i;
+            }
+            else if (s[i].sh_type == 2) {
+                symbols = At<Elf32_Sym>(h, s[i].sh_offset);
+                numSymbols = s[i].sh_size / 16;
+            }
+            else if (s[i].sh_type == 3)
+                symbolNames = At<char>(h, s[i].sh_offset);
+            else if (s[i].sh_type == 9) {
+                rel = At<Elf32_Rel>(h, s[i].sh_offset);
+                numRelocations = s[i].sh_size / 8;
+            }
+        }
+    }
+    if (!data || !symbols || !symbolNames) {
+        delete[] fileData.first;
+        return;
+    }
+
+    auto isSymbolDataPresent = [&](Elf32_Sym const &sym) {
+        return (sym.st_info & 0xF) != 0 && sym.st_shndx == dataIndex;
+    };
+
+    RelocView view(data, dataSize);
+    map<unsigned int, unsigned int> externRelocations; // offset > symbol index
+    for (unsigned int i = 0; i < numRelocations; i++) {
+        auto symbolId = rel[i].r_info_sym;
+        if (symbolId < numSymbols) {
+            if (isSymbolDataPresent(symbols[symbolId]))
+                view.AddRelocation(rel[i].r_offset);
+            else if (symbols[symbolId].st_info == 0x10)
+                externRelocations[rel[i].r_offset] = symbolId;
+        }
+    }
+
+    for (unsigned int i = 0; i < numSymbols; i++) {
+        auto const &sym = symbols[i];
+        string name = &symbolNames[sym.st_name];
+        if (name.starts_with("__EAGL::TAR:::") && name.length() > 14) {
+            AddUnique(file.textures, TextureNameFromTarSymbol(name));
+            continue;
+        }
+        if (!isSymbolDataPresent(sym) || sym.st_value >= dataSize)
+            continue;
+        void *obj = At<void>(data, sym.st_value);
+        if (name.starts_with("__Model:::")) {
+            AddUnique(file.models, name.substr(10));
+            void *texDesc = view.Get<void>(obj, 0xBC);
+            while (texDesc && view.Get<char const>(texDesc, 0)) {
+                AddUnique(file.textures, view.Get<char const>(texDesc, 0));
+                unsigned int texCount = GetAt<unsigned int>(texDesc, 4);
+                if (view.OffsetOf(texDesc) + 12 + texCount * 4ull > dataSize)
+                    break;
+                for (unsigned int tx = 0; tx < texCount; tx++) {
+                    unsigned char *tar = view.Get<unsigned char>(texDesc, 8 + tx * 4);
+                    if (tar && view.OffsetOf(tar) + 8 <= dataSize)
+                        AddUnique(file.textures, TagString(tar + 4));
+                }
+                unsigned int texSize = texCount * 4;
+                unsigned short info = GetAt<unsigned int>(texDesc, 8 + texSize);
+                texDesc = At<void>(texDesc, (info == 1 ? 12 : 8) + texSize);
+                if (view.OffsetOf(texDesc) + 8 > dataSize)
+                    break;
+            }
+        }
+        else if (name.starts_with("__RenderMethod:::")) {
+            AddUnique(file.renderMethods, name.substr(17));
+            auto it = externRelocations.find(sym.st_value + 8);
+            if (it != externRelocations.end()) {
+                string codeName = &symbolNames[symbols[(*it).second].st_name];
+                if (codeName.ends_with("__EAGLMicroCode"))
+                    AddUnique(file.shaders, codeName.substr(0, codeName.length() - 15));
+            }
+        }
+        else if (name.starts_with("__Bone:::")) {
+            string boneName = name.substr(9);
+            auto dotPos = boneName.find_last_of('.');
+            if (dotPos != string::npos)
+                boneName = boneName.substr(dotPos + 1);
+            AddUnique(file.bones, boneName);
+        }
+        else if (name.starts_with("__Skeleton:::") && sym.st_value + 12 <= dataSize)
+            file.skeletons.push_back(GetAt<unsigned int>(obj, 8));
+    }
+    delete[] fileData.first;
+}
+
+void IndexFshFile(path const &filePath, IndexedFile &file) {
+    ea::Fsh fsh;
+    fsh.Read(filePath);
+    fsh.ForAllImages([&](ea::FshImage &image) {
+        IndexedImage img;
+        img.tag = image.GetTag();
+        auto pixelsData = image.FindFirstData(ea::FshData::PIXELDATA);
+        if (pixelsData) {
+            auto pixels = pixelsData->As<ea::FshPixelData>();
+            img.format = FshFormatName(pixels->GetFormat());
+            img.width = pixels->GetWidth();
+            img.height = pixels->GetHeight();
+        }
+        file.images.push_back(img);
+    });
+}
+
+void PutStrings(BinaryBuffer &buf, vector<string> const &strings) {
+    buf.Put<unsigned int>(strings.size());
+    for (auto const &str : strings)
+        buf.Put(str);
+}
+
+void GetStrings(BinaryReader &reader, vector<string> &strings) {
+    strings.resize(reader.GetCount());
+    for (auto &str : strings)
+        str = reader.GetString();
+}
+
+bool SaveIndex(path const &indexPath, vector<IndexedFile> const &files) {
+    BinaryBuffer buf;
+    buf.Put(INDEX_SIGNATURE);
+    buf.Put(INDEX_VERSION);
+    buf.Put<unsigned int>(files.size());
+    for (auto const &f : files) {
+        buf.Put(f.path);
+        buf.Put(f.fileSize);
+        buf.Put(f.fileTime);
+        PutStrings(buf, f.models);
+        PutStrings(buf, f.renderMethods);
+        PutStrings(buf, f.shaders);
+        PutStrings(buf, f.textures);
+        PutStrings(buf, f.bones);
+        buf.Put<unsigned int>(f.skeletons.size());
+        for (auto numBones : f.skeletons)
+            buf.Put(numBones);
+        buf.Put<unsigned int>(f.images.size());
+        for (auto const &img : f.images) {
+            buf.Put(img.tag);
+            buf.Put(img.format);
+            buf.Put(img.width);
+            buf.Put(img.height);
+        }
+        buf.Put(f.error);
+    }
+    return buf.WriteToFile(indexPath);
+}
+
+bool LoadIndex(path const &indexPath, vector<IndexedFile> &files) {
+    files.clear();
+    BinaryReader reader;
+    if (!exists(indexPath) || !reader.Open(indexPath))
+        return false;
+    if (reader.Get<unsigned int>() != INDEX_SIGNATURE || reader.Get<unsigned int>() != INDEX_VERSION)
+        return false;
+    files.resize(reader.GetCount());
+    for (auto &f : files) {
+        f.path = reader.GetString();
+        f.fileSize = reader.Get<unsigned long long>();
+        f.fileTime = reader.Get<long long>();
+        GetStrings(reader, f.models);
+        GetStrings(reader, f.renderMethods);
+        GetStrings(reader, f.shaders);
+        GetStrings(reader, f.textures);
+        GetStrings(reader, f.bones);
+        f.skeletons.resize(reader.GetCount());
+        for (auto &numBones : f.skeletons)
+            numBones = reader.Get<unsigned int>();
+        f.images.resize(reader.GetCount());
+        for (auto &img : f.images) {
+            img.tag = reader.GetString();
+            img.format = reader.GetString();
+            img.width = reader.Get<unsigned int>();
+            img.height = reader.Get<unsigned int>();
+        }
+        f.error = reader.GetString();
+        if (reader.Failed())
+            break;
+    }
+    if (reader.Failed() || !reader.AtEnd()) {
+        files.clear();
+        return false;
+    }
+    return true;
+}
+
+path IndexPath(path const &out, path const &in) {
+    if (!out.empty())
+        return out;
+    if (is_directory(in))
+        return in / INDEX_DEFAULT_FILENAME;
+    return in;
+}
+
+// case-insensitive match with '*' and '?' wildcards
+bool MatchPattern(char const *str, char const *pattern) {
+    while (*pattern) {
+        if (*pattern == '*') {
+            pattern++;
+            if (!*pattern)
+                return true;
+            for (; *str; str++) {
+                if (MatchPattern(str, pattern))
+                    return true;
+            }
+            return false;
+        }
+        if (!*str || (*pattern != '?' && tolower((unsigned char)*pattern) != tolower((unsigned char)*str)))
+            return false;
+        str++;
+        pattern++;
+    }
+    return !*str;
+}
+
+bool MatchAny(vector<string> const &values, string const &pattern) {
+    for (auto const &v : values) {
+        if (MatchPattern(v.c_str(), pattern.c_str()))
+            return true;
+    }
+    return false;
+}
+
+}
+
+void oindex(path const &out, path const &in) {
+    if (!is_directory(in))
+        throw runtime_error("index: input path must be a folder");
+    path indexPath = IndexPath(out, in);
+    vector<IndexedFile> previous;
+    LoadIndex(indexPath, previous);
+    map<string, IndexedFile *> previousByPath;
+    for (auto &f : previous)
+        previousByPath[f.path] = &f;
+
+    vector<IndexedFile> files;
+    vector<pair<unsigned int, path>> filesToScan;
+    for (auto const &i : recursive_directory_iterator(in)) {
+        if (!i.is_regular_file())
+            continue;
+        auto const &p = i.path();
+        string ext = ToLower(p.extension().string());
+        if (ext != ".o" && ext != ".ord" && ext != ".fsh")
+            continue;
+        IndexedFile file;
+        file.path = p.lexically_relative(in).generic_string();
+        file.fileSize = i.file_size();
+        file.fileTime = i.last_write_time().time_since_epoch().count();
+        auto it = previousByPath.find(file.path);
+        if (it != previousByPath.end() && (*it).second->fileSize == file.fileSize && (*it).second->fileTime == file.fileTime)
+            files.push_back(move(*(*it).second));
+        else {
+            filesToScan.emplace_back(files.size(), p);
+            files.push_back(move(file));
+        }
+    }
+    sort(filesToScan.begin(), filesToScan.end(), [](pair<unsigned int, path> const &a, pair<unsigned int, path> const &b) {
+        return a.second < b.second;
+    });
+    cout << "Indexing " << filesToScan.size() << " of " << files.size() << " files (" << (files.size() - filesToScan.size()) << " unchanged)" << endl;
+    atomic<unsigned int> nextFile = 0;
+    auto ScanFiles = [&] {
+        for (unsigned int n = nextFile++; n < filesToScan.size(); n = nextFile++) {
+            auto const &filePath = filesToScan[n].second;
+            auto &file = files[filesToScan[n].first];
+            try {
+                if (ToLower(filePath.extension().string()) == ".fsh")
+                    IndexFshFile(filePath, file);
+                else
+                    IndexOFile(filePath, file);
+            }
+            catch (exception &e) {
+                file.error = e.what();
+            }
+        }
+    };
+    unsigned int numThreads = min(max(thread::hardware_concurrency(), 1u), max(unsigned int(filesToScan.size()), 1u));
+    vector<thread> threads;
+    for (unsigned int t = 1; t < numThreads; t++)
+        threads.emplace_back(ScanFiles);
+    ScanFiles();
+    for (auto &t : threads)
+        t.join();
+    sort(files.begin(), files.end(), [](IndexedFile const &a, IndexedFile const &b) {
+        return a.path < b.path;
+    });
+    if (!SaveIndex(indexPath, files))
+        throw runtime_error("index: unable to write " + indexPath.string());
+    unsigned int numErrors = 0;
+    for (auto const &f : files) {
+        if (!f.error.empty())
+            numErrors++;
+    }
+    cout << "Index written to " << indexPath.string() << " (" << files.size() << " files, " << numErrors << " with errors)" << endl;
+}
+
+// -query "key=value[;key=value...]", all conditions must match. Keys: model, renderMethod, shader, texture, bone,
+// bones (number of bones in a skeleton), fsh (image tag), fshFormat. Values can contain '*' and '?' wildcards.
+void oquery(path const &out, path const &in) {
+    path indexPath = IndexPath(path(), in);
+    vector<IndexedFile> files;
+    if (!LoadIndex(indexPath, files))
+        throw runtime_error("query: unable to read index " + indexPath.string());
+    vector<pair<string, string>> conditions;
+    for (auto const &c : Split(options().query, ';', true, true)) {
+        auto eqPos = c.find('=');
+        if (eqPos == string::npos)
+            throw runtime_error("query: condition '" + c + "' must be key=value");
+        string key = c.substr(0, eqPos);
+        string value = c.substr(eqPos + 1);
+        Trim(key);
+        Trim(value);
+        key = ToLower(key);
+        static set<string> keys = { "model", "rendermethod", "shader", "texture", "bone", "bones", "fsh", "fshformat" };
+        if (!keys.contains(key))
+            throw runtime_error("query: unknown key '" + key + "'");
+        conditions.emplace_back(key, value);
+    }
+    auto Matches = [&](IndexedFile const &f) {
+        for (auto const &[key, value] : conditions) {
+            bool match = false;
+            if (key == "model")
+                match = MatchAny(f.models, value);
+            else if (key == "rendermethod")
+                match = MatchAny(f.renderMethods, value);
+            else if (key == "shader")
+                match = MatchAny(f.shaders, value);
+            else if (key == "texture")
+                match = MatchAny(f.textures, value);
+            else if (key == "bone")
+                match = MatchAny(f.bones, value);
+            else if (key == "bones") {
+                for (auto numBones : f.skeletons) {
+                    if (to_string(numBones) == value)
+                        match = true;
+                }
+            }
+            else {
+                for (auto const &img : f.images) {
+                    if (MatchPattern((key == "fsh" ? img.tag : img.format).c_str(), value.c_str()))
+                        match = true;
+                }
+            }
+            if (!match)
+                return false;
+        }
+        return true;
+    };
+    ofstream w;
+    if (!out.empty())
+        w.open(out, ios::out);
+    unsigned int numMatches = 0;
+    for (auto const &f : files) {
+        if (Matches(f)) {
+            numMatches++;
+            cout << f.path << endl;
+            if (w.is_open())
+                w << f.path << endl;
+        }
+    }
+    cout << numMatches << " of " << files.size() << " files" << endl;
+}
@@ -30,15 +30,15 @@ class analyzer {
     struct BBOX { vector3 min, max; };
 
     struct ModifiableData {
-        char *mName;
+        Ptr32<char> mName;
         unsigned short mEntrySize;
         unsigned short unknown;
         unsigned int mEntriesCount;
-        void *mEntries;
+        Ptr32<void> mEntries;
     };
 
     struct Model {
-        ModifiableData *mModifiableData;
+        Ptr32<ModifiableData> mModifiableData;
         unsigned int mNumModifiableDatas;
         unsigned int mNumVariations;
         Matrix4x4 mTransform;
@@ -48,18 +48,18 @@ class analyzer {
         vector4 mBoundMax;
         vector4 mCenter;
         unsigned int mNumLayers;
-        char const **mLayerNames;
+        Ptr32<Ptr32<char const>> mLayerNames;
         unsigned int field_A4;
-        Model *field_A8;
-        Model *field_AC;
-        Model *mNext;
-        char const *mName;
-        void *mMorphVertexInfo;
-        void *mTextures;
+        Ptr32<Model> field_A8;
+        Ptr32<Model> field_AC;
+        Ptr32<Model> mNext;
+        Ptr32<char const> mName;
+        Ptr32<void> mMorphVertexInfo;
+        Ptr32<void> mTextures;
         unsigned int mVariationID;
-        void *mLayersStates;
+        Ptr32<void> mLayersStates;
         unsigned int mIsRenderable;
-        void *mLayers;
+        Ptr32<void> mLayers;
         unsigned int field_D0;
         unsigned int field_D4;
         unsigned int mSkeletonVersion;
@@ -67,19 +67,19 @@ class analyzer {
     };
 
     struct RenderMethod {
-        unsigned char *mCodeBlock;
-        unsigned char **mCodeToUse;
-        void *mMicroCode;
-        void *mETTObject;
-        RenderMethod *mParent;
-        char const **mpParameterNames;
+        Ptr32<unsigned char> mCodeBlock;
+        Ptr32<Ptr32<unsigned char>> mCodeToUse;
+        Ptr32<void> mMicroCode;
+        Ptr32<void> mETTObject;
+        Ptr32<RenderMethod> mParent;
+        Ptr32<Ptr32<char const>> mpParameterNames;
         unsigned int field_18;
         int field_1C;
-        RenderMethod *field_20;
-        void *mGeoPrimDataBuffer;
+        Ptr32<RenderMethod> field_20;
+        Ptr32<void> mGeoPrimDataBuffer;
         int mComputationIndexCommand;
-        char const *mShaderName;
-        void *mEAGLModel;
+        Ptr32<char const> mShaderName;
+        Ptr32<void> mEAGLModel;
     };
 
     struct GeometryInfo {
@@ -112,7 +112,7 @@ class analyzer {
         unsigned short unknown1;
         unsigned int mSignature2;
         unsigned int mNumBones;
-        void *unknown2;
+        Ptr32<void> unknown2;
     };
 
     struct Buffer {
@@ -269,12 +269,13 @@ public:
                 symbolRelocations[rel[i].r_offset] = symbols[rel[i].r_info_sym];
         }
 
-        // do relocations
+        // register relocations
 
+        RelocView view(data, dataSize);
         for (unsigned int i = 0; i < numRelocations; i++) {
             auto symbolId = rel[i].r_info_sym;
             if (symbolId < numSymbols && isSymbolDataPresent(symbols[symbolId]))
-                SetAt(data, rel[i].r_offset, &data[GetAt<unsigned int>(data, rel[i].r_offset)]);
+                view.AddRelocation(rel[i].r_offset);
         }
 
         // find model
@@ -329,16 +330,16 @@ public:
         }
 
         if (model) {
-            if (model->mNumLayers && model->mLayers) {
-                unsigned int *modelLayers = (unsigned int *)(model->mLayers);
+            if (model->mNumLayers && view.Get(model->mLayers)) {
+                unsigned int *modelLayers = (unsigned int *)view.Get(model->mLayers);
                 modelLayers++;
                 for (unsigned int i = 0; i < model->mNumLayers; i++) {
                     unsigned int numPrimitives = *modelLayers;
                     modelLayers++;
                     for (unsigned int p = 0; p < numPrimitives; p++) {
-                        void *renderDescriptor = GetAt<void *>(modelLayers, p * 4);
-                        RenderMethod *renderMethod = GetAt<RenderMethod *>(renderDescriptor, 0);
-                        void *globalParameters = At<void *>(renderDescriptor, 4);
+                        void *renderDescriptor = view.Get<void>(modelLayers, p * 4);
+                        RenderMethod *renderMethod = view.Get<RenderMethod>(renderDescriptor, 0);
+                        void *globalParameters = At<void>(renderDescriptor, 4);
                         Shader *shader = nullptr;
                         unsigned int rmCodeOffset = At<unsigned char>(renderMethod, 8) - data;
                         auto it = symbolRelocations.find(rmCodeOffset);
@@ -354,7 +355,7 @@ public:
                                     //    cout << shaderName << "," << renderMethod->mComputationIndexCommand << "," << filename << endl;
                                     //    v[shaderName].insert(renderMethod->mComputationIndexCommand);
                                     //}
-                                    void *renderCode = GetAt<void *>(renderMethod, 0);
+                                    void *renderCode = view.Get<void>(renderMethod, 0);
                                     unsigned int numCommands = 0;
                                     unsigned int commandOffset = 0;
                                     unsigned short id = GetAt<unsigned short>(renderCode, commandOffset + 2);
@@ -374,11 +375,11 @@ public:
                                         case 4:
                                         case 75:
                                         {
-                                            auto vertexBuffer = GetAt<void *>(globalParameters, 4);
+                                            auto vertexBuffer = view.Get<void>(globalParameters, 4);
                                             auto numVertices = GetAt<unsigned int>(globalParameters, 0);
                                             auto vertexSize = GetAt<unsigned int>(renderCode, commandOffset + 8);
                                             if (colorOffset != 1) {
-                                                unsigned char *clr = (unsigned char *)(unsigned int(vertexBuffer) + colorOffset);
+                                                unsigned char *clr = At<unsigned char>(vertexBuffer, colorOffset);
                                                 for (unsigned int vert = 0; vert < numVertices; vert++) {
                                                     unsigned char maxClr = clr[0];
                                                     if (maxClr < clr[1])
@@ -389,7 +390,7 @@ public:
                                                         globalVars().maxColorValue[shader->name].first = maxClr;
                                                         globalVars().maxColorValue[shader->name].second = filename;
                                                     }
-                                                    clr = (unsigned char *)(unsigned int(clr) + vertexSize);
+                                                    clr = At<unsigned char>(clr, vertexSize);
                                                 }
                                             }
                                         }
@@ -423,7 +424,7 @@ public:
                                         //    break;
                                         case 9:
                                         case 32:
-                                            if (!GetAt<GeoPrimState *>(globalParameters, 4)) {
+                                            if (!view.Get<GeoPrimState>(globalParameters, 4)) {
                                                 //it = symbolRelocations.find(unsigned int(At<GeoPrimState *>(globalParameters, 4)) - unsigned int(data));
                                                 //if (it != symbolRelocations.end() && (*it).second.st_info == 0x10) {
                                                 //    string format = (*it).second.name;
@@ -458,7 +459,7 @@ public:
                                             break;
                                         }
                                         if (numCommands != 0)
-                                            globalParameters = At<void *>(globalParameters, 8);
+                                            globalParameters = At<void>(globalParameters, 8);
                                         numCommands++;
                                         commandOffset += size * 4;
                                         id = GetAt<unsigned short>(renderCode, commandOffset + 2);
@@ -477,18 +478,18 @@ public:
                     modelLayers += numPrimitives;
                 }
             }
-            if (false && model && model->mTextures) {
-                void *texDesc = model->mTextures;
-                char const *texName = GetAt<char const *>(texDesc, 0);
+            if (false && model && view.Get(model->mTextures)) {
+                void *texDesc = view.Get(model->mTextures);
+                char const *texName = view.Get<char const>(texDesc, 0);
                 while (texName) { // TODO: replace with IsValidOffset()
-                    void **pTexTar = At<void *>(texDesc, 8);
-                    Texture *tar = (Texture *)(*pTexTar);
+                    void *pTexTar = At<void>(texDesc, 8);
+                    Texture *tar = view.Get<Texture>(pTexTar, 0);
                     if (tar) {
 
                         //Error(Utils::Format(L"%d %d %d", tar->wrapU, tar->wrapV, tar->wrapW));
                     }
                     else {
-                        unsigned int tarOffset = unsigned int(pTexTar) - unsigned int(data);
+                        unsigned int tarOffset = view.OffsetOf(pTexTar);
                         auto it = symbolRelocations.find(tarOffset);
                         if (it != symbolRelocations.end()) {
                             auto const &s = (*it).second;
@@ -504,7 +505,7 @@ public:
                         texDesc = At<void>(texDesc, 12 + texSize);
                     else
                         texDesc = At<void>(texDesc, 8 + texSize);
-                    texName = GetAt<char const *>(texDesc, 0);
+                    texName = view.Get<char const>(texDesc, 0);
                 }
             }
         }
@@ -1,6 +1,7 @@
 #include "D3DInclude.h"
 #include "main.h"
 #include "commandline.h"
+#include "watch.h"
 #include "message.h"
 #include "Fsh/Fsh.h"
 #include <fstream>
@@ -15,6 +16,77 @@ GlobalOptions &options() {
     return go;
 }
 
+void BoneTargets::BuildGrid() {
+    allTargets.resize(targetBones.size());
+    for (unsigned int i = 0; i < targetBones.size(); i++)
+        allTargets[i] = i;
+    gridCellStart.clear();
+    gridCellTargets.clear();
+    if (!hasBounds || targetBones.empty())
+        return;
+    gridBound = targetBones[0].bound;
+    for (auto const &tb : targetBones) {
+        for (unsigned int a = 0; a < 3; a++) {
+            gridBound.mMin[a] = min(gridBound.mMin[a], tb.bound.mMin[a]);
+            gridBound.mMax[a] = max(gridBound.mMax[a], tb.bound.mMax[a]);
+        }
+    }
+    unsigned int resolution = clamp(unsigned int(ceil(cbrt(double(targetBones.size())))) * 2, 1u, 16u);
+    for (unsigned int a = 0; a < 3; a++) {
+        float extent = gridBound.mMax[a] - gridBound.mMin[a];
+        gridSize[a] = extent > 0.0f ? resolution : 1;
+        gridCellScale[a] = extent > 0.0f ? float(gridSize[a]) / extent : 0.0f;
+    }
+    auto CellRange = [&](aiAABB const &b, unsigned int a, unsigned int &first, unsigned int &last) {
+        first = unsigned int(clamp((b.mMin[a] - gridBound.mMin[a]) * gridCellScale[a], 0.0f, float(gridSize[a] - 1)));
+        last = unsigned int(clamp((b.mMax[a] - gridBound.mMin[a]) * gridCellScale[a], 0.0f, float(gridSize[a] - 1)));
+    };
+    unsigned int numCells = gridSize[0] * gridSize[1] * gridSize[2];
+    vector<vector<unsigned short>> cells(numCells);
+    for (unsigned int t = 0; t < targetBones.size(); t++) {
+        unsigned int first[3], last[3];
+        for (unsigned int a = 0; a < 3; a++)
+            CellRange(targetBones[t].bound, a, first[a], last[a]);
+        for (unsigned int z = first[2]; z <= last[2]; z++) {
+            for (unsigned int y = first[1]; y <= last[1]; y++) {
+                for (unsigned int x = first[0]; x <= last[0]; x++)
+                    cells[(z * gridSize[1] + y) * gridSize[0] + x].push_back(t);
+            }
+        }
+    }
+    gridCellStart.resize(numCells + 1);
+    for (unsigned int c = 0; c < numCells; c++) {
+        gridCellStart[c] = gridCellTargets.size();
+        gridCellTargets.insert(gridCellTargets.end(), cells[c].begin(), cells[c].end());
+    }
+    gridCellStart[numCells] = gridCellTargets.size();
+}
+
+void BoneTargets::FindTargets(aiVector3D const &pos, vector<unsigned short> &out) const {
+    out.clear();
+    if (!gridCellStart.empty()) {
+        bool inside = true;
+        unsigned int cell[3];
+        for (unsigned int a = 0; a < 3; a++) {
+            if (pos[a] < gridBound.mMin[a] || pos[a] > gridBound.mMax[a]) {
+                inside = false;
+                break;
+            }
+            cell[a] = min(unsigned int((pos[a] - gridBound.mMin[a]) * gridCellScale[a]), gridSize[a] - 1);
+        }
+        if (inside) {
+            unsigned int c = (cell[2] * gridSize[1] + cell[1]) * gridSize[0] + cell[0];
+            for (unsigned int i = gridCellStart[c]; i < gridCellStart[c + 1]; i++) {
+                auto const &b = targetBones[gridCellTargets[i]].bound;
+                if (pos.x >= b.mMin.x && pos.y >= b.mMin.y && pos.z >= b.mMin.z && pos.x <= b.mMax.x && pos.y <= b.mMax.y && pos.z <= b.mMax.z)
+                    out.push_back(gridCellTargets[i]);
+            }
+        }
+    }
+    if (out.empty())
+        out = allTargets;
+}
+
 enum ErrorType {
     NONE = 0,
     NOT_ENOUGHT_ARGUMENTS = 1,
@@ -29,16 +101,19 @@ int main(int argc, char *argv[]) {
         "fshAddTextures", "fshIgnoreTextures", "startsWith", "pad", "instances", "computationIndex", "hwnd", "fshUnpackImageFormat",
         "forceShader", "fshHash", "fshId", "boneRemap", "skeletonData", "skeleton", "bonesFile", "maxBonesPerVertex", "vertexWeightPaletteSize",
         "translate", "minVCol", "maxVCol", "vColMergeConfig", "bboxScale", "layerFlags", "uid", "fshPalette", "hairSpec", "uvSkinning", "uvSkinSetGenResolution",
-        "uvSkinSetGenTextures", "uvSkinningDefaultBone", "uvSkinningMode", "targetFormat", "platform", "material" },
+        "uvSkinSetGenTextures", "uvSkinningDefaultBone", "uvSkinningMode", "targetFormat", "platform", "material", "collisionWeld",
+        "collisionNormalSteps", "collisionChunkTriangles", "dumpFormat", "query", "watchDelay", "sceneCache", "weldEpsilon", "lods" },
         { "tristrip", "noTextures", "recursive", "createSubDir", "silent", "console", "onlyFirstTechnique", "dummyTextures", "jpegTextures", "embeddedTextures", 
         "swapYZ", "forceLighting", "noMetadata", "genTexNames", "writeFsh", "fshRescale", "fshDisableTextureIgnore", "preTransformVertices", "sortByName", 
         "sortByAlpha", "useMatColor", "noMeshJoin", "head", "hd", "ignoreEmbeddedTextures", "ord", "keepTex0InMatOptions", "fshWriteToParentDir",
         "conformant", "fshUniqueHashForEachTexture", "updateOldStadium", "stadium", "srgb", "fshForceAlphaCheck", "mergeVCols", "fshName",
-        "stadium10to07", "stadium07to10", "flipNormals", "flipFaces", "sortHairFaces", "sortFaces", "useCompressonator", "tangents", "preferDxt3" });
+        "stadium10to07", "stadium07to10", "flipNormals", "flipFaces", "sortHairFaces", "sortFaces", "useCompressonator", "tangents", "preferDxt3",
+        "incremental", "watch", "shareGeometry", "assimpGltf", "weld", "collisionSkipEmpty" });
     if (cmd.HasOption("silent"))
         SetMessageDisplayType(MessageDisplayType::MSG_NONE);
     else {
-        if (cmd.HasOption("console"))
+        // message boxes would block the watch loop
+        if (cmd.HasOption("console") || cmd.HasOption("watch"))
             SetMessageDisplayType(MessageDisplayType::MSG_CONSOLE);
         else
             SetMessageDisplayType(MessageDisplayType::MSG_MESSAGE_BOX);
@@ -49,7 +124,7 @@ int main(int argc, char *argv[]) {
             options().platform = ea::PLATFORM_PSP;
     }
     enum OperationType {
-        UNKNOWN, VERSION, DUMP, EXPORT, IMPORT, INFO, DUMPSHADERS, EXPORTSHADERS, PACKFSH, UNPACKFSH, ALIGNFILES, GENUVSET, EXPORTPREVIEW
+        UNKNOWN, VERSION, DUMP, EXPORT, IMPORT, INFO, DUMPSHADERS, EXPORTSHADERS, PACKFSH, UNPACKFSH, ALIGNFILES, GENUVSET, EXPORTPREVIEW, INDEX, QUERY
     } opType = OperationType::UNKNOWN;
     void (*callback)(path const &, path const &) = nullptr;
     bool isCustom = false;
@@ -114,8 +189,6 @@ int main(int argc, char *argv[]) {
             opType = OperationType::GENUVSET;
             callback = gen_uv_set;
             inExt = { ".gltf", ".glb", ".dae", ".fbx", ".blend", ".3ds", ".x", ".x3d" };
-            createDevice = true;
-            createRenderer = true;
             isCustom = true;
         }
         else if (opTypeStr == "exportshaders") {
@@ -130,6 +203,16 @@ int main(int argc, char *argv[]) {
             inExt = { ".o", ".ord" };
             targetExt = ".gltf";
         }
+        else if (opTypeStr == "index") {
+            opType = OperationType::INDEX;
+            callback = oindex;
+            isCustom = true;
+        }
+        else if (opTypeStr == "query") {
+            opType = OperationType::QUERY;
+            callback = oquery;
+            isCustom = true;
+        }
     }
     if (opType == OperationType::UNKNOWN) {
         ErrorMessage("Unknown operation type\nPlease use OTools_GUI if you don't understand how to work with command-line tool");
@@ -327,6 +410,10 @@ int main(int argc, char *argv[]) {
             options().jpegTextures = true;
         if (cmd.HasOption("noMeshJoin"))
             options().noMeshJoin = true;
+        if (cmd.HasOption("weld"))
+            options().weld = true;
+        if (cmd.HasArgument("weldEpsilon"))
+            options().weldEpsilon = cmd.GetArgumentFloat("weldEpsilon");
         if (cmd.HasOption("keepTex0InMatOptions"))
             options().keepTex0InMatOptions = true;
         if (cmd.HasArgument("skeleton"))
@@ -451,6 +538,22 @@ int main(int argc, char *argv[]) {
             options().preTransformVertices = true;
         if (cmd.HasOption("sortByName"))
             options().sortByName = true;
+        if (cmd.HasOption("shareGeometry"))
+            options().shareGeometry = true;
+        if (cmd.HasOption("assimpGltf"))
+            options().assimpGltf = true;
+        if (cmd.HasArgument("sceneCache"))
+            options().sceneCache = cmd.GetArgumentString("sceneCache");
+        if (cmd.HasArgument("lods")) {
+            for (auto const &ratio : Split(cmd.GetArgumentString("lods"), ',', true, true)) {
+                float value = SafeConvertFloat(ratio);
+                if (!(value > 0.0f && value < 1.0f)) {
+                    ErrorMessage("-lods: " + ratio + " is not a valid triangle ratio (must be between 0 and 1, e.g. -lods 0.5,0.25)");
+                    return ErrorType::ERROR_OTHER;
+                }
+                options().lods.push_back(value);
+            }
+        }
         if (cmd.HasOption("sortByAlpha"))
             options().sortByAlpha = true;
         if (cmd.HasOption("useMatColor"))
@@ -527,16 +630,18 @@ int main(int argc, char *argv[]) {
                                             targets.targetBones[tb].factor *= globalFactor;
                                         if (targets.hasBounds) {
                                             targets.targetBones[tb].bound.mMin.x = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 0]);
-                                            targets.targetBones[tb].bound.mMin.x = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 1]);
-                                            targets.targetBones[tb].bound.mMin.x = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 2]);
+                                            targets.targetBones[tb].bound.mMin.y = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 1]);
+                                            targets.targetBones[tb].bound.mMin.z = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 2]);
                                             targets.targetBones[tb].bound.mMax.x = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 3]);
-                                            targets.targetBones[tb].bound.mMax.x = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 4]);
-                                            targets.targetBones[tb].bound.mMax.x = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 5]);
+                                            targets.targetBones[tb].bound.mMax.y = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 4]);
+                                            targets.targetBones[tb].bound.mMax.z = SafeConvertFloat(info[3 + numTargetBones * 2 + tb * 6 + 5]);
                                         }
                                         //Error("%s - %s %f", sourceBoneName.c_str(), targets.targetBones[tb].boneName.c_str(), targets.targetBones[tb].factor);
                                     }
-                                    if (!failedToAdd)
+                                    if (!failedToAdd) {
+                                        targets.BuildGrid();
                                         globalVars().boneRemap[sourceBoneName] = targets;
+                                    }
                                 }
                             }
                         }
@@ -572,6 +677,14 @@ int main(int argc, char *argv[]) {
             options().uid = cmd.GetArgumentInt("uid");
         if (cmd.HasArgument("hairSpec"))
             options().hairSpec = cmd.GetArgumentFloat("hairSpec");
+        if (cmd.HasArgument("collisionWeld"))
+            options().collisionWeld = max(cmd.GetArgumentFloat("collisionWeld"), 0.0f);
+        if (cmd.HasArgument("collisionNormalSteps"))
+            options().collisionNormalSteps = max(cmd.GetArgumentInt("collisionNormalSteps"), 0);
+        if (cmd.HasArgument("collisionChunkTriangles"))
+            options().collisionChunkTriangles = max(cmd.GetArgumentInt("collisionChunkTriangles"), 0);
+        if (cmd.HasOption("collisionSkipEmpty"))
+            options().collisionSkipEmpty = true;
         if (cmd.HasOption("sortHairFaces"))
             options().sortHairFaces = true;
         if (cmd.HasOption("sortFaces"))
@@ -621,6 +734,17 @@ int main(int argc, char *argv[]) {
     else if (opType == OperationType::DUMP) {
         if (cmd.HasOption("onlyFirstTechnique"))
             options().onlyFirstTechnique = true;
+        if (cmd.HasArgument("dumpFormat")) {
+            string dumpFormat = ToLower(cmd.GetArgumentString("dumpFormat"));
+            if (dumpFormat == "json" || dumpFormat == "jsonl") {
+                options().dumpJson = true;
+                targetExt = ".jsonl";
+            }
+        }
+    }
+    else if (opType == OperationType::QUERY) {
+        if (cmd.HasArgument("query"))
+            options().query = cmd.GetArgumentString("query");
     }
     else if (opType == OperationType::PACKFSH) {
         if (cmd.HasOption("fshWriteToParentDir"))
@@ -811,6 +935,38 @@ int main(int argc, char *argv[]) {
     string startsWith;
     if (cmd.HasArgument("startsWith"))
         startsWith = cmd.GetArgumentString("startsWith");
+    // -incremental: outputs whose input, side files and options didn't change since the last run are skipped
+    // -watch: after the first pass, the input folder is watched and changed files are converted again (implies -incremental)
+    ConversionManifest manifest;
+    vector<path> globalDependencies;
+    bool supportsManifest = !isCustom && is_directory(i) && (opType == IMPORT || opType == EXPORT || opType == PACKFSH);
+    bool watch = cmd.HasOption("watch");
+    if (watch && !supportsManifest) {
+        ErrorMessage("-watch option can only be used with import, export and packfsh operations on a folder");
+        return ErrorType::ERROR_OTHER;
+    }
+    unsigned int watchDelay = 500;
+    if (cmd.HasArgument("watchDelay"))
+        watchDelay = max(cmd.GetArgumentInt("watchDelay"), 0);
+    bool incremental = supportsManifest && (watch || cmd.HasOption("incremental"));
+    if (incremental) {
+        string optionsKey = OTOOLS_VERSION;
+        for (int a = 1; a < argc; a++) {
+            string arg = ToLower(argv[a]);
+            if ((arg == "-i" || arg == "-o" || arg == "-hwnd" || arg == "-watchdelay") && (a + 1) < argc)
+                a++;
+            else if (arg != "-incremental" && arg != "-watch" && arg != "-silent" && arg != "-console")
+                optionsKey += string(" ") + argv[a];
+        }
+        for (auto const &sideFile : { options().bonesFile, options().boneRemap, options().skeletonData }) {
+            if (!sideFile.empty())
+                globalDependencies.push_back(sideFile);
+        }
+        if (options().mergeVCols && cmd.HasArgument("vColMergeConfig"))
+            globalDependencies.push_back(cmd.GetArgumentString("vColMergeConfig"));
+        manifest.Load(hasOutput ? o : i, optionsKey);
+        globalVars().manifest = &manifest;
+    }
     if (createDevice) {
         D3DDevice *pDevice = nullptr;
         if (options().hwnd) {
@@ -829,46 +985,63 @@ int main(int argc, char *argv[]) {
 
     auto errCode = ErrorType::NONE;
     
-    if (!isCustom) {
-        auto processFile = [&](path const &in, bool inDir) {
-            try {
-                if (!inDir || (is_regular_file(in) && inExt.contains(ToLower(in.extension().string())))) {
-                    if (startsWith.empty() || in.filename().string().starts_with(startsWith)) {
-                        path out;
-                        if (hasOutput)
-                            out = o;
+    auto processFile = [&](path const &in, bool inDir) {
+        try {
+            if (!inDir || (is_regular_file(in) && inExt.contains(ToLower(in.extension().string())))) {
+                if (startsWith.empty() || in.filename().string().starts_with(startsWith)) {
+                    path out;
+                    if (hasOutput)
+                        out = o;
+                    else
+                        out = in.parent_path();
+                    if (!hasOutput || inDir || opType == OperationType::PACKFSH || opType == OperationType::UNPACKFSH) {
+                        string targetFileName = in.stem().string();
+                        string targetFileNameWithExt = targetFileName + targetExt;
+                        if (createSubDir)
+                            out = out / targetFileName / targetFileNameWithExt;
                         else
-                            out = in.parent_path();
-                        if (!hasOutput || inDir || opType == OperationType::PACKFSH || opType == OperationType::UNPACKFSH) {
-                            string targetFileName = in.stem().string();
-                            string targetFileNameWithExt = targetFileName + targetExt;
-                            if (createSubDir)
-                                out = out / targetFileName / targetFileNameWithExt;
-                            else
-                                out = out / targetFileNameWithExt;
-                        }
-                        create_directories(out.parent_path());
-                        globalVars().currentFilePath = in;
-                        callback(out, in);
+                            out = out / targetFileNameWithExt;
                     }
+                    create_directories(out.parent_path());
+                    globalVars().currentFilePath = in;
+                    bool useManifest = incremental && opType != OperationType::PACKFSH; // packfsh is checked per fsh in packfsh_pack()
+                    if (useManifest && manifest.IsUpToDate(out, in))
+                        return;
+                    globalVars().dependencies = globalDependencies;
+                    if (ToLower(in.extension().string()) == ".ord") // readofile() reads the relocations from the .orl
+                        globalVars().dependencies.push_back(path(in).replace_extension(".orl"));
+                    callback(out, in);
+                    if (useManifest)
+                        manifest.Record(out, in, globalVars().dependencies);
                 }
             }
-            catch (exception & e) {
-                ErrorMessage(in.filename().string() + ": " + e.what());
-                errCode = ErrorType::ERROR_OTHER;
-            }
-        };
+        }
+        catch (exception & e) {
+            ErrorMessage(in.filename().string() + ": " + e.what());
+            errCode = ErrorType::ERROR_OTHER;
+        }
+    };
+
+    auto processFolder = [&]() {
+        if (cmd.HasOption("recursive")) {
+            for (auto const &p : recursive_directory_iterator(i))
+                processFile(p.path(), true);
+        }
+        else {
+            for (auto const &p : directory_iterator(i))
+                processFile(p.path(), true);
+        }
+    };
 
+    // the notifications are opened before the first pass, so files saved while a pass is running start the next one
+    FolderWatcher watcher;
+    if (watch)
+        watcher.SetFolders(i, cmd.HasOption("recursive"), manifest.DependencyFolders());
+
+    if (!isCustom) {
         if (is_directory(i)) {
             options().processingFolders = true;
-            if (cmd.HasOption("recursive")) {
-                for (auto const &p : recursive_directory_iterator(i))
-                    processFile(p.path(), true);
-            }
-            else {
-                for (auto const &p : directory_iterator(i))
-                    processFile(p.path(), true);
-            }
+            processFolder();
         }
         else
             processFile(i, false);
@@ -881,6 +1054,36 @@ int main(int argc, char *argv[]) {
     if (opType == PACKFSH)
         packfsh_pack();
 
+    if (incremental) {
+        globalVars().manifest = nullptr;
+        if (!manifest.Save())
+            ErrorMessage("Unable to write " + string(ConversionManifest::FILENAME));
+    }
+
+    // the target, shaders and device stay loaded between passes; the manifest limits each pass to changed outputs
+    if (watch) {
+        InfoMessage("Watching " + i.string() + " for changes (Ctrl+C to stop)");
+        while (true) {
+            // outputs written by a pass into a watched folder start one more pass, which finds everything up to date
+            watcher.SetFolders(i, cmd.HasOption("recursive"), manifest.DependencyFolders());
+            watcher.Wait(watchDelay);
+            globalVars().fshToBuild.clear();
+            manifest.BeginPass();
+            globalVars().manifest = &manifest;
+            try {
+                processFolder();
+                if (opType == PACKFSH)
+                    packfsh_pack();
+            }
+            catch (exception &e) { // files can disappear while the folder is scanned
+                ErrorMessage(e.what());
+            }
+            globalVars().manifest = nullptr;
+            if (!manifest.Save())
+                ErrorMessage("Unable to write " + string(ConversionManifest::FILENAME));
+        }
+    }
+
     if (createDevice)
         ea::Fsh::ClearDevice();
     delete globalVars().renderer;
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include "elf.h"
 #include "memory.h"
+#include "reloc.h"
 #include "outils.h"
 #include <assimp/color4.h>
 #include <assimp/vector3.h>
@@ -15,6 +16,7 @@
 #include "modelfsh_shared.h"
 #include "uvskin.h"
 #include "D3DDevice/Renderer.h"
+#include "manifest.h"
 
 using namespace std;
 using namespace std::filesystem;
@@ -34,6 +36,17 @@ struct BoneRemapTarget {
 struct BoneTargets {
     bool hasBounds = false;
     vector<BoneRemapTarget> targetBones;
+    // uniform grid over target bounds (filled by BuildGrid())
+    aiAABB gridBound;
+    unsigned int gridSize[3] = { 0, 0, 0 };
+    aiVector3D gridCellScale;
+    vector<unsigned int> gridCellStart;
+    vector<unsigned short> gridCellTargets;
+    vector<unsigned short> allTargets;
+
+    void BuildGrid();
+    // indices of targets whose bound contains the position; all targets when none does (or no bounds are used)
+    void FindTargets(aiVector3D const &pos, vector<unsigned short> &out) const;
 };
 
 struct BoneWeightsByUV {
@@ -110,18 +123,31 @@ struct GlobalOptions {
     float hairSpec = 1.0f;
     bool sortFaces = false;
     bool sortHairFaces = false;
+    bool shareGeometry = false;
+    bool assimpGltf = false; // load .gltf/.glb through Assimp instead of the native reader
+    path sceneCache; // folder for post-processed Assimp scenes reused by later imports
+    vector<float> lods; // triangle ratios of the generated LOD layers
     bool tangents = false;
+    float collisionWeld = 0.0f; // stadium collision: position weld distance, 0 - exact match
+    unsigned int collisionNormalSteps = 0; // stadium collision: normal quantization steps, 0 - no quantization
+    bool collisionSkipEmpty = false; // stadium collision: don't write empty geometries for nodes without triangles
+    unsigned int collisionChunkTriangles = 0; // stadium collision: max triangles per geometry, 0 - format limit only
     // export options
     bool noTextures = false;
     bool dummyTextures = false;
     bool jpegTextures = false;
     bool noMeshJoin = false;
+    bool weld = false; // weld equal vertices for glTF output too (always done for the other formats unless noMeshJoin)
+    float weldEpsilon = 0.0f; // vertex weld: float attribute grid size, 0 - exact match
     bool updateOldStadium = false;
     bool stadium07to10 = false;
     bool stadium10to07 = false;
     string targetFormat = "gltf";
     // dump options
     bool onlyFirstTechnique = false;
+    bool dumpJson = false; // one JSON object per line instead of the indented text dump
+    // query options
+    string query;
     // fsh unpack options
     string fshUnpackImageFormat = "png";
     // fsh pack options
@@ -151,6 +177,8 @@ struct GlobalVars {
     ea::FshImage::FileFormat fshUnpackImageFormat = ea::FshImage::PNG;
     map<path, map<string, TextureToAdd>> fshToBuild;
     path currentFilePath;
+    vector<path> dependencies; // side files read for the current output (for the -incremental manifest)
+    ConversionManifest *manifest = nullptr;
     D3DDevice *device = nullptr;
     Renderer *renderer = nullptr;
 };
@@ -167,6 +195,8 @@ void oimport(path const &out, path const &in);
 void oinfo(path const &out, path const &in);
 void oexportshaders(path const &out, path const &in);
 void dumpshaders(path const &out, path const &in);
+void oindex(path const &out, path const &in);
+void oquery(path const &out, path const &in);
 void packfsh_collect(path const &out, path const &in);
 void unpackfsh(path const &out, path const &in);
 void packfsh_pack();
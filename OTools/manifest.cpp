@@ -0,0 +1,154 @@
+#include "manifest.h"
+#include "binbuf.h"
+#include "outils.h"
+#include <algorithm>
+
+using namespace std;
+using namespace std::filesystem;
+
+const char ConversionManifest::FILENAME[] = "otools.manifest";
+
+namespace {
+
+const unsigned int MANIFEST_SIGNATURE = 0x4E414D4F; // 'OMAN'
+const unsigned int MANIFEST_VERSION = 1;
+
+}
+
+string ConversionManifest::OutputKey(path const &output) const {
+    return absolute(output).lexically_relative(mDir).generic_string();
+}
+
+// 'known' is the state stored in the manifest: when size and time match it, its hash is reused instead of reading the file
+ConversionManifest::FileState const &ConversionManifest::CurrentState(string const &filePath, FileState const *known) {
+    auto it = mCurrentStates.find(filePath);
+    if (it != mCurrentStates.end())
+        return (*it).second;
+    FileState &state = mCurrentStates[filePath];
+    state.path = filePath;
+    error_code ec;
+    path p = filePath;
+    if (is_regular_file(p, ec)) {
+        state.size = file_size(p, ec);
+        state.time = last_write_time(p, ec).time_since_epoch().count();
+        if (known && known->exists && known->size == state.size && known->time == state.time) {
+            state.exists = true;
+            state.hash = known->hash;
+        }
+        else
+            state.exists = HashFile(p, state.hash);
+    }
+    return state;
+}
+
+void ConversionManifest::BeginPass() {
+    mCurrentStates.clear();
+}
+
+void ConversionManifest::Load(path const &dir, string const &optionsKey) {
+    mDir = absolute(dir);
+    mOptionsKey = optionsKey;
+    mEntries.clear();
+    mCurrentStates.clear();
+    mChanged = false;
+    BinaryReader reader;
+    path manifestPath = mDir / FILENAME;
+    if (!exists(manifestPath) || !reader.Open(manifestPath))
+        return;
+    if (reader.Get<unsigned int>() != MANIFEST_SIGNATURE || reader.Get<unsigned int>() != MANIFEST_VERSION)
+        return;
+    unsigned int numEntries = reader.GetCount();
+    for (unsigned int e = 0; e < numEntries && !reader.Failed(); e++) {
+        string output = reader.GetString();
+        Entry entry;
+        entry.optionsKey = reader.GetString();
+        entry.files.resize(reader.GetCount());
+        for (auto &f : entry.files) {
+            f.path = reader.GetString();
+            f.exists = reader.Get<unsigned char>() != 0;
+            f.size = reader.Get<unsigned long long>();
+            f.time = reader.Get<long long>();
+            f.hash = reader.Get<unsigned long long>();
+        }
+        mEntries[output] = move(entry);
+    }
+    if (reader.Failed() || !reader.AtEnd())
+        mEntries.clear();
+}
+
+bool ConversionManifest::Save() {
+    if (!mChanged)
+        return true;
+    BinaryBuffer buf;
+    buf.Put(MANIFEST_SIGNATURE);
+    buf.Put(MANIFEST_VERSION);
+    buf.Put<unsigned int>(mEntries.size());
+    for (auto const &[output, entry] : mEntries) {
+        buf.Put(output);
+        buf.Put(entry.optionsKey);
+        buf.Put<unsigned int>(entry.files.size());
+        for (auto const &f : entry.files) {
+            buf.Put(f.path);
+            buf.Put<unsigned char>(f.exists ? 1 : 0);
+            buf.Put(f.size);
+            buf.Put(f.time);
+            buf.Put(f.hash);
+        }
+    }
+    create_directories(mDir);
+    if (!buf.WriteToFile(mDir / FILENAME))
+        return false;
+    mChanged = false;
+    return true;
+}
+
+bool ConversionManifest::IsUpToDate(path const &output, path const &input, string const &extraKey) {
+    auto it = mEntries.find(OutputKey(output));
+    if (it == mEntries.end() || !exists(output))
+        return false;
+    auto &entry = (*it).second;
+    if (entry.optionsKey != mOptionsKey + extraKey || entry.files.empty() || entry.files[0].path != absolute(input).string())
+        return false;
+    for (auto &f : entry.files) {
+        auto const &current = CurrentState(f.path, &f);
+        if (current.exists != f.exists || (current.exists && current.hash != f.hash))
+            return false;
+        // only the time changed (e.g. a fresh checkout), remember it so the file isn't hashed again next run
+        if (current.exists && (current.size != f.size || current.time != f.time)) {
+            f.size = current.size;
+            f.time = current.time;
+            mChanged = true;
+        }
+    }
+    return true;
+}
+
+void ConversionManifest::Record(path const &output, path const &input, vector<path> const &dependencies, string const &extraKey) {
+    Entry entry;
+    entry.optionsKey = mOptionsKey + extraKey;
+    vector<string> filePaths = { absolute(input).string() };
+    for (auto const &d : dependencies) {
+        string depPath = absolute(d).string();
+        if (find(filePaths.begin(), filePaths.end(), depPath) == filePaths.end())
+            filePaths.push_back(depPath);
+    }
+    for (auto const &filePath : filePaths) {
+        // the input may have been rewritten by the conversion itself, so its state is re-read
+        mCurrentStates.erase(filePath);
+        entry.files.push_back(CurrentState(filePath));
+    }
+    mEntries[OutputKey(output)] = move(entry);
+    mChanged = true;
+}
+
+vector<path> ConversionManifest::DependencyFolders() const {
+    vector<path> result;
+    for (auto const &[output, entry] : mEntries) {
+        for (auto const &f : entry.files) {
+            path folder = path(f.path).parent_path();
+            if (find(result.begin(), result.end(), folder) == result.end())
+                result.push_back(folder);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
+
+// Manifest for incremental folder conversions (-incremental). For every output it stores the state of the input file and
+// the side files read while producing it (textures, skeletons, stadium files...), plus the options and OTools version.
+// An output is skipped when all of them are unchanged; a file with a new modification time is compared by content hash.
+class ConversionManifest {
+public:
+    struct FileState {
+        std::string path;
+        bool exists = false;
+        unsigned long long size = 0;
+        long long time = 0;
+        unsigned long long hash = 0;
+    };
+
+    struct Entry {
+        std::string optionsKey;
+        std::vector<FileState> files; // input file first, then dependencies
+    };
+private:
+    std::filesystem::path mDir;
+    std::string mOptionsKey;
+    std::map<std::string, Entry> mEntries;
+    std::map<std::string, FileState> mCurrentStates; // files already checked in this run
+    bool mChanged = false;
+
+    std::string OutputKey(std::filesystem::path const &output) const;
+    FileState const &CurrentState(std::string const &filePath, FileState const *known = nullptr);
+public:
+    static const char FILENAME[];
+
+    void Load(std::filesystem::path const &dir, std::string const &optionsKey);
+    bool Save();
+    // forgets the file states read in the previous pass (-watch), so edited files are read again
+    void BeginPass();
+    // extraKey is compared together with the options (e.g. the list of images packed into a fsh)
+    bool IsUpToDate(std::filesystem::path const &output, std::filesystem::path const &input, std::string const &extraKey = std::string());
+    void Record(std::filesystem::path const &output, std::filesystem::path const &input, std::vector<std::filesystem::path> const &dependencies,
+        std::string const &extraKey = std::string());
+    // folders of all recorded inputs and dependencies (-watch)
+    std::vector<std::filesystem::path> DependencyFolders() const;
+};
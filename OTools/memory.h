@@ -2,7 +2,7 @@
 
 template<typename T>
 T *At(void *object, unsigned int offset) {
-    return (T *)((unsigned int)object + offset);
+    return (T *)((unsigned char *)object + offset);
 }
 
 template<typename T>
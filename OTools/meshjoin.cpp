@@ -0,0 +1,272 @@
+#include "meshjoin.h"
+#include <assimp\scene.h>
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+unsigned long long HashBytes(unsigned char const *data, unsigned int size) {
+    unsigned long long hash = 14695981039346656037ull;
+    for (unsigned int i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// value stored in the weld key in place of a float
+int QuantizeFloat(float value, float epsilon) {
+    if (value == 0.0f) // -0.0 and 0.0
+        return 0;
+    if (epsilon <= 0.0f) {
+        int bits;
+        memcpy(&bits, &value, 4);
+        return bits;
+    }
+    double cell = floor(double(value) / epsilon + 0.5);
+    if (cell > INT_MAX)
+        return INT_MAX;
+    if (cell < INT_MIN)
+        return INT_MIN;
+    return int(cell);
+}
+
+template<typename T>
+void Concat(T *&dst, unsigned int dstCount, T const *src, unsigned int srcCount) {
+    T *result = new T[dstCount + srcCount];
+    for (unsigned int i = 0; i < dstCount; i++)
+        result[i] = dst[i];
+    for (unsigned int i = 0; i < srcCount; i++)
+        result[dstCount + i] = src[i];
+    delete[] dst;
+    dst = result;
+}
+
+bool SameVertexFormat(aiMesh const *a, aiMesh const *b) {
+    if (a->mMaterialIndex != b->mMaterialIndex || a->mPrimitiveTypes != b->mPrimitiveTypes || a->HasNormals() != b->HasNormals() ||
+        a->HasTangentsAndBitangents() != b->HasTangentsAndBitangents() || a->HasBones() != b->HasBones())
+    {
+        return false;
+    }
+    for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++) {
+        if (a->HasVertexColors(c) != b->HasVertexColors(c))
+            return false;
+    }
+    for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+        if (a->HasTextureCoords(t) != b->HasTextureCoords(t) || (a->HasTextureCoords(t) && a->mNumUVComponents[t] != b->mNumUVComponents[t]))
+            return false;
+    }
+    return true;
+}
+
+void AppendMesh(aiMesh *dst, aiMesh const *src) {
+    unsigned int dstVerts = dst->mNumVertices;
+    unsigned int srcVerts = src->mNumVertices;
+    Concat(dst->mVertices, dstVerts, src->mVertices, srcVerts);
+    if (dst->mNormals)
+        Concat(dst->mNormals, dstVerts, src->mNormals, srcVerts);
+    if (dst->mTangents) {
+        Concat(dst->mTangents, dstVerts, src->mTangents, srcVerts);
+        Concat(dst->mBitangents, dstVerts, src->mBitangents, srcVerts);
+    }
+    for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++) {
+        if (dst->mColors[c])
+            Concat(dst->mColors[c], dstVerts, src->mColors[c], srcVerts);
+    }
+    for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+        if (dst->mTextureCoords[t])
+            Concat(dst->mTextureCoords[t], dstVerts, src->mTextureCoords[t], srcVerts);
+    }
+    // faces: the existing index arrays are moved, the appended ones are offset
+    aiFace *faces = new aiFace[dst->mNumFaces + src->mNumFaces];
+    for (unsigned int f = 0; f < dst->mNumFaces; f++) {
+        faces[f].mNumIndices = dst->mFaces[f].mNumIndices;
+        faces[f].mIndices = dst->mFaces[f].mIndices;
+        dst->mFaces[f].mNumIndices = 0;
+        dst->mFaces[f].mIndices = nullptr;
+    }
+    for (unsigned int f = 0; f < src->mNumFaces; f++) {
+        aiFace const &srcFace = src->mFaces[f];
+        aiFace &face = faces[dst->mNumFaces + f];
+        face.mNumIndices = srcFace.mNumIndices;
+        face.mIndices = new unsigned int[srcFace.mNumIndices];
+        for (unsigned int i = 0; i < srcFace.mNumIndices; i++)
+            face.mIndices[i] = srcFace.mIndices[i] + dstVerts;
+    }
+    delete[] dst->mFaces;
+    dst->mFaces = faces;
+    dst->mNumFaces += src->mNumFaces;
+    // bones with the same name are joined, their weights are offset
+    if (src->mNumBones) {
+        vector<aiBone *> bones(dst->mBones, dst->mBones + dst->mNumBones);
+        for (unsigned int b = 0; b < src->mNumBones; b++) {
+            aiBone const *srcBone = src->mBones[b];
+            aiBone *bone = nullptr;
+            for (auto existing : bones) {
+                if (existing->mName == srcBone->mName) {
+                    bone = existing;
+                    break;
+                }
+            }
+            if (!bone) {
+                bone = new aiBone();
+                bone->mName = srcBone->mName;
+                bone->mOffsetMatrix = srcBone->mOffsetMatrix;
+                bone->mNode = srcBone->mNode;
+                bone->mArmature = srcBone->mArmature;
+                bones.push_back(bone);
+            }
+            aiVertexWeight *weights = new aiVertexWeight[bone->mNumWeights + srcBone->mNumWeights];
+            for (unsigned int w = 0; w < bone->mNumWeights; w++)
+                weights[w] = bone->mWeights[w];
+            for (unsigned int w = 0; w < srcBone->mNumWeights; w++) {
+                weights[bone->mNumWeights + w].mVertexId = srcBone->mWeights[w].mVertexId + dstVerts;
+                weights[bone->mNumWeights + w].mWeight = srcBone->mWeights[w].mWeight;
+            }
+            delete[] bone->mWeights;
+            bone->mWeights = weights;
+            bone->mNumWeights += srcBone->mNumWeights;
+        }
+        delete[] dst->mBones;
+        dst->mBones = new aiBone *[bones.size()];
+        for (unsigned int b = 0; b < bones.size(); b++)
+            dst->mBones[b] = bones[b];
+        dst->mNumBones = unsigned int(bones.size());
+    }
+    dst->mNumVertices += srcVerts;
+}
+
+void CountMeshUsers(aiNode const *node, vector<unsigned int> &users) {
+    for (unsigned int m = 0; m < node->mNumMeshes; m++)
+        users[node->mMeshes[m]]++;
+    for (unsigned int c = 0; c < node->mNumChildren; c++)
+        CountMeshUsers(node->mChildren[c], users);
+}
+
+void MergeNodeMeshes(aiScene *scene, aiNode *node, vector<unsigned int> const &users, vector<bool> &removed, unsigned int maxVertices) {
+    vector<unsigned int> kept;
+    for (unsigned int m = 0; m < node->mNumMeshes; m++) {
+        unsigned int meshIndex = node->mMeshes[m];
+        aiMesh *mesh = scene->mMeshes[meshIndex];
+        bool merged = false;
+        if (users[meshIndex] == 1 && mesh->mNumAnimMeshes == 0) {
+            for (auto target : kept) {
+                aiMesh *targetMesh = scene->mMeshes[target];
+                if (users[target] == 1 && targetMesh->mNumAnimMeshes == 0 && SameVertexFormat(targetMesh, mesh) &&
+                    targetMesh->mNumVertices + mesh->mNumVertices <= maxVertices)
+                {
+                    AppendMesh(targetMesh, mesh);
+                    removed[meshIndex] = true;
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        if (!merged)
+            kept.push_back(meshIndex);
+    }
+    if (kept.size() != node->mNumMeshes) {
+        for (unsigned int m = 0; m < kept.size(); m++)
+            node->mMeshes[m] = kept[m];
+        node->mNumMeshes = unsigned int(kept.size());
+    }
+    for (unsigned int c = 0; c < node->mNumChildren; c++)
+        MergeNodeMeshes(scene, node->mChildren[c], users, removed, maxVertices);
+}
+
+void RemapNodeMeshes(aiNode *node, vector<unsigned int> const &newIndices) {
+    for (unsigned int m = 0; m < node->mNumMeshes; m++)
+        node->mMeshes[m] = newIndices[node->mMeshes[m]];
+    for (unsigned int c = 0; c < node->mNumChildren; c++)
+        RemapNodeMeshes(node->mChildren[c], newIndices);
+}
+
+}
+
+unsigned int WeldVertices(unsigned char *vertices, unsigned int vertexSize, unsigned int numVertices, unsigned short *indices,
+    unsigned int numIndices, vector<WeldFloatRange> const &floatRanges, float epsilon)
+{
+    if (numVertices < 2 || vertexSize == 0)
+        return numVertices;
+    // keys: the vertex bytes with the float ranges replaced by their quantized values
+    vector<unsigned char> keys(vertices, vertices + size_t(vertexSize) * numVertices);
+    for (unsigned int v = 0; v < numVertices; v++) {
+        unsigned char *key = &keys[size_t(v) * vertexSize];
+        for (auto const &r : floatRanges) {
+            for (unsigned int c = 0; c < r.count && r.offset + c * 4 + 4 <= vertexSize; c++) {
+                float value;
+                memcpy(&value, key + r.offset + c * 4, 4);
+                int q = QuantizeFloat(value, epsilon);
+                memcpy(key + r.offset + c * 4, &q, 4);
+            }
+        }
+    }
+    // open addressing table of new vertex indices
+    unsigned int tableSize = 1;
+    while (tableSize < numVertices * 2)
+        tableSize *= 2;
+    static const unsigned int EMPTY = UINT_MAX;
+    vector<unsigned int> table(tableSize, EMPTY);
+    vector<unsigned int> firstOccurrence; // new vertex > old vertex
+    vector<unsigned int> remap(numVertices);
+    firstOccurrence.reserve(numVertices);
+    for (unsigned int v = 0; v < numVertices; v++) {
+        unsigned char const *key = &keys[size_t(v) * vertexSize];
+        unsigned int slot = unsigned int(HashBytes(key, vertexSize)) & (tableSize - 1);
+        while (true) {
+            unsigned int entry = table[slot];
+            if (entry == EMPTY) {
+                table[slot] = unsigned int(firstOccurrence.size());
+                remap[v] = unsigned int(firstOccurrence.size());
+                firstOccurrence.push_back(v);
+                break;
+            }
+            if (!memcmp(&keys[size_t(firstOccurrence[entry]) * vertexSize], key, vertexSize)) {
+                remap[v] = entry;
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+    }
+    unsigned int newNumVertices = unsigned int(firstOccurrence.size());
+    if (newNumVertices == numVertices)
+        return numVertices;
+    // first occurrences are increasing, so the records only move towards the start
+    for (unsigned int v = 0; v < newNumVertices; v++) {
+        if (firstOccurrence[v] != v)
+            memcpy(vertices + size_t(v) * vertexSize, vertices + size_t(firstOccurrence[v]) * vertexSize, vertexSize);
+    }
+    for (unsigned int i = 0; i < numIndices; i++) {
+        if (indices[i] < numVertices)
+            indices[i] = unsigned short(remap[indices[i]]);
+    }
+    return newNumVertices;
+}
+
+unsigned int MergeMeshes(aiScene *scene, unsigned int maxVertices) {
+    if (!scene || !scene->mRootNode || scene->mNumMeshes < 2)
+        return 0;
+    vector<unsigned int> users(scene->mNumMeshes, 0);
+    CountMeshUsers(scene->mRootNode, users);
+    vector<bool> removed(scene->mNumMeshes, false);
+    MergeNodeMeshes(scene, scene->mRootNode, users, removed, maxVertices);
+    vector<unsigned int> newIndices(scene->mNumMeshes, 0);
+    unsigned int numMeshes = 0;
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+        if (removed[m]) {
+            delete scene->mMeshes[m];
+            continue;
+        }
+        newIndices[m] = numMeshes;
+        scene->mMeshes[numMeshes++] = scene->mMeshes[m];
+    }
+    unsigned int numRemoved = scene->mNumMeshes - numMeshes;
+    scene->mNumMeshes = numMeshes;
+    if (numRemoved)
+        RemapNodeMeshes(scene->mRootNode, newIndices);
+    return numRemoved;
+}
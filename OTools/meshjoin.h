@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+
+struct aiScene;
+
+// Vertex welding and mesh merging for exported models (used instead of Assimp's JoinIdenticalVertices and OptimizeMeshes).
+
+struct WeldFloatRange {
+    unsigned int offset = 0; // in the vertex
+    unsigned int count = 0; // number of floats
+};
+
+// Welds equal vertices of an interleaved vertex buffer used by a 16-bit triangle index list. Vertices are compared as whole
+// records (position, normal, uv, colour and skin data together); the float ranges are snapped to a grid of 'epsilon' first,
+// epsilon 0 compares them exactly. The buffer is compacted in place, first occurrences keep their order, and the indices are
+// remapped in one pass. Returns the new number of vertices.
+unsigned int WeldVertices(unsigned char *vertices, unsigned int vertexSize, unsigned int numVertices, unsigned short *indices,
+    unsigned int numIndices, std::vector<WeldFloatRange> const &floatRanges, float epsilon);
+
+// Joins the meshes of each node which share the material and the vertex format into one mesh, as long as the result stays
+// within maxVertices. Meshes used by several nodes are left alone. Returns the number of meshes removed from the scene.
+unsigned int MergeMeshes(aiScene *scene, unsigned int maxVertices);
@@ -169,6 +169,24 @@ unsigned int Hash(std::string const &str) {
     return hash;
 }
 
+bool HashFile(std::filesystem::path const &filePath, unsigned long long &hash) {
+    FILE *f = _wfopen(filePath.c_str(), L"rb");
+    if (!f)
+        return false;
+    static const size_t CHUNK_SIZE = 64 * 1024;
+    std::vector<unsigned char> chunk(CHUNK_SIZE);
+    hash = 14695981039346656037ull;
+    size_t numRead = 0;
+    while ((numRead = fread(chunk.data(), 1, CHUNK_SIZE, f)) > 0) {
+        for (size_t i = 0; i < numRead; i++) {
+            hash ^= chunk[i];
+            hash *= 1099511628211ull;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
 UINT MessageIcon(unsigned int iconType) {
     if (iconType == 1)
         return MB_ICONWARNING;
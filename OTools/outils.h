@@ -94,6 +94,8 @@ bool Warning(std::wstring const &format, ArgTypes... args) {
 }
 
 unsigned int Hash(std::string const &str);
+// FNV-1a over the file contents
+bool HashFile(std::filesystem::path const &filePath, unsigned long long &hash);
 
 template<typename T>
 T SafeConvertInt(std::wstring const &str, bool isHex = false) {
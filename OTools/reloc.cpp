@@ -0,0 +1,44 @@
+#include "reloc.h"
+#include "memory.h"
+
+RelocView::RelocView() {}
+
+RelocView::RelocView(unsigned char *data, unsigned int size) {
+    mData = data;
+    mSize = size;
+    mRelocated.resize(size, false);
+}
+
+void RelocView::AddRelocation(unsigned int offset) {
+    if (offset < mSize && mSize - offset >= 4)
+        mRelocated[offset] = true;
+}
+
+bool RelocView::IsRelocated(unsigned int offset) const {
+    return offset < mSize && mRelocated[offset];
+}
+
+bool RelocView::Contains(void const *p) const {
+    return p >= mData && p < mData + mSize;
+}
+
+unsigned int RelocView::OffsetOf(void const *p) const {
+    return unsigned int((unsigned char const *)p - mData);
+}
+
+unsigned char *RelocView::Resolve(unsigned int offset) const {
+    if (!IsRelocated(offset))
+        return nullptr;
+    unsigned int target = GetAt<unsigned int>(mData, offset);
+    if (target >= mSize)
+        return nullptr;
+    return &mData[target];
+}
+
+unsigned char *RelocView::Data() const {
+    return mData;
+}
+
+unsigned int RelocView::Size() const {
+    return mSize;
+}
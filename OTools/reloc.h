@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+
+// 32-bit pointer field in a .o data section. The stored value is an offset from the section start
+// and only means something when the field has a relocation entry - resolve it with RelocView::Get().
+template<typename T>
+struct Ptr32 {
+    unsigned int value;
+};
+
+static_assert(sizeof(Ptr32<void>) == 4);
+
+// Read-only view over a .o data section. Relocations are registered instead of being written into
+// the buffer and pointer fields are resolved on access, so readers don't depend on the host pointer size.
+class RelocView {
+    unsigned char *mData = nullptr;
+    unsigned int mSize = 0;
+    std::vector<bool> mRelocated;
+public:
+    RelocView();
+    RelocView(unsigned char *data, unsigned int size);
+    void AddRelocation(unsigned int offset);
+    bool IsRelocated(unsigned int offset) const;
+    bool Contains(void const *p) const;
+    unsigned int OffsetOf(void const *p) const;
+    unsigned char *Resolve(unsigned int offset) const;
+    unsigned char *Data() const;
+    unsigned int Size() const;
+
+    // pointer stored at the given offset in the object; nullptr when the field is not relocated
+    template<typename T>
+    T *Get(void const *object, unsigned int offset) const {
+        return Contains(object) ? (T *)Resolve(OffsetOf(object) + offset) : nullptr;
+    }
+
+    template<typename T>
+    T *Get(Ptr32<T> const &field) const {
+        return Get<T>(&field, 0);
+    }
+};
@@ -0,0 +1,364 @@
+#include "scenecache.h"
+#include "binbuf.h"
+#include "outils.h"
+#include <assimp\Importer.hpp>
+#include <assimp\config.h>
+#include <assimp\version.h>
+#include <climits>
+#include <vector>
+
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+
+const unsigned int SCENE_CACHE_SIGNATURE = 0x4E43534F; // 'OSCN'
+const unsigned int SCENE_CACHE_VERSION = 2;
+
+// importer properties set by oimport, a different value gives a different cache entry
+const char *INT_PROPERTIES[] = { AI_CONFIG_PP_SBP_REMOVE, AI_CONFIG_IMPORT_REMOVE_EMPTY_BONES, AI_CONFIG_PP_SLM_VERTEX_LIMIT, AI_CONFIG_PP_LBW_MAX_WEIGHTS };
+const char *FLOAT_PROPERTIES[] = { AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY };
+
+enum MeshArrays {
+    ARRAY_NORMALS = 1,
+    ARRAY_TANGENTS = 2,
+    ARRAY_BITANGENTS = 4
+};
+
+template<typename T>
+void PutArray(BinaryBuffer &buf, T const *data, unsigned int count) {
+    buf.Put(data, count * sizeof(T));
+}
+
+template<typename T>
+T *GetArray(BinaryReader &reader, unsigned int count) {
+    T *data = new T[count];
+    reader.Get(data, size_t(count) * sizeof(T));
+    return data;
+}
+
+void PutNode(BinaryBuffer &buf, aiNode const *node) {
+    buf.Put(string(node->mName.C_Str()));
+    buf.Put(node->mTransformation);
+    buf.Put(node->mNumMeshes);
+    PutArray(buf, node->mMeshes, node->mNumMeshes);
+    buf.Put(node->mNumChildren);
+    for (unsigned int c = 0; c < node->mNumChildren; c++)
+        PutNode(buf, node->mChildren[c]);
+}
+
+aiNode *GetNode(BinaryReader &reader, aiNode *parent, unsigned int numMeshes, unsigned int depth) {
+    auto node = make_unique<aiNode>(reader.GetString());
+    node->mParent = parent;
+    node->mTransformation = reader.Get<aiMatrix4x4>();
+    unsigned int nodeMeshes = reader.GetCount();
+    if (nodeMeshes) {
+        node->mMeshes = GetArray<unsigned int>(reader, nodeMeshes);
+        node->mNumMeshes = nodeMeshes;
+        for (unsigned int m = 0; m < nodeMeshes; m++) {
+            if (node->mMeshes[m] >= numMeshes)
+                return nullptr;
+        }
+    }
+    unsigned int numChildren = reader.GetCount();
+    if (numChildren) {
+        if (depth > 1024)
+            return nullptr;
+        node->mChildren = new aiNode *[numChildren];
+        for (unsigned int c = 0; c < numChildren; c++) {
+            node->mChildren[c] = GetNode(reader, node.get(), numMeshes, depth + 1);
+            if (!node->mChildren[c])
+                return nullptr;
+            node->mNumChildren++;
+        }
+    }
+    return reader.Failed() ? nullptr : node.release();
+}
+
+void PutMesh(BinaryBuffer &buf, aiMesh const *mesh) {
+    buf.Put(string(mesh->mName.C_Str()));
+    buf.Put(mesh->mPrimitiveTypes);
+    buf.Put(mesh->mMaterialIndex);
+    unsigned int numVertices = mesh->mNumVertices;
+    buf.Put(numVertices);
+    unsigned int arrays = 0;
+    if (mesh->mNormals)
+        arrays |= ARRAY_NORMALS;
+    if (mesh->mTangents)
+        arrays |= ARRAY_TANGENTS;
+    if (mesh->mBitangents)
+        arrays |= ARRAY_BITANGENTS;
+    buf.Put(arrays);
+    PutArray(buf, mesh->mVertices, numVertices);
+    if (mesh->mNormals)
+        PutArray(buf, mesh->mNormals, numVertices);
+    if (mesh->mTangents)
+        PutArray(buf, mesh->mTangents, numVertices);
+    if (mesh->mBitangents)
+        PutArray(buf, mesh->mBitangents, numVertices);
+    unsigned int colorSets = 0;
+    for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++) {
+        if (mesh->mColors[c])
+            colorSets |= 1 << c;
+    }
+    buf.Put(colorSets);
+    for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++) {
+        if (mesh->mColors[c])
+            PutArray(buf, mesh->mColors[c], numVertices);
+    }
+    unsigned int uvSets = 0;
+    for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+        if (mesh->mTextureCoords[t])
+            uvSets |= 1 << t;
+    }
+    buf.Put(uvSets);
+    for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+        if (mesh->mTextureCoords[t]) {
+            buf.Put(mesh->mNumUVComponents[t]);
+            PutArray(buf, mesh->mTextureCoords[t], numVertices);
+        }
+    }
+    buf.Put(mesh->mNumFaces);
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+        auto const &face = mesh->mFaces[f];
+        buf.Put(face.mNumIndices);
+        PutArray(buf, face.mIndices, face.mNumIndices);
+    }
+    buf.Put(mesh->mNumBones);
+    for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+        aiBone const *bone = mesh->mBones[b];
+        buf.Put(string(bone->mName.C_Str()));
+        buf.Put(bone->mOffsetMatrix);
+        buf.Put(bone->mNumWeights);
+        PutArray(buf, bone->mWeights, bone->mNumWeights);
+    }
+}
+
+bool GetMesh(BinaryReader &reader, aiMesh *mesh, unsigned int numMaterials) {
+    mesh->mName = reader.GetString();
+    mesh->mPrimitiveTypes = reader.Get<unsigned int>();
+    mesh->mMaterialIndex = reader.Get<unsigned int>();
+    if (mesh->mMaterialIndex >= numMaterials)
+        return false;
+    unsigned int numVertices = reader.GetCount();
+    mesh->mNumVertices = numVertices;
+    unsigned int arrays = reader.Get<unsigned int>();
+    mesh->mVertices = GetArray<aiVector3D>(reader, numVertices);
+    if (arrays & ARRAY_NORMALS)
+        mesh->mNormals = GetArray<aiVector3D>(reader, numVertices);
+    if (arrays & ARRAY_TANGENTS)
+        mesh->mTangents = GetArray<aiVector3D>(reader, numVertices);
+    if (arrays & ARRAY_BITANGENTS)
+        mesh->mBitangents = GetArray<aiVector3D>(reader, numVertices);
+    unsigned int colorSets = reader.Get<unsigned int>();
+    for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++) {
+        if (colorSets & (1 << c))
+            mesh->mColors[c] = GetArray<aiColor4D>(reader, numVertices);
+    }
+    unsigned int uvSets = reader.Get<unsigned int>();
+    for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+        if (uvSets & (1 << t)) {
+            mesh->mNumUVComponents[t] = reader.Get<unsigned int>();
+            mesh->mTextureCoords[t] = GetArray<aiVector3D>(reader, numVertices);
+        }
+    }
+    unsigned int numFaces = reader.GetCount();
+    if (numFaces) {
+        mesh->mFaces = new aiFace[numFaces];
+        mesh->mNumFaces = numFaces;
+        for (unsigned int f = 0; f < numFaces; f++) {
+            aiFace &face = mesh->mFaces[f];
+            face.mNumIndices = reader.GetCount();
+            face.mIndices = GetArray<unsigned int>(reader, face.mNumIndices);
+            for (unsigned int i = 0; i < face.mNumIndices; i++) {
+                if (face.mIndices[i] >= numVertices)
+                    return false;
+            }
+        }
+    }
+    unsigned int numBones = reader.GetCount();
+    if (numBones) {
+        mesh->mBones = new aiBone *[numBones]();
+        mesh->mNumBones = numBones;
+        for (unsigned int b = 0; b < numBones; b++) {
+            aiBone *bone = mesh->mBones[b] = new aiBone();
+            bone->mName = reader.GetString();
+            bone->mOffsetMatrix = reader.Get<aiMatrix4x4>();
+            bone->mNumWeights = reader.GetCount();
+            bone->mWeights = GetArray<aiVertexWeight>(reader, bone->mNumWeights);
+        }
+    }
+    return !reader.Failed();
+}
+
+}
+
+SideFileRecorder::SideFileRecorder(path const &input) {
+    error_code ec;
+    mInput = weakly_canonical(absolute(input), ec);
+}
+
+Assimp::IOStream *SideFileRecorder::Open(const char *pFile, const char *pMode) {
+    Assimp::IOStream *stream = DefaultIOSystem::Open(pFile, pMode);
+    if (stream && pMode && pMode[0] == 'r') {
+        error_code ec;
+        path filePath = weakly_canonical(absolute(path(pFile)), ec);
+        if (filePath != mInput && find(mSideFiles.begin(), mSideFiles.end(), filePath) == mSideFiles.end())
+            mSideFiles.push_back(filePath);
+    }
+    return stream;
+}
+
+bool SceneCache::Init(path const &cacheDir, path const &input, unsigned int postProcessFlags, Assimp::Importer const &importer) {
+    if (!HashFile(input, mInputHash))
+        return false;
+    mSettings = Format("assimp=%u.%u.%u.%X flags=%X", aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionPatch(), aiGetVersionRevision(),
+        postProcessFlags);
+    for (auto name : INT_PROPERTIES)
+        mSettings += Format(" %s=%d", name, importer.GetPropertyInteger(name, INT_MIN));
+    for (auto name : FLOAT_PROPERTIES)
+        mSettings += Format(" %s=%g", name, importer.GetPropertyFloat(name, -1.0f));
+    mFile = cacheDir / Format("%s_%016llX_%08X.oscene", input.stem().string().c_str(), mInputHash, Hash(mSettings));
+    return true;
+}
+
+unique_ptr<aiScene> SceneCache::Load(vector<path> &sideFiles) const {
+    BinaryReader reader;
+    if (mFile.empty() || !exists(mFile) || !reader.Open(mFile))
+        return nullptr;
+    if (reader.Get<unsigned int>() != SCENE_CACHE_SIGNATURE || reader.Get<unsigned int>() != SCENE_CACHE_VERSION)
+        return nullptr;
+    // the file name only has hashes of these
+    if (reader.Get<unsigned long long>() != mInputHash || reader.GetString() != mSettings)
+        return nullptr;
+    // a changed side file (an edited .mtl or .bin) makes the entry stale
+    sideFiles.clear();
+    unsigned int numSideFiles = reader.GetCount();
+    for (unsigned int f = 0; f < numSideFiles; f++) {
+        path sideFile = reader.GetString();
+        unsigned long long storedHash = reader.Get<unsigned long long>();
+        unsigned long long hash = 0;
+        if (reader.Failed() || !HashFile(sideFile, hash) || hash != storedHash)
+            return nullptr;
+        sideFiles.push_back(sideFile);
+    }
+    auto scene = make_unique<aiScene>();
+    scene->mFlags = reader.Get<unsigned int>();
+    unsigned int numTextures = reader.GetCount();
+    if (numTextures) {
+        scene->mTextures = new aiTexture *[numTextures]();
+        scene->mNumTextures = numTextures;
+        for (unsigned int t = 0; t < numTextures; t++) {
+            aiTexture *tex = scene->mTextures[t] = new aiTexture();
+            tex->mWidth = reader.Get<unsigned int>();
+            tex->mHeight = reader.Get<unsigned int>();
+            reader.Get(tex->achFormatHint, HINTMAXTEXTURELEN);
+            tex->achFormatHint[HINTMAXTEXTURELEN - 1] = '\0';
+            tex->mFilename = reader.GetString();
+            unsigned int dataSize = reader.GetCount();
+            if (dataSize != (tex->mHeight ? tex->mWidth * tex->mHeight * sizeof(aiTexel) : tex->mWidth))
+                return nullptr;
+            tex->pcData = new aiTexel[(dataSize + sizeof(aiTexel) - 1) / sizeof(aiTexel)];
+            reader.Get(tex->pcData, dataSize);
+        }
+    }
+    unsigned int numMaterials = reader.GetCount();
+    if (numMaterials) {
+        scene->mMaterials = new aiMaterial *[numMaterials]();
+        scene->mNumMaterials = numMaterials;
+        for (unsigned int m = 0; m < numMaterials; m++) {
+            aiMaterial *mat = scene->mMaterials[m] = new aiMaterial();
+            unsigned int numProperties = reader.GetCount();
+            for (unsigned int p = 0; p < numProperties && !reader.Failed(); p++) {
+                string key = reader.GetString();
+                unsigned int semantic = reader.Get<unsigned int>();
+                unsigned int index = reader.Get<unsigned int>();
+                auto type = aiPropertyTypeInfo(reader.Get<unsigned int>());
+                vector<char> data(reader.GetCount());
+                reader.Get(data.data(), data.size());
+                mat->AddBinaryProperty(data.data(), unsigned int(data.size()), key.c_str(), semantic, index, type);
+            }
+        }
+    }
+    unsigned int numMeshes = reader.GetCount();
+    if (numMeshes) {
+        scene->mMeshes = new aiMesh *[numMeshes]();
+        scene->mNumMeshes = numMeshes;
+        for (unsigned int m = 0; m < numMeshes; m++) {
+            scene->mMeshes[m] = new aiMesh();
+            if (!GetMesh(reader, scene->mMeshes[m], numMaterials))
+                return nullptr;
+        }
+    }
+    scene->mRootNode = GetNode(reader, nullptr, numMeshes, 0);
+    if (!scene->mRootNode || reader.Failed() || !reader.AtEnd())
+        return nullptr;
+    // what aiProcess_PopulateArmatureData gives to oimport
+    for (unsigned int m = 0; m < numMeshes; m++) {
+        aiMesh *mesh = scene->mMeshes[m];
+        for (unsigned int b = 0; b < mesh->mNumBones; b++)
+            mesh->mBones[b]->mNode = scene->mRootNode->FindNode(mesh->mBones[b]->mName);
+    }
+    return scene;
+}
+
+bool SceneCache::Store(aiScene const *scene, vector<path> const &sideFiles) const {
+    if (mFile.empty() || !scene || !scene->mRootNode)
+        return false;
+    BinaryBuffer buf;
+    buf.Put(SCENE_CACHE_SIGNATURE);
+    buf.Put(SCENE_CACHE_VERSION);
+    buf.Put(mInputHash);
+    buf.Put(mSettings);
+    buf.Put(unsigned int(sideFiles.size()));
+    for (auto const &sideFile : sideFiles) {
+        unsigned long long hash = 0;
+        if (!HashFile(sideFile, hash))
+            return false;
+        buf.Put(sideFile.string());
+        buf.Put(hash);
+    }
+    buf.Put(scene->mFlags);
+    buf.Put(scene->mNumTextures);
+    for (unsigned int t = 0; t < scene->mNumTextures; t++) {
+        aiTexture const *tex = scene->mTextures[t];
+        buf.Put(tex->mWidth);
+        buf.Put(tex->mHeight);
+        buf.Put(tex->achFormatHint, HINTMAXTEXTURELEN);
+        buf.Put(string(tex->mFilename.C_Str()));
+        unsigned int dataSize = tex->mHeight ? tex->mWidth * tex->mHeight * sizeof(aiTexel) : tex->mWidth;
+        buf.Put(dataSize);
+        buf.Put(tex->pcData, dataSize);
+    }
+    buf.Put(scene->mNumMaterials);
+    for (unsigned int m = 0; m < scene->mNumMaterials; m++) {
+        aiMaterial const *mat = scene->mMaterials[m];
+        buf.Put(mat->mNumProperties);
+        for (unsigned int p = 0; p < mat->mNumProperties; p++) {
+            aiMaterialProperty const *prop = mat->mProperties[p];
+            buf.Put(string(prop->mKey.C_Str()));
+            buf.Put(prop->mSemantic);
+            buf.Put(prop->mIndex);
+            buf.Put<unsigned int>(prop->mType);
+            buf.Put(prop->mDataLength);
+            buf.Put(prop->mData, prop->mDataLength);
+        }
+    }
+    buf.Put(scene->mNumMeshes);
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+        PutMesh(buf, scene->mMeshes[m]);
+    PutNode(buf, scene->mRootNode);
+    // written under a temporary name, so an interrupted write or a parallel run never leaves a partial entry
+    error_code ec;
+    create_directories(mFile.parent_path(), ec);
+    path tmpFile = mFile;
+    tmpFile += ".tmp";
+    if (!buf.WriteToFile(tmpFile))
+        return false;
+    rename(tmpFile, mFile, ec);
+    if (ec) {
+        remove(tmpFile, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+#include <assimp/scene.h>
+#include <assimp/DefaultIOSystem.h>
+
+namespace Assimp {
+class Importer;
+}
+
+// Assimp IO handler which records the files opened while reading a scene, other than the input itself (.mtl, external .bin
+// buffers...). Set with Importer::SetIOHandler(), which takes ownership of it.
+class SideFileRecorder : public Assimp::DefaultIOSystem {
+    std::filesystem::path mInput;
+    std::vector<std::filesystem::path> mSideFiles;
+public:
+    SideFileRecorder(std::filesystem::path const &input);
+    using Assimp::DefaultIOSystem::Open;
+    Assimp::IOStream *Open(const char *pFile, const char *pMode = "rb") override;
+    std::vector<std::filesystem::path> const &SideFiles() const { return mSideFiles; }
+};
+
+// Cache of post-processed Assimp scenes (-sceneCache <folder>). The scene is stored after import under a key made of the input
+// contents hash, the post-processing flags, the importer properties set by oimport and the Assimp version, so a repeated
+// import with the same settings (e.g. for another target) reads the stored scene instead of parsing and processing the file.
+// The side files read with the input (see SideFileRecorder) are stored with their hashes and checked on load.
+// Only what oimport reads is stored: nodes, meshes (with bones), materials and embedded textures. The entry is read from a
+// file mapping and its arrays are copied into the scene, which owns them and is changed by oimport (e.g. -lods).
+class SceneCache {
+    std::filesystem::path mFile;
+    std::string mSettings;
+    unsigned long long mInputHash = 0;
+public:
+    // false when the input can't be read
+    bool Init(std::filesystem::path const &cacheDir, std::filesystem::path const &input, unsigned int postProcessFlags, Assimp::Importer const &importer);
+    // null when there's no valid cache entry; 'sideFiles' gets the side files of the stored scene
+    std::unique_ptr<aiScene> Load(std::vector<std::filesystem::path> &sideFiles) const;
+    bool Store(aiScene const *scene, std::vector<std::filesystem::path> const &sideFiles) const;
+};
@@ -0,0 +1,489 @@
+#include "simplify.h"
+#include <assimp\scene.h>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <type_traits>
+
+using namespace std;
+
+namespace {
+
+const unsigned int NONE = 0xFFFFFFFF;
+const double ATTRIBUTE_WEIGHT = 0.01; // attribute difference of 1 costs as much as 10% of the mesh size
+const double BORDER_WEIGHT = 10.0;
+const unsigned int MAX_PASSES = 100;
+
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0, w = 0;
+
+    void AddPlane(aiVector3D const &n, aiVector3D const &p, double weight) {
+        double a = n.x, b = n.y, c = n.z, d = -(a * p.x + b * p.y + c * p.z);
+        a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+        b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+        c2 += weight * c * c; cd += weight * c * d;
+        d2 += weight * d * d;
+        w += weight;
+    }
+
+    void Add(Quadric const &q) {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2; w += q.w;
+    }
+
+    // squared distance to the planes, averaged by their weight
+    double Error(aiVector3D const &p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z) + d2;
+        return w > 0 ? fabs(e) / w : 0;
+    }
+};
+
+struct Collapse {
+    unsigned int from = 0;
+    unsigned int to = 0;
+    double cost = 0;
+};
+
+class Simplifier {
+    aiMesh const *mMesh;
+    vector<aiVector3D> mPos; // normalized to the unit box
+    vector<vector<pair<unsigned int, float>>> mWeights; // vertex > sorted (bone, weight)
+    vector<unsigned int> mWedge; // vertex > first vertex with the same attributes
+    vector<unsigned int> mPosId; // vertex > first vertex at the same position
+    vector<unsigned int> mTris;
+    vector<aiVector3D> mTriNormals; // source normals, so the triangles can't turn over in several steps
+    vector<Quadric> mQuadrics; // by position id
+
+    static void PutFloat(string &key, float value) {
+        value += 0.0f; // -0 > 0
+        key.append((char const *)&value, 4);
+    }
+
+    static unsigned long long EdgeKey(unsigned int a, unsigned int b) {
+        return a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+    }
+
+    double AttributeError(unsigned int a, unsigned int b) const {
+        double e = 0;
+        if (mMesh->mNormals)
+            e += (mMesh->mNormals[a] - mMesh->mNormals[b]).SquareLength() * 0.25;
+        for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+            if (mMesh->mTextureCoords[t])
+                e += (mMesh->mTextureCoords[t][a] - mMesh->mTextureCoords[t][b]).SquareLength();
+        }
+        for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++) {
+            if (mMesh->mColors[c]) {
+                aiColor4D d = mMesh->mColors[c][a] - mMesh->mColors[c][b];
+                e += (d.r * d.r + d.g * d.g + d.b * d.b + d.a * d.a) * 0.25;
+            }
+        }
+        if (!mWeights.empty()) {
+            auto const &wa = mWeights[a];
+            auto const &wb = mWeights[b];
+            size_t i = 0, j = 0;
+            while (i < wa.size() || j < wb.size()) {
+                double d;
+                if (j == wb.size() || (i < wa.size() && wa[i].first < wb[j].first))
+                    d = wa[i++].second;
+                else if (i == wa.size() || wb[j].first < wa[i].first)
+                    d = wb[j++].second;
+                else
+                    d = wa[i++].second - wb[j++].second;
+                e += d * d;
+            }
+        }
+        return e;
+    }
+
+    aiVector3D TriNormal(aiVector3D const &a, aiVector3D const &b, aiVector3D const &c) const {
+        return (b - a) ^ (c - a);
+    }
+
+public:
+    Simplifier(aiMesh const *mesh) : mMesh(mesh) {}
+
+    bool Init() {
+        unsigned int numVertices = mMesh->mNumVertices;
+        for (unsigned int f = 0; f < mMesh->mNumFaces; f++) {
+            if (mMesh->mFaces[f].mNumIndices != 3)
+                return false;
+            for (unsigned int i = 0; i < 3; i++) {
+                if (mMesh->mFaces[f].mIndices[i] >= numVertices)
+                    return false;
+            }
+        }
+        aiVector3D boundMin = mMesh->mVertices[0];
+        aiVector3D boundMax = mMesh->mVertices[0];
+        for (unsigned int v = 1; v < numVertices; v++) {
+            auto const &p = mMesh->mVertices[v];
+            boundMin = aiVector3D(min(boundMin.x, p.x), min(boundMin.y, p.y), min(boundMin.z, p.z));
+            boundMax = aiVector3D(max(boundMax.x, p.x), max(boundMax.y, p.y), max(boundMax.z, p.z));
+        }
+        aiVector3D size = boundMax - boundMin;
+        float extent = max(size.x, max(size.y, size.z));
+        float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+        mPos.resize(numVertices);
+        for (unsigned int v = 0; v < numVertices; v++)
+            mPos[v] = (mMesh->mVertices[v] - boundMin) * scale;
+        if (mMesh->HasBones()) {
+            mWeights.resize(numVertices);
+            for (unsigned int b = 0; b < mMesh->mNumBones; b++) {
+                aiBone const *bone = mMesh->mBones[b];
+                for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+                    if (bone->mWeights[w].mVertexId < numVertices && bone->mWeights[w].mWeight > 0.0f)
+                        mWeights[bone->mWeights[w].mVertexId].emplace_back(b, bone->mWeights[w].mWeight);
+                }
+            }
+        }
+        // vertices with equal attributes are treated as one, so unwelded input doesn't look like seams
+        unordered_map<string, unsigned int> wedges;
+        unordered_map<string, unsigned int> positions;
+        mWedge.resize(numVertices);
+        mPosId.resize(numVertices);
+        for (unsigned int v = 0; v < numVertices; v++) {
+            string key;
+            PutFloat(key, mMesh->mVertices[v].x);
+            PutFloat(key, mMesh->mVertices[v].y);
+            PutFloat(key, mMesh->mVertices[v].z);
+            mPosId[v] = positions.try_emplace(key, v).first->second;
+            if (mMesh->mNormals) {
+                for (unsigned int i = 0; i < 3; i++)
+                    PutFloat(key, mMesh->mNormals[v][i]);
+            }
+            for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+                if (mMesh->mTextureCoords[t]) {
+                    for (unsigned int i = 0; i < mMesh->mNumUVComponents[t] && i < 3; i++)
+                        PutFloat(key, mMesh->mTextureCoords[t][v][i]);
+                }
+            }
+            for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++) {
+                if (mMesh->mColors[c]) {
+                    for (unsigned int i = 0; i < 4; i++)
+                        PutFloat(key, mMesh->mColors[c][v][i]);
+                }
+            }
+            if (mMesh->mTangents) {
+                for (unsigned int i = 0; i < 3; i++) {
+                    PutFloat(key, mMesh->mTangents[v][i]);
+                    PutFloat(key, mMesh->mBitangents[v][i]);
+                }
+            }
+            if (!mWeights.empty()) {
+                sort(mWeights[v].begin(), mWeights[v].end());
+                for (auto const &[bone, weight] : mWeights[v]) {
+                    key.append((char const *)&bone, 4);
+                    PutFloat(key, weight);
+                }
+            }
+            mWedge[v] = wedges.try_emplace(key, v).first->second;
+        }
+        mTris.reserve(mMesh->mNumFaces * 3);
+        for (unsigned int f = 0; f < mMesh->mNumFaces; f++) {
+            unsigned int a = mWedge[mMesh->mFaces[f].mIndices[0]];
+            unsigned int b = mWedge[mMesh->mFaces[f].mIndices[1]];
+            unsigned int c = mWedge[mMesh->mFaces[f].mIndices[2]];
+            if (mPosId[a] != mPosId[b] && mPosId[a] != mPosId[c] && mPosId[b] != mPosId[c]) {
+                mTris.push_back(a);
+                mTris.push_back(b);
+                mTris.push_back(c);
+                mTriNormals.push_back(TriNormal(mPos[a], mPos[b], mPos[c]));
+            }
+        }
+        // plane quadrics weighted by the triangle area, open borders get a perpendicular plane
+        mQuadrics.resize(numVertices);
+        unordered_map<unsigned long long, unsigned int> edgeCount;
+        for (size_t t = 0; t < mTris.size(); t += 3) {
+            for (unsigned int e = 0; e < 3; e++)
+                edgeCount[EdgeKey(mPosId[mTris[t + e]], mPosId[mTris[t + (e + 1) % 3]])]++;
+        }
+        for (size_t t = 0; t < mTris.size(); t += 3) {
+            aiVector3D const &p0 = mPos[mTris[t]];
+            aiVector3D n = TriNormal(p0, mPos[mTris[t + 1]], mPos[mTris[t + 2]]);
+            float area = n.Length();
+            if (area <= 0.0f)
+                continue;
+            n /= area;
+            for (unsigned int i = 0; i < 3; i++)
+                mQuadrics[mPosId[mTris[t + i]]].AddPlane(n, p0, area * 0.5);
+            for (unsigned int e = 0; e < 3; e++) {
+                unsigned int a = mPosId[mTris[t + e]];
+                unsigned int b = mPosId[mTris[t + (e + 1) % 3]];
+                if (edgeCount[EdgeKey(a, b)] == 1) {
+                    aiVector3D edge = mPos[b] - mPos[a];
+                    aiVector3D borderNormal = edge ^ n;
+                    float len = borderNormal.Length();
+                    if (len > 0.0f) {
+                        borderNormal /= len;
+                        double weight = edge.SquareLength() * BORDER_WEIGHT;
+                        mQuadrics[a].AddPlane(borderNormal, mPos[a], weight);
+                        mQuadrics[b].AddPlane(borderNormal, mPos[a], weight);
+                    }
+                }
+            }
+        }
+        return !mTris.empty();
+    }
+
+    // returns the number of collapsed vertices
+    unsigned int Pass(unsigned int targetTriangles) {
+        unsigned int numVertices = mMesh->mNumVertices;
+        unsigned int numTris = unsigned int(mTris.size() / 3);
+        // seams, borders and non-manifold edges
+        vector<unsigned int> posWedge(numVertices, NONE);
+        vector<bool> locked(numVertices, false);
+        vector<bool> border(numVertices, false);
+        unordered_map<unsigned long long, unsigned int> edgeCount;
+        for (unsigned int t = 0; t < numTris; t++) {
+            for (unsigned int e = 0; e < 3; e++) {
+                unsigned int w = mTris[t * 3 + e];
+                unsigned int p = mPosId[w];
+                if (posWedge[p] == NONE)
+                    posWedge[p] = w;
+                else if (posWedge[p] != w)
+                    locked[p] = true;
+                edgeCount[EdgeKey(p, mPosId[mTris[t * 3 + (e + 1) % 3]])]++;
+            }
+        }
+        vector<unsigned int> borderNeighbours(numVertices * 2, NONE);
+        for (auto const &[key, count] : edgeCount) {
+            unsigned int a = unsigned int(key >> 32);
+            unsigned int b = unsigned int(key & 0xFFFFFFFF);
+            if (count == 1) {
+                for (auto [v, other] : { pair(a, b), pair(b, a) }) {
+                    if (!border[v])
+                        borderNeighbours[v * 2] = other;
+                    else if (borderNeighbours[v * 2 + 1] == NONE)
+                        borderNeighbours[v * 2 + 1] = other;
+                    else
+                        locked[v] = true; // several borders meet here
+                    border[v] = true;
+                }
+            }
+            else if (count > 2) {
+                locked[a] = true;
+                locked[b] = true;
+            }
+        }
+        // border vertices only go away on straight parts of the border, the corners stay
+        for (unsigned int v = 0; v < numVertices; v++) {
+            if (border[v] && !locked[v]) {
+                unsigned int prev = borderNeighbours[v * 2];
+                unsigned int next = borderNeighbours[v * 2 + 1];
+                if (next == NONE)
+                    locked[v] = true;
+                else {
+                    aiVector3D d1 = (mPos[v] - mPos[prev]).Normalize();
+                    aiVector3D d2 = (mPos[next] - mPos[v]).Normalize();
+                    if (fabs(d1 * d2) < 0.95f)
+                        locked[v] = true;
+                }
+            }
+        }
+        // position > triangles
+        vector<unsigned int> adjStart(numVertices + 1, 0);
+        for (auto w : mTris)
+            adjStart[mPosId[w] + 1]++;
+        for (unsigned int v = 0; v < numVertices; v++)
+            adjStart[v + 1] += adjStart[v];
+        vector<unsigned int> adj(mTris.size());
+        vector<unsigned int> adjFill(adjStart.begin(), adjStart.end() - 1);
+        for (unsigned int i = 0; i < mTris.size(); i++)
+            adj[adjFill[mPosId[mTris[i]]]++] = i / 3;
+        // cheapest collapse for every vertex
+        vector<Collapse> collapses;
+        vector<unsigned int> best(numVertices, NONE);
+        for (unsigned int t = 0; t < numTris; t++) {
+            for (unsigned int e = 0; e < 3; e++) {
+                for (unsigned int dir = 0; dir < 2; dir++) {
+                    unsigned int wFrom = mTris[t * 3 + (dir ? (e + 1) % 3 : e)];
+                    unsigned int wTo = mTris[t * 3 + (dir ? e : (e + 1) % 3)];
+                    unsigned int from = mPosId[wFrom];
+                    unsigned int to = mPosId[wTo];
+                    if (locked[from] || (border[from] && edgeCount[EdgeKey(from, to)] != 1))
+                        continue;
+                    Quadric q = mQuadrics[from];
+                    q.Add(mQuadrics[to]);
+                    double cost = q.Error(mPos[to]) + ATTRIBUTE_WEIGHT * AttributeError(wFrom, wTo);
+                    if (best[from] == NONE) {
+                        best[from] = unsigned int(collapses.size());
+                        collapses.push_back({ from, to, cost });
+                    }
+                    else if (cost < collapses[best[from]].cost)
+                        collapses[best[from]] = { from, to, cost };
+                }
+            }
+        }
+        sort(collapses.begin(), collapses.end(), [](Collapse const &a, Collapse const &b) {
+            return a.cost < b.cost;
+        });
+        vector<bool> touched(numVertices, false);
+        vector<bool> removedTris(numTris, false);
+        unsigned int numRemoved = 0;
+        unsigned int numCollapsed = 0;
+        for (auto const &c : collapses) {
+            if (numTris - numRemoved <= targetTriangles)
+                break;
+            if (touched[c.from] || touched[c.to])
+                continue;
+            // the wedge of 'to' which replaces the wedge of 'from', and the flip check for the remaining triangles
+            unsigned int toWedge = NONE;
+            bool flips = false;
+            for (unsigned int i = adjStart[c.from]; i < adjStart[c.from + 1]; i++) {
+                unsigned int const *tri = &mTris[adj[i] * 3];
+                unsigned int corner = NONE;
+                bool hasTo = false;
+                for (unsigned int k = 0; k < 3; k++) {
+                    if (mPosId[tri[k]] == c.to) {
+                        hasTo = true;
+                        toWedge = tri[k];
+                    }
+                    else if (mPosId[tri[k]] == c.from)
+                        corner = k;
+                }
+                if (hasTo)
+                    continue;
+                aiVector3D p[3] = { mPos[tri[0]], mPos[tri[1]], mPos[tri[2]] };
+                aiVector3D before = TriNormal(p[0], p[1], p[2]);
+                p[corner] = mPos[c.to];
+                aiVector3D after = TriNormal(p[0], p[1], p[2]);
+                if (before * after <= 0.25f * before.Length() * after.Length() || mTriNormals[adj[i]] * after <= 0.0f) {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips || toWedge == NONE)
+                continue;
+            for (unsigned int i = adjStart[c.from]; i < adjStart[c.from + 1]; i++) {
+                unsigned int t = adj[i];
+                unsigned int *tri = &mTris[t * 3];
+                bool hasTo = false;
+                for (unsigned int k = 0; k < 3; k++) {
+                    touched[mPosId[tri[k]]] = true;
+                    if (mPosId[tri[k]] == c.to)
+                        hasTo = true;
+                }
+                if (hasTo) {
+                    removedTris[t] = true;
+                    numRemoved++;
+                }
+                else {
+                    for (unsigned int k = 0; k < 3; k++) {
+                        if (mPosId[tri[k]] == c.from)
+                            tri[k] = toWedge;
+                    }
+                }
+            }
+            mQuadrics[c.to].Add(mQuadrics[c.from]);
+            numCollapsed++;
+        }
+        if (numRemoved) {
+            unsigned int dst = 0;
+            for (unsigned int t = 0; t < numTris; t++) {
+                if (!removedTris[t]) {
+                    for (unsigned int k = 0; k < 3; k++)
+                        mTris[dst * 3 + k] = mTris[t * 3 + k];
+                    mTriNormals[dst] = mTriNormals[t];
+                    dst++;
+                }
+            }
+            mTris.resize(dst * 3);
+            mTriNormals.resize(dst);
+        }
+        return numCollapsed;
+    }
+
+    unsigned int NumTriangles() const {
+        return unsigned int(mTris.size() / 3);
+    }
+
+    aiMesh *CreateMesh() const {
+        unsigned int numVertices = mMesh->mNumVertices;
+        vector<unsigned int> remap(numVertices, NONE);
+        for (auto w : mTris)
+            remap[w] = 0;
+        unsigned int newNumVertices = 0;
+        for (unsigned int v = 0; v < numVertices; v++) {
+            if (remap[v] != NONE)
+                remap[v] = newNumVertices++;
+        }
+        aiMesh *mesh = new aiMesh();
+        mesh->mName = mMesh->mName;
+        mesh->mMaterialIndex = mMesh->mMaterialIndex;
+        mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        mesh->mNumVertices = newNumVertices;
+        auto copyStream = [&](auto const *src, auto *&dst) {
+            if (src) {
+                dst = new std::remove_const_t<std::remove_reference_t<decltype(*src)>>[newNumVertices];
+                for (unsigned int v = 0; v < numVertices; v++) {
+                    if (remap[v] != NONE)
+                        dst[remap[v]] = src[v];
+                }
+            }
+        };
+        copyStream(mMesh->mVertices, mesh->mVertices);
+        copyStream(mMesh->mNormals, mesh->mNormals);
+        copyStream(mMesh->mTangents, mesh->mTangents);
+        copyStream(mMesh->mBitangents, mesh->mBitangents);
+        for (unsigned int c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++)
+            copyStream(mMesh->mColors[c], mesh->mColors[c]);
+        for (unsigned int t = 0; t < AI_MAX_NUMBER_OF_TEXTURECOORDS; t++) {
+            copyStream(mMesh->mTextureCoords[t], mesh->mTextureCoords[t]);
+            mesh->mNumUVComponents[t] = mMesh->mNumUVComponents[t];
+        }
+        mesh->mNumFaces = NumTriangles();
+        mesh->mFaces = new aiFace[mesh->mNumFaces];
+        for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+            mesh->mFaces[f].mNumIndices = 3;
+            mesh->mFaces[f].mIndices = new unsigned int[3];
+            for (unsigned int k = 0; k < 3; k++)
+                mesh->mFaces[f].mIndices[k] = remap[mTris[f * 3 + k]];
+        }
+        // all bones are kept, even the ones which lost their weights, so the LOD uses the same skeleton
+        if (mMesh->mNumBones) {
+            mesh->mNumBones = mMesh->mNumBones;
+            mesh->mBones = new aiBone *[mesh->mNumBones];
+            for (unsigned int b = 0; b < mMesh->mNumBones; b++) {
+                aiBone const *srcBone = mMesh->mBones[b];
+                aiBone *bone = new aiBone();
+                bone->mName = srcBone->mName;
+                bone->mOffsetMatrix = srcBone->mOffsetMatrix;
+                bone->mNode = srcBone->mNode;
+                bone->mArmature = srcBone->mArmature;
+                vector<aiVertexWeight> weights;
+                for (unsigned int w = 0; w < srcBone->mNumWeights; w++) {
+                    unsigned int id = srcBone->mWeights[w].mVertexId;
+                    if (id < numVertices && remap[id] != NONE)
+                        weights.emplace_back(remap[id], srcBone->mWeights[w].mWeight);
+                }
+                bone->mNumWeights = unsigned int(weights.size());
+                if (!weights.empty()) {
+                    bone->mWeights = new aiVertexWeight[weights.size()];
+                    copy(weights.begin(), weights.end(), bone->mWeights);
+                }
+                mesh->mBones[b] = bone;
+            }
+        }
+        return mesh;
+    }
+};
+
+}
+
+aiMesh *SimplifyMesh(aiMesh const *mesh, float ratio) {
+    if (!mesh || !mesh->mNumVertices || !mesh->mNumFaces || mesh->mNumAnimMeshes || ratio <= 0.0f || ratio >= 1.0f)
+        return nullptr;
+    Simplifier simplifier(mesh);
+    if (!simplifier.Init())
+        return nullptr;
+    unsigned int targetTriangles = max(unsigned int(simplifier.NumTriangles() * ratio), 1u);
+    for (unsigned int pass = 0; pass < MAX_PASSES && simplifier.NumTriangles() > targetTriangles; pass++) {
+        if (!simplifier.Pass(targetTriangles))
+            break;
+    }
+    if (simplifier.NumTriangles() >= mesh->mNumFaces)
+        return nullptr;
+    return simplifier.CreateMesh();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+struct aiMesh;
+
+// Mesh simplification for automatically generated LODs (-lods).
+
+// Returns a new triangle mesh with about 'ratio' of the source triangles, made with quadric error edge collapses. Vertices are
+// only removed, never moved or blended, so the remaining ones keep their normals, uvs, colours and bone weights; the collapse
+// cost includes the attribute and bone weight difference of the two vertices. Vertices on attribute seams and non-manifold edges
+// are locked, vertices on open borders only slide along the border. Returns null when the mesh can't be reduced.
+aiMesh *SimplifyMesh(aiMesh const *mesh, float ratio);
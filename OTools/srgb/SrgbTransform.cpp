@@ -233,4 +233,52 @@ int linearToSrgb8bit(double x) {
 		return y + 1;
 }
 
+
+
+/*---- Table-driven conversions for colour streams ----*/
+
+namespace {
+
+struct Tables {
+	unsigned char srgb8ToLinear8[1 << 8];
+	float linear12ToSrgb[1 << 12];
+
+	Tables() {
+		// same rounding as the per-component double path
+		for (int i = 0; i < (1 << 8); i++)
+			srgb8ToLinear8[i] = static_cast<unsigned char>(srgbToLinear(double(i) / 255.0) * 255.0);
+		for (int i = 0; i < (1 << 12); i++)
+			linear12ToSrgb[i] = static_cast<float>(linearToSrgb(double(i) / double((1 << 12) - 1)));
+	}
+};
+
+const Tables &GetTables() {
+	static const Tables tables;
+	return tables;
+}
+
+}
+
+
+void srgbToLinear8bitStream(unsigned char *data, unsigned int count, unsigned int stride, unsigned int numComponents) {
+	const unsigned char *table = GetTables().srgb8ToLinear8;
+	for (unsigned int i = 0; i < count; i++) {
+		for (unsigned int c = 0; c < numComponents; c++)
+			data[c] = table[data[c]];
+		data += stride;
+	}
+}
+
+
+void linearToSrgbStream(float *data, unsigned int count, unsigned int stride, unsigned int numComponents) {
+	const float *table = GetTables().linear12ToSrgb;
+	for (unsigned int i = 0; i < count; i++) {
+		for (unsigned int c = 0; c < numComponents; c++) {
+			float x = data[c];
+			data[c] = x <= 0.0f ? 0.0f : (x >= 1.0f ? 1.0f : table[static_cast<int>(x * float((1 << 12) - 1) + 0.5f)]);
+		}
+		data += stride;
+	}
+}
+
 }
@@ -35,4 +35,10 @@ float linearToSrgb(float x);
 double linearToSrgb(double x);
 int linearToSrgb8bit(double x);
 
+/*---- Table-driven conversions for colour streams ----*/
+
+// 'stride' is in bytes for 8-bit streams and in floats for float streams
+void srgbToLinear8bitStream(unsigned char *data, unsigned int count, unsigned int stride, unsigned int numComponents);
+void linearToSrgbStream(float *data, unsigned int count, unsigned int stride, unsigned int numComponents);
+
 }
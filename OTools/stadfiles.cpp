@@ -0,0 +1,255 @@
+#include "stadfiles.h"
+#include "memory.h"
+#include "message.h"
+#include <charconv>
+#include <cstring>
+
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+
+const unsigned int MAX_REPORTED_PROBLEMS = 16;
+
+bool ReadWholeFile(path const &filePath, vector<char> &data) {
+    FILE *f = _wfopen(filePath.c_str(), L"rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long fileSize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool result = fileSize >= 0;
+    if (result) {
+        data.resize(fileSize);
+        result = fileSize == 0 || fread(data.data(), 1, fileSize, f) == size_t(fileSize);
+    }
+    fclose(f);
+    return result;
+}
+
+void ReportProblems(path const &filePath, vector<string> const &problems) {
+    if (problems.empty())
+        return;
+    string msg = filePath.filename().string() + ": " + to_string(problems.size()) + " malformed record(s)";
+    for (unsigned int i = 0; i < problems.size() && i < MAX_REPORTED_PROBLEMS; i++)
+        msg += "\n  " + problems[i];
+    if (problems.size() > MAX_REPORTED_PROBLEMS)
+        msg += "\n  ...";
+    ErrorMessage(msg);
+}
+
+// line-by-line reader over a text file in memory; values are parsed from the current line
+class TextReader {
+    char const *mBegin = nullptr;
+    char const *mEnd = nullptr;
+    char const *mNextLine = nullptr;
+    char const *mLineStart = nullptr;
+    char const *mLineEnd = nullptr;
+    char const *mPos = nullptr;
+    unsigned int mLineNumber = 0;
+
+    void SkipSpaces() {
+        while (mPos < mLineEnd && (*mPos == ' ' || *mPos == '\t'))
+            mPos++;
+    }
+
+    template<typename T>
+    bool Number(T &value) {
+        SkipSpaces();
+        if (mPos < mLineEnd && *mPos == '+')
+            mPos++;
+        auto result = from_chars(mPos, mLineEnd, value);
+        if (result.ec != errc())
+            return false;
+        mPos = result.ptr;
+        return true;
+    }
+public:
+    TextReader(vector<char> const &data) {
+        mBegin = data.data();
+        mEnd = mBegin + data.size();
+        mNextLine = mBegin;
+    }
+
+    bool NextLine() {
+        if (mNextLine == mEnd)
+            return false;
+        mLineStart = mNextLine;
+        char const *lineBreak = (char const *)memchr(mLineStart, '\n', mEnd - mLineStart);
+        mLineEnd = lineBreak ? lineBreak : mEnd;
+        mNextLine = lineBreak ? lineBreak + 1 : mEnd;
+        if (mLineEnd > mLineStart && mLineEnd[-1] == '\r')
+            mLineEnd--;
+        mPos = mLineStart;
+        mLineNumber++;
+        return true;
+    }
+
+    bool IsBlank() {
+        SkipSpaces();
+        return mPos == mLineEnd;
+    }
+
+    bool Contains(char const *str) const {
+        return string_view(mLineStart, mLineEnd - mLineStart).find(str) != string_view::npos;
+    }
+
+    bool Float(float &value) {
+        return Number(value);
+    }
+
+    bool Int(int &value) {
+        return Number(value);
+    }
+
+    bool Word(string &value) {
+        SkipSpaces();
+        char const *start = mPos;
+        while (mPos < mLineEnd && *mPos != ' ' && *mPos != '\t')
+            mPos++;
+        value.assign(start, mPos);
+        return !value.empty();
+    }
+
+    string Where() const {
+        return "line " + to_string(mLineNumber) + " (offset " + to_string(mLineStart - mBegin) + ")";
+    }
+};
+
+}
+
+bool ReadStadiumFlags(path const &filePath, vector<StadiumFlag> &flags) {
+    vector<char> data;
+    if (!ReadWholeFile(filePath, data))
+        return false;
+    vector<string> problems;
+    TextReader reader(data);
+    while (reader.NextLine()) {
+        if (reader.IsBlank())
+            continue;
+        // "x y z" or "x y z type dirX dirY dirZ"
+        StadiumFlag flag;
+        unsigned int numParams = 0;
+        while (numParams < 3 && reader.Float(flag.pos[numParams]))
+            numParams++;
+        if (numParams == 3 && reader.Int(flag.type)) {
+            numParams++;
+            while (numParams < 7 && reader.Float(flag.dir[numParams - 4]))
+                numParams++;
+        }
+        if (numParams == 3) {
+            flag.type = 0;
+            flag.dir[0] = flag.dir[1] = flag.dir[2] = 1.0f;
+        }
+        else if (numParams != 7) {
+            problems.push_back(reader.Where() + ": expected 3 or 7 values, got " + to_string(numParams));
+            continue;
+        }
+        flags.push_back(flag);
+    }
+    ReportProblems(filePath, problems);
+    return true;
+}
+
+bool ReadStadiumEffects(path const &filePath, vector<StadiumEffectGroup> &groups) {
+    vector<char> data;
+    if (!ReadWholeFile(filePath, data))
+        return false;
+    vector<string> problems;
+    TextReader reader(data);
+    bool eof = false;
+    unsigned int block = 0;
+    while (!eof && reader.NextLine()) {
+        int numEffectTypes = 0;
+        if (!reader.Int(numEffectTypes) || numEffectTypes <= 0)
+            continue;
+        block++;
+        for (int i = 0; i < numEffectTypes; i++) {
+            if (!reader.NextLine()) {
+                eof = true;
+                break;
+            }
+            // "Type numEffects [Position] [Direction]"
+            StadiumEffectGroup group;
+            group.block = block;
+            int numEffects = 0;
+            if (!reader.Word(group.type) || !reader.Int(numEffects)) {
+                problems.push_back(reader.Where() + ": malformed effect group header");
+                continue;
+            }
+            group.hasPosition = reader.Contains("Position");
+            group.hasDirection = reader.Contains("Direction");
+            for (int e = 0; e < numEffects; e++) {
+                if (!reader.NextLine()) {
+                    eof = true;
+                    break;
+                }
+                if (group.hasPosition) {
+                    float values[6];
+                    unsigned int numValues = group.hasDirection ? 6 : 3;
+                    unsigned int numRead = 0;
+                    while (numRead < numValues && reader.Float(values[numRead]))
+                        numRead++;
+                    if (numRead != numValues) {
+                        problems.push_back(reader.Where() + ": expected " + to_string(numValues) + " values for " + group.type
+                            + ", got " + to_string(numRead));
+                        break;
+                    }
+                    group.positions.insert(group.positions.end(), values, values + 3);
+                    if (group.hasDirection)
+                        group.directions.insert(group.directions.end(), values + 3, values + 6);
+                }
+            }
+            groups.push_back(group);
+            if (eof)
+                break;
+        }
+    }
+    ReportProblems(filePath, problems);
+    return true;
+}
+
+bool ReadStadiumCollision(path const &filePath, vector<StadiumCollisionGeometry> &geometries) {
+    vector<char> data;
+    if (!ReadWholeFile(filePath, data))
+        return false;
+    size_t offset = 0;
+    auto Read = [&](void *dst, size_t size) {
+        if (data.size() - offset < size)
+            return false;
+        Memory_Copy(dst, &data[offset], size);
+        offset += size;
+        return true;
+    };
+    unsigned int header[3] = { 0, 0, 0 };
+    if (!Read(header, 12) || header[0] != 2)
+        return false;
+    // each geometry takes at least 32 bytes (bounding box and counts)
+    if (header[2] > (data.size() - offset) / 32) {
+        ReportProblems(filePath, { "offset 8: geometry count " + to_string(header[2]) + " doesn't fit the file size" });
+        return false;
+    }
+    geometries.resize(header[2]);
+    for (unsigned int g = 0; g < header[2]; g++) {
+        auto &geom = geometries[g];
+        size_t geomOffset = offset;
+        unsigned short counts[4] = { 0, 0, 0, 0 };
+        bool isValid = Read(geom.bound, 24) && Read(counts, 8);
+        if (isValid) {
+            geom.positions.resize(counts[0] * 3);
+            geom.normals.resize(counts[1] * 3);
+            geom.triangles.resize(counts[2] * 4);
+            geom.edges.resize(counts[3] * 2);
+            isValid = Read(geom.positions.data(), geom.positions.size() * sizeof(float))
+                && Read(geom.normals.data(), geom.normals.size() * sizeof(float))
+                && Read(geom.triangles.data(), geom.triangles.size() * sizeof(unsigned short))
+                && Read(geom.edges.data(), geom.edges.size() * sizeof(unsigned short));
+        }
+        if (!isValid) {
+            ReportProblems(filePath, { "offset " + to_string(geomOffset) + ": geometry " + to_string(g + 1) + " is truncated" });
+            geometries.clear();
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Readers for stadium side files (flags/effects .loc and collision .bin). Each file is loaded with a single
+// read and parsed from memory. Malformed records are skipped and reported with their line or byte offset.
+
+struct StadiumFlag {
+    float pos[3] = { 0.0f, 0.0f, 0.0f };
+    int type = 0;
+    float dir[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+struct StadiumEffectGroup {
+    std::string type;
+    unsigned int block = 0; // index of the "numEffectTypes" block in the file
+    bool hasPosition = false;
+    bool hasDirection = false;
+    std::vector<float> positions; // xyz per effect
+    std::vector<float> directions; // xyz per effect, empty when hasDirection is false
+};
+
+struct StadiumCollisionGeometry {
+    float bound[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    std::vector<float> positions; // xyz per vertex
+    std::vector<float> normals; // xyz per normal
+    std::vector<unsigned short> triangles; // normal index + 3 vertex indices per triangle
+    std::vector<unsigned short> edges; // 2 vertex indices per edge
+};
+
+// all readers return false when the file can't be read (or has an unknown format, for collision)
+bool ReadStadiumFlags(std::filesystem::path const &filePath, std::vector<StadiumFlag> &flags);
+bool ReadStadiumEffects(std::filesystem::path const &filePath, std::vector<StadiumEffectGroup> &groups);
+bool ReadStadiumCollision(std::filesystem::path const &filePath, std::vector<StadiumCollisionGeometry> &geometries);
@@ -5,7 +5,17 @@
 #include <assimp\postprocess.h>
 #include <assimp\pbrmaterial.h>
 #include "delaunator-cpp/include/delaunator.hpp"
+#include "binbuf.h"
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <functional>
+
+// zlib (zlibstatic.lib, linked for assimp)
+extern "C" {
+unsigned long compressBound(unsigned long sourceLen);
+int compress2(unsigned char *dest, unsigned long *destLen, unsigned char const *source, unsigned long sourceLen, int level);
+}
 
 void gen_uv_set(path const& out, path const& in) {
     if (out.empty())
@@ -14,6 +24,10 @@ void gen_uv_set(path const& out, path const& in) {
 		UVSkinning::Instance().GenerateSkinSet(in, out);
 }
 
+unsigned char const *UVSkinning::UVSkinTexMap::Pixels() const {
+	return mappedPixels ? mappedPixels : pixels.data();
+}
+
 float UVSkinning::UVSkinTexMap::GetWeight(float u, float v) const {
 	float intpart = 0.0f;
 	if (u < 0.0f || u > 1.0f)
@@ -22,7 +36,181 @@ float UVSkinning::UVSkinTexMap::GetWeight(float u, float v) const {
 		v = modf(v, &intpart);
 	unsigned int x = (unsigned int)roundf((float)(width - 1) * u);
 	unsigned int y = (unsigned int)roundf((float)(height - 1) * v);
-	return (float)pixels[y * width + x] / 255.0f;
+	return (float)Pixels()[y * width + x] / 255.0f;
+}
+
+void UVSkinning::UVSkinAtlas::Build(UVSkinSet const &skinSet) {
+	width = 0;
+	height = 0;
+	boneNames.clear();
+	for (auto const &[texMapName, texMap] : skinSet) {
+		if (texMap.width == 0 || texMap.height == 0)
+			continue;
+		width = max(width, texMap.width);
+		height = max(height, texMap.height);
+		boneNames.push_back(texMapName);
+	}
+	unsigned int numTexels = width * height;
+	texelBones.assign(numTexels * ATLAS_BONES_PER_TEXEL, ATLAS_NO_BONE);
+	texelWeights.assign(numTexels * ATLAS_BONES_PER_TEXEL, 0);
+	unsigned short slot = 0;
+	for (auto const &[texMapName, texMap] : skinSet) {
+		if (texMap.width == 0 || texMap.height == 0)
+			continue;
+		unsigned char const *texMapPixels = texMap.Pixels();
+		bool sameSize = texMap.width == width && texMap.height == height;
+		for (unsigned int y = 0; y < height; y++) {
+			unsigned int srcY = sameSize ? y : (height > 1 ? (unsigned int)roundf(float(y) / float(height - 1) * float(texMap.height - 1)) : 0);
+			for (unsigned int x = 0; x < width; x++) {
+				unsigned int srcX = sameSize ? x : (width > 1 ? (unsigned int)roundf(float(x) / float(width - 1) * float(texMap.width - 1)) : 0);
+				unsigned char weight = texMapPixels[srcY * texMap.width + srcX];
+				if (weight == 0)
+					continue;
+				// keep the strongest bones, sorted by weight
+				unsigned short *bones = &texelBones[(y * width + x) * ATLAS_BONES_PER_TEXEL];
+				unsigned char *weights = &texelWeights[(y * width + x) * ATLAS_BONES_PER_TEXEL];
+				if (weights[ATLAS_BONES_PER_TEXEL - 1] >= weight)
+					continue;
+				unsigned int pos = ATLAS_BONES_PER_TEXEL - 1;
+				while (pos > 0 && weights[pos - 1] < weight) {
+					weights[pos] = weights[pos - 1];
+					bones[pos] = bones[pos - 1];
+					pos--;
+				}
+				weights[pos] = weight;
+				bones[pos] = slot;
+			}
+		}
+		slot++;
+	}
+}
+
+void UVSkinning::UVSkinAtlas::Sample(float u, float v, UVSkinSample &out) const {
+	out.numBones = 0;
+	if (width == 0 || height == 0)
+		return;
+	float intpart = 0.0f;
+	if (u < 0.0f || u > 1.0f)
+		u = modf(u, &intpart);
+	if (v < 0.0f || v > 1.0f)
+		v = modf(v, &intpart);
+	if (u < 0.0f)
+		u += 1.0f;
+	if (v < 0.0f)
+		v += 1.0f;
+	float fx = (float)(width - 1) * u;
+	float fy = (float)(height - 1) * v;
+	unsigned int x0 = min((unsigned int)fx, width - 1);
+	unsigned int y0 = min((unsigned int)fy, height - 1);
+	unsigned int x1 = min(x0 + 1, width - 1);
+	unsigned int y1 = min(y0 + 1, height - 1);
+	float tx = fx - (float)x0;
+	float ty = fy - (float)y0;
+	unsigned int texels[4] = { y0 * width + x0, y0 * width + x1, y1 * width + x0, y1 * width + x1 };
+	float factors[4] = { (1.0f - tx) * (1.0f - ty), tx * (1.0f - ty), (1.0f - tx) * ty, tx * ty };
+	for (unsigned int t = 0; t < 4; t++) {
+		if (factors[t] <= 0.0f)
+			continue;
+		unsigned short const *bones = &texelBones[texels[t] * ATLAS_BONES_PER_TEXEL];
+		unsigned char const *weights = &texelWeights[texels[t] * ATLAS_BONES_PER_TEXEL];
+		for (unsigned int b = 0; b < ATLAS_BONES_PER_TEXEL && bones[b] != ATLAS_NO_BONE; b++) {
+			float weight = (float)weights[b] / 255.0f * factors[t];
+			unsigned int i = 0;
+			while (i < out.numBones && out.bones[i] != bones[b])
+				i++;
+			if (i == out.numBones) {
+				out.bones[i] = bones[b];
+				out.weights[i] = weight;
+				out.numBones++;
+			}
+			else
+				out.weights[i] += weight;
+		}
+	}
+}
+
+static void ParallelFor(unsigned int count, function<void(unsigned int, unsigned int)> const &body) {
+	unsigned int numThreads = min(max(thread::hardware_concurrency(), 1u), max(count, 1u));
+	if (numThreads == 1) {
+		body(0, count);
+		return;
+	}
+	unsigned int chunk = (count + numThreads - 1) / numThreads;
+	vector<thread> threads;
+	vector<exception_ptr> errors(numThreads);
+	for (unsigned int t = 0; t < numThreads; t++) {
+		unsigned int begin = t * chunk;
+		unsigned int end = min(count, begin + chunk);
+		if (begin >= end)
+			break;
+		threads.emplace_back([&, t, begin, end] {
+			try {
+				body(begin, end);
+			}
+			catch (...) {
+				errors[t] = current_exception();
+			}
+		});
+	}
+	for (auto &t : threads)
+		t.join();
+	for (auto const &e : errors) {
+		if (e)
+			rethrow_exception(e);
+	}
+}
+
+static bool WritePngGray8(path const &filePath, unsigned int width, unsigned int height, unsigned char const *pixels) {
+	static unsigned int crcTable[256] = {};
+	static once_flag crcTableInit;
+	call_once(crcTableInit, [] {
+		for (unsigned int n = 0; n < 256; n++) {
+			unsigned int c = n;
+			for (unsigned int k = 0; k < 8; k++)
+				c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+			crcTable[n] = c;
+		}
+	});
+	BinaryBuffer buf(width * height + height * 6 + 128);
+	auto PutBE = [&](unsigned int value) {
+		unsigned char bytes[4] = { (unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value };
+		buf.Put(bytes, 4);
+	};
+	auto PutChunk = [&](char const *type, vector<unsigned char> const &chunkData) {
+		PutBE(chunkData.size());
+		unsigned int crc = 0xFFFFFFFF;
+		for (unsigned int i = 0; i < 4; i++)
+			crc = crcTable[(crc ^ (unsigned char)type[i]) & 0xFF] ^ (crc >> 8);
+		for (auto c : chunkData)
+			crc = crcTable[(crc ^ c) & 0xFF] ^ (crc >> 8);
+		buf.Put(type, 4);
+		if (!chunkData.empty())
+			buf.Put(chunkData.data(), chunkData.size());
+		PutBE(crc ^ 0xFFFFFFFF);
+	};
+	static unsigned char signature[] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+	buf.Put(signature, 8);
+	vector<unsigned char> ihdr = {
+		(unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+		(unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+		8, 0, 0, 0, 0 // 8-bit grayscale
+	};
+	PutChunk("IHDR", ihdr);
+	// zlib stream, each row prefixed with filter type 0
+	vector<unsigned char> raw;
+	raw.reserve((width + 1) * height);
+	for (unsigned int y = 0; y < height; y++) {
+		raw.push_back(0);
+		raw.insert(raw.end(), pixels + y * width, pixels + (y + 1) * width);
+	}
+	unsigned long idatSize = compressBound((unsigned long)raw.size());
+	vector<unsigned char> idat(idatSize);
+	if (compress2(idat.data(), &idatSize, raw.data(), (unsigned long)raw.size(), 9) != 0)
+		return false;
+	idat.resize(idatSize);
+	PutChunk("IDAT", idat);
+	PutChunk("IEND", {});
+	return buf.WriteToFile(filePath);
 }
 
 UVSkinning &UVSkinning::Instance() {
@@ -30,48 +218,196 @@ UVSkinning &UVSkinning::Instance() {
 	return instance;
 }
 
+UVSkinning::~UVSkinning() {
+	for (auto const &m : mappedCacheFiles) {
+		if (m.view)
+			UnmapViewOfFile(m.view);
+		if (m.mapping)
+			CloseHandle(m.mapping);
+		if (m.file != INVALID_HANDLE_VALUE)
+			CloseHandle(m.file);
+	}
+}
+
+static const unsigned int UVSKIN_CACHE_SIGNATURE = 0x43535655; // 'UVSC'
+static const unsigned int UVSKIN_CACHE_VERSION = 1;
+
+// header: signature, version, numFiles
+// per file: nameLength, name, fileSize, fileTime, width, height, pixelsOffset
+// then 8-bit weight planes
+struct UVSkinCacheEntry {
+	unsigned long long fileSize;
+	long long fileTime;
+	unsigned int width;
+	unsigned int height;
+	unsigned long long pixelsOffset;
+};
+
+path UVSkinning::GetSkinSetCachePath(path const &folder) {
+	path folderPath = folder;
+	if (!folderPath.has_filename())
+		folderPath = folderPath.parent_path();
+	return folderPath.parent_path() / (folderPath.filename().wstring() + L".uvskincache");
+}
+
+bool UVSkinning::LoadSkinSetCache(path const &folder, vector<path> const &files, UVSkinSet &skinSet) {
+	path cachePath = GetSkinSetCachePath(folder);
+	error_code ec;
+	if (!exists(cachePath, ec))
+		return false;
+	MappedCacheFile m;
+	m.file = CreateFileW(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m.file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(m.file, &fileSize) && fileSize.QuadPart >= 12) {
+		m.size = fileSize.QuadPart;
+		m.mapping = CreateFileMappingW(m.file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m.mapping)
+			m.view = (unsigned char const *)MapViewOfFile(m.mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+	auto Release = [&] {
+		if (m.view)
+			UnmapViewOfFile(m.view);
+		if (m.mapping)
+			CloseHandle(m.mapping);
+		CloseHandle(m.file);
+		return false;
+	};
+	if (!m.view)
+		return Release();
+	unsigned long long pos = 0;
+	auto Read = [&](void *out, unsigned long long size) {
+		if (pos + size > m.size)
+			return false;
+		Memory_Copy(out, m.view + pos, (unsigned int)size);
+		pos += size;
+		return true;
+	};
+	unsigned int header[3];
+	if (!Read(header, sizeof(header)) || header[0] != UVSKIN_CACHE_SIGNATURE || header[1] != UVSKIN_CACHE_VERSION || header[2] != files.size())
+		return Release();
+	UVSkinSet cachedSet;
+	for (auto const &p : files) {
+		unsigned int nameLength = 0;
+		if (!Read(&nameLength, 4) || pos + nameLength > m.size)
+			return Release();
+		string name((char const *)m.view + pos, nameLength);
+		pos += nameLength;
+		UVSkinCacheEntry entry;
+		if (!Read(&entry, sizeof(UVSkinCacheEntry)))
+			return Release();
+		error_code fec;
+		if (name != p.filename().string() || entry.fileSize != file_size(p, fec) || entry.fileTime != last_write_time(p, fec).time_since_epoch().count())
+			return Release();
+		if (entry.pixelsOffset + (unsigned long long)entry.width * entry.height > m.size)
+			return Release();
+		auto &texMap = cachedSet[p.stem().string()];
+		texMap.width = entry.width;
+		texMap.height = entry.height;
+		texMap.mappedPixels = m.view + entry.pixelsOffset;
+	}
+	skinSet = move(cachedSet);
+	mappedCacheFiles.push_back(m);
+	return true;
+}
+
+void UVSkinning::SaveSkinSetCache(path const &folder, vector<path> const &files, UVSkinSet const &skinSet) {
+	BinaryBuffer buf;
+	buf.Put(UVSKIN_CACHE_SIGNATURE);
+	buf.Put(UVSKIN_CACHE_VERSION);
+	buf.Put((unsigned int)files.size());
+	vector<unsigned int> entryPositions;
+	for (auto const &p : files) {
+		string name = p.filename().string();
+		buf.Put((unsigned int)name.size());
+		buf.Put(name.data(), name.size());
+		auto const &texMap = skinSet.at(p.stem().string());
+		UVSkinCacheEntry entry;
+		error_code ec;
+		entry.fileSize = file_size(p, ec);
+		entry.fileTime = last_write_time(p, ec).time_since_epoch().count();
+		entry.width = texMap.width;
+		entry.height = texMap.height;
+		entry.pixelsOffset = 0;
+		entryPositions.push_back(buf.Position());
+		buf.Put(entry);
+	}
+	for (unsigned int i = 0; i < files.size(); i++) {
+		auto const &texMap = skinSet.at(files[i].stem().string());
+		unsigned long long pixelsOffset = buf.Position();
+		unsigned int endPos = buf.Position();
+		buf.MoveTo(entryPositions[i] + offsetof(UVSkinCacheEntry, pixelsOffset));
+		buf.Put(pixelsOffset);
+		buf.MoveTo(endPos);
+		if (!texMap.pixels.empty())
+			buf.Put(texMap.pixels.data(), texMap.pixels.size());
+	}
+	// the cache is only an optimization, a failed write is not an error
+	buf.WriteToFile(GetSkinSetCachePath(folder));
+}
+
 UVSkinning::UVSkinSet const &UVSkinning::GetSkinSet(path const &folder) {
 	if (!uvSkinSets.contains(folder)) {
 		UVSkinning::UVSkinSet &skinSet = uvSkinSets[folder];
+		vector<path> files;
 		for (auto const &i : directory_iterator(folder)) {
 			path p = i.path();
 			string ext = ToLower(p.extension().string());
-			if (ext == ".png" || ext == ".tga" || ext == ".bmp" || ext == ".dds" || ext == ".jpg") {
-				IDirect3DTexture9 *texture = nullptr;
-				if (FAILED(D3DXCreateTextureFromFileExW(globalVars().device->Interface(), p.c_str(), D3DX_DEFAULT, D3DX_DEFAULT, 1,
-					D3DUSAGE_DYNAMIC, D3DFMT_X8R8G8B8, D3DPOOL_SYSTEMMEM, D3DX_FILTER_TRIANGLE, D3DX_FILTER_BOX, 0, NULL, NULL, &texture)))
-				{
-					throw "UVSkinning::GetSkinSet: failed to read texture";
-				}
-				D3DSURFACE_DESC desc;
-				if (FAILED(texture->GetLevelDesc(0, &desc))) {
-					texture->Release();
-					throw "UVSkinning::GetSkinSet: failed to retrieve texture data";
-				}
-				auto &texMap = skinSet[p.stem().string()];
-				texMap.width = desc.Width;
-				texMap.height = desc.Height;
-				texMap.pixels.resize(texMap.width * texMap.height);
-				D3DLOCKED_RECT rect;
-				if (FAILED(texture->LockRect(0, &rect, NULL, D3DLOCK_READONLY))) {
-					texture->Release();
-					throw "UVSkinning::GetSkinSet: failed to lock texture";
-				}
-				struct clr_x8r8g8b8 { unsigned char b, g, r, x; };
-				clr_x8r8g8b8 *xrgb = (clr_x8r8g8b8 *)rect.pBits;
-				for (unsigned int ip = 0; ip < texMap.pixels.size(); ip++)
-					texMap.pixels[ip] = xrgb[ip].r;
-				if (FAILED(texture->UnlockRect(0))) {
-					texture->Release();
-					throw "UVSkinning::GetSkinSet: failed to unlock texture";
-				}
+			if (ext == ".png" || ext == ".tga" || ext == ".bmp" || ext == ".dds" || ext == ".jpg")
+				files.push_back(p);
+		}
+		sort(files.begin(), files.end());
+		uvSkinSetFiles[folder] = files;
+		if (LoadSkinSetCache(folder, files, skinSet))
+			return skinSet;
+		for (auto const &p : files) {
+			IDirect3DTexture9 *texture = nullptr;
+			if (FAILED(D3DXCreateTextureFromFileExW(globalVars().device->Interface(), p.c_str(), D3DX_DEFAULT, D3DX_DEFAULT, 1,
+				D3DUSAGE_DYNAMIC, D3DFMT_X8R8G8B8, D3DPOOL_SYSTEMMEM, D3DX_FILTER_TRIANGLE, D3DX_FILTER_BOX, 0, NULL, NULL, &texture)))
+			{
+				throw "UVSkinning::GetSkinSet: failed to read texture";
+			}
+			D3DSURFACE_DESC desc;
+			if (FAILED(texture->GetLevelDesc(0, &desc))) {
+				texture->Release();
+				throw "UVSkinning::GetSkinSet: failed to retrieve texture data";
+			}
+			auto &texMap = skinSet[p.stem().string()];
+			texMap.width = desc.Width;
+			texMap.height = desc.Height;
+			texMap.pixels.resize(texMap.width * texMap.height);
+			D3DLOCKED_RECT rect;
+			if (FAILED(texture->LockRect(0, &rect, NULL, D3DLOCK_READONLY))) {
 				texture->Release();
+				throw "UVSkinning::GetSkinSet: failed to lock texture";
 			}
+			struct clr_x8r8g8b8 { unsigned char b, g, r, x; };
+			clr_x8r8g8b8 *xrgb = (clr_x8r8g8b8 *)rect.pBits;
+			for (unsigned int ip = 0; ip < texMap.pixels.size(); ip++)
+				texMap.pixels[ip] = xrgb[ip].r;
+			if (FAILED(texture->UnlockRect(0))) {
+				texture->Release();
+				throw "UVSkinning::GetSkinSet: failed to unlock texture";
+			}
+			texture->Release();
 		}
+		SaveSkinSetCache(folder, files, skinSet);
 	}
 	return uvSkinSets[folder];
 }
 
+UVSkinning::UVSkinAtlas const &UVSkinning::GetSkinAtlas(path const &folder) {
+	if (!uvSkinAtlases.contains(folder))
+		uvSkinAtlases[folder].Build(GetSkinSet(folder));
+	return uvSkinAtlases[folder];
+}
+
+vector<path> const &UVSkinning::GetSkinSetFiles(path const &folder) {
+	GetSkinSet(folder);
+	return uvSkinSetFiles[folder];
+}
+
 void UVSkinning::GenerateSkinSet(path const &modelPath, path const &folder) {
 	map<string, vector<UVSkinMesh>> textureCollections;
 	Assimp::Importer importer;
@@ -143,6 +479,9 @@ void UVSkinning::GenerateSkinSet(path const &modelPath, path const &folder) {
 			}
 		}
 	}
+	unsigned int width = options().uvSkinSetGenResolutionX;
+	unsigned int height = options().uvSkinSetGenResolutionY;
+	unsigned int numPixels = width * height;
 	for (auto &[texName, texMeshes] : textureCollections) {
 		// for each texture
 		set<string> usedBones;
@@ -152,54 +491,146 @@ void UVSkinning::GenerateSkinSet(path const &modelPath, path const &folder) {
 					usedBones.insert(b);
 			}
 		}
-		// for each used bone in this collection
-		for (auto &boneName : usedBones) {
-			globalVars().renderer->Begin();
-			// for each mesh
-			for (auto &mesh : texMeshes) {
-				vector<Renderer::Vertex> verts(mesh.verts.size());
-				vector<unsigned int> indices(mesh.faces.size() * 3);
-				for (unsigned int f = 0; f < mesh.faces.size(); f++) {
-					indices[f * 3 + 0] = mesh.faces[f].a;
-					indices[f * 3 + 1] = mesh.faces[f].b;
-					indices[f * 3 + 2] = mesh.faces[f].c;
-				}
-				for (unsigned int v = 0; v < mesh.verts.size(); v++) {
-					verts[v].x = (float)options().uvSkinSetGenResolutionX * mesh.verts[v].x;
-					verts[v].y = (float)options().uvSkinSetGenResolutionY * mesh.verts[v].y;
+		if (usedBones.empty())
+			continue;
+		vector<string> boneNames(usedBones.begin(), usedBones.end());
+		map<string, unsigned short> boneSlots;
+		for (unsigned int b = 0; b < boneNames.size(); b++)
+			boneSlots[boneNames[b]] = b;
+		// flatten vertices and triangles of all meshes
+		struct VertexWeight { unsigned short slot; unsigned char value; };
+		struct RasterTri { unsigned int v[3]; };
+		vector<float> vertX, vertY;
+		vector<unsigned int> vertWeightsStart;
+		vector<VertexWeight> vertWeights;
+		vector<RasterTri> tris;
+		for (auto const &mesh : texMeshes) {
+			unsigned int baseVertex = vertX.size();
+			for (auto const &vert : mesh.verts) {
+				vertX.push_back((float)width * vert.x);
+				vertY.push_back((float)height * vert.y);
+				vertWeightsStart.push_back(vertWeights.size());
+				for (auto const &[b, w] : vert.bones)
+					vertWeights.push_back({ boneSlots[b], (unsigned char)clamp<unsigned int>((unsigned int)(w * 255.0f), 0, 255) });
+			}
+			for (auto const &f : mesh.faces)
+				tris.push_back({ { baseVertex + f.a, baseVertex + f.b, baseVertex + f.c } });
+		}
+		vertWeightsStart.push_back(vertWeights.size());
+		// rasterize: last triangle covering a pixel wins, pixel centers are at integer coordinates
+		vector<int> pixelTri(numPixels, -1);
+		vector<float> pixelBary(numPixels * 2);
+		ParallelFor(height, [&](unsigned int rowBegin, unsigned int rowEnd) {
+			for (unsigned int t = 0; t < tris.size(); t++) {
+				float x0 = vertX[tris[t].v[0]], y0 = vertY[tris[t].v[0]];
+				float x1 = vertX[tris[t].v[1]], y1 = vertY[tris[t].v[1]];
+				float x2 = vertX[tris[t].v[2]], y2 = vertY[tris[t].v[2]];
+				float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+				if (area == 0.0f)
+					continue;
+				int minY = max((int)ceil(min({ y0, y1, y2 })), (int)rowBegin);
+				int maxY = min((int)floor(max({ y0, y1, y2 })), (int)rowEnd - 1);
+				int minX = max((int)ceil(min({ x0, x1, x2 })), 0);
+				int maxX = min((int)floor(max({ x0, x1, x2 })), (int)width - 1);
+				float invArea = 1.0f / area;
+				for (int py = minY; py <= maxY; py++) {
+					for (int px = minX; px <= maxX; px++) {
+						float w1 = ((px - x0) * (y2 - y0) - (x2 - x0) * (py - y0)) * invArea;
+						float w2 = ((x1 - x0) * (py - y0) - (px - x0) * (y1 - y0)) * invArea;
+						if (w1 >= 0.0f && w2 >= 0.0f && w1 + w2 <= 1.0f) {
+							unsigned int p = py * width + px;
+							pixelTri[p] = t;
+							pixelBary[p * 2 + 0] = w1;
+							pixelBary[p * 2 + 1] = w2;
+						}
+					}
 				}
-				for (unsigned int v = 0; v < mesh.verts.size(); v++) {
-					if (mesh.verts[v].bones.contains(boneName)) {
-						unsigned char colorValue = clamp<unsigned int>((unsigned int)(mesh.verts[v].bones[boneName] * 255.0f), 0, 255);
-						verts[v].color = D3DCOLOR_RGBA(colorValue, colorValue, colorValue, 255);
+			}
+		});
+		// resolve weights of all bones at once
+		vector<vector<unsigned char>> planes(boneNames.size(), vector<unsigned char>(numPixels, 0));
+		ParallelFor(height, [&](unsigned int rowBegin, unsigned int rowEnd) {
+			vector<float> boneValues(boneNames.size(), 0.0f);
+			vector<unsigned char> boneTouched(boneNames.size(), 0);
+			vector<unsigned short> touched;
+			for (unsigned int p = rowBegin * width; p < rowEnd * width; p++) {
+				if (pixelTri[p] == -1)
+					continue;
+				auto const &tri = tris[pixelTri[p]];
+				float bary[3] = { 1.0f - pixelBary[p * 2 + 0] - pixelBary[p * 2 + 1], pixelBary[p * 2 + 0], pixelBary[p * 2 + 1] };
+				for (unsigned int i = 0; i < 3; i++) {
+					for (unsigned int w = vertWeightsStart[tri.v[i]]; w < vertWeightsStart[tri.v[i] + 1]; w++) {
+						auto const &vw = vertWeights[w];
+						if (!boneTouched[vw.slot]) {
+							boneTouched[vw.slot] = 1;
+							touched.push_back(vw.slot);
+						}
+						boneValues[vw.slot] += bary[i] * (float)vw.value;
 					}
-					else
-						verts[v].color = D3DCOLOR_RGBA(0, 0, 0, 255);
-				} 
-				globalVars().renderer->Device()->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
-				globalVars().renderer->RenderTriangles(indices.size(), indices.data(), verts.data(), verts.size());
-			}
-			// save final texture
-			path folderPath = folder / texName;
-			create_directories(folderPath);
-			path savePath = folderPath / (boneName + ".png");
-			globalVars().renderer->SaveRT(savePath.c_str());
-			globalVars().renderer->End();
-			// inpaint final texture
-			STARTUPINFOW si;
-			PROCESS_INFORMATION pi;
-			ZeroMemory(&si, sizeof(si));
-			si.cb = sizeof(si);
-			ZeroMemory(&pi, sizeof(pi));
-			path inpaintPath = GetOToolsDir() / "tools" / "inpaint.exe";
-			wstring commandLine = inpaintPath.wstring() + L" -i \"" + savePath.c_str() + L"\" -radius 0";
-			WCHAR wargs[2048];
-			wcscpy(wargs, commandLine.c_str());
-			if (CreateProcessW(inpaintPath.c_str(), wargs, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
-				WaitForSingleObject(pi.hProcess, INFINITE);
-				CloseHandle(pi.hProcess);
-				CloseHandle(pi.hThread);
+				}
+				for (auto slot : touched) {
+					planes[slot][p] = (unsigned char)clamp((int)(boneValues[slot] + 0.5f), 0, 255);
+					boneValues[slot] = 0.0f;
+					boneTouched[slot] = 0;
+				}
+				touched.clear();
+			}
+		});
+		// inpaint: fill uncovered pixels ring by ring with the average of already filled neighbours
+		const unsigned int NOT_FILLED = 0xFFFFFFFF;
+		vector<unsigned int> fillRound(numPixels, NOT_FILLED);
+		vector<unsigned int> fillOrder;
+		vector<unsigned int> frontier;
+		for (unsigned int p = 0; p < numPixels; p++) {
+			if (pixelTri[p] != -1) {
+				fillRound[p] = 0;
+				frontier.push_back(p);
+			}
+		}
+		auto ForEachNeighbour = [&](unsigned int p, auto callback) {
+			int px = p % width, py = p / width;
+			for (int ny = max(py - 1, 0); ny <= min(py + 1, (int)height - 1); ny++) {
+				for (int nx = max(px - 1, 0); nx <= min(px + 1, (int)width - 1); nx++) {
+					if (nx != px || ny != py)
+						callback(ny * width + nx);
+				}
+			}
+		};
+		if (!frontier.empty()) {
+			for (unsigned int round = 1; !frontier.empty(); round++) {
+				vector<unsigned int> next;
+				for (auto p : frontier) {
+					ForEachNeighbour(p, [&](unsigned int n) {
+						if (fillRound[n] == NOT_FILLED) {
+							fillRound[n] = round;
+							next.push_back(n);
+						}
+					});
+				}
+				fillOrder.insert(fillOrder.end(), next.begin(), next.end());
+				frontier.swap(next);
 			}
 		}
+		path folderPath = folder / texName;
+		create_directories(folderPath);
+		ParallelFor(boneNames.size(), [&](unsigned int boneBegin, unsigned int boneEnd) {
+			for (unsigned int b = boneBegin; b < boneEnd; b++) {
+				auto &plane = planes[b];
+				for (auto p : fillOrder) {
+					unsigned int sum = 0, count = 0;
+					ForEachNeighbour(p, [&](unsigned int n) {
+						if (fillRound[n] < fillRound[p]) {
+							sum += plane[n];
+							count++;
+						}
+					});
+					plane[p] = (unsigned char)((sum + count / 2) / count);
+				}
+				// save final texture
+				path savePath = folderPath / (boneNames[b] + ".png");
+				if (!WritePngGray8(savePath, width, height, plane.data()))
+					throw runtime_error("UVSkinning: Unable to write " + savePath.string());
+			}
+		});
 	}
 }
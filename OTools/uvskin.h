@@ -34,17 +34,61 @@ public:
 	struct UVSkinTexMap {
 		unsigned int width = 0;
 		unsigned int height = 0;
-		vector<unsigned char> pixels;
+		vector<unsigned char> pixels; // decoded from the image file
+		unsigned char const *mappedPixels = nullptr; // points into a mapped cache file
 
+		unsigned char const *Pixels() const;
 		float GetWeight(float u, float v) const;
 	};
 
 	using UVSkinSet = map<string, UVSkinTexMap>;
 	map<path, UVSkinSet> uvSkinSets;
 
+	static const unsigned int ATLAS_BONES_PER_TEXEL = 4;
+	static const unsigned int MAX_SAMPLE_BONES = ATLAS_BONES_PER_TEXEL * 4;
+	static const unsigned short ATLAS_NO_BONE = 0xFFFF;
+
+	struct UVSkinSample {
+		unsigned int numBones = 0;
+		unsigned short bones[MAX_SAMPLE_BONES];
+		float weights[MAX_SAMPLE_BONES];
+	};
+
+	// all weight maps of a set packed into one image: strongest bones per texel
+	struct UVSkinAtlas {
+		unsigned int width = 0;
+		unsigned int height = 0;
+		vector<string> boneNames; // atlas bone slot > weight map name
+		vector<unsigned short> texelBones; // ATLAS_BONES_PER_TEXEL per texel
+		vector<unsigned char> texelWeights; // ATLAS_BONES_PER_TEXEL per texel
+
+		void Build(UVSkinSet const &skinSet);
+		void Sample(float u, float v, UVSkinSample &out) const;
+	};
+
+	map<path, UVSkinAtlas> uvSkinAtlases;
+
+	struct MappedCacheFile {
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+		unsigned char const *view = nullptr;
+		unsigned long long size = 0;
+	};
+
+	vector<MappedCacheFile> mappedCacheFiles;
+	map<path, vector<path>> uvSkinSetFiles; // images of each loaded set
+
+	~UVSkinning();
+
 	static UVSkinning &Instance();
 
+	static path GetSkinSetCachePath(path const &folder);
+	bool LoadSkinSetCache(path const &folder, vector<path> const &files, UVSkinSet &skinSet);
+	void SaveSkinSetCache(path const &folder, vector<path> const &files, UVSkinSet const &skinSet);
+
 	UVSkinSet const &GetSkinSet(path const &folder);
+	UVSkinAtlas const &GetSkinAtlas(path const &folder);
+	vector<path> const &GetSkinSetFiles(path const &folder);
 
 	void GenerateSkinSet(path const &modelPath, path const &folder);
 };
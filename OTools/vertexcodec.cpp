@@ -0,0 +1,188 @@
+#include "vertexcodec.h"
+#include "memory.h"
+#include <map>
+#include <mutex>
+#include <utility>
+#include <cfloat>
+
+using namespace std;
+
+namespace {
+
+template<bool Scale, bool Translate, bool SwapYZ>
+void EncodePositionsT(unsigned char *dst, unsigned int stride, aiVector3D const *src, vector<unsigned int> const &sourceVertices,
+    PositionTransform const &transform, Bounds &bounds)
+{
+    if (sourceVertices.empty())
+        return;
+    aiVector3D const scale = transform.scaleValue;
+    aiVector3D const translate = transform.translateValue;
+    unsigned char *first = dst;
+    // the box is accumulated while encoding, without branches
+    aiVector3D lo(FLT_MAX, FLT_MAX, FLT_MAX);
+    aiVector3D hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (auto v : sourceVertices) {
+        aiVector3D pos = src[v];
+        if constexpr (Scale) {
+            pos.x *= scale.x;
+            pos.y *= scale.y;
+            pos.z *= scale.z;
+        }
+        if constexpr (Translate) {
+            pos.x += translate.x;
+            pos.y += translate.y;
+            pos.z += translate.z;
+        }
+        if constexpr (SwapYZ)
+            swap(pos.y, pos.z);
+        Memory_Copy(dst, &pos, 12);
+        dst += stride;
+        lo.x = min(lo.x, pos.x);
+        lo.y = min(lo.y, pos.y);
+        lo.z = min(lo.z, pos.z);
+        hi.x = max(hi.x, pos.x);
+        hi.y = max(hi.y, pos.y);
+        hi.z = max(hi.z, pos.z);
+    }
+    bounds.AddPoints(first, stride, unsigned int(sourceVertices.size()), lo, hi);
+}
+
+template<bool SwapYZ, bool Flip>
+void EncodeNormalsT(unsigned char *dst, unsigned int stride, aiVector3D const *src, vector<unsigned int> const &sourceVertices) {
+    for (auto v : sourceVertices) {
+        aiVector3D normal = src[v];
+        if constexpr (SwapYZ)
+            swap(normal.y, normal.z);
+        if constexpr (Flip) {
+            normal.x = -normal.x;
+            normal.y = -normal.y;
+            normal.z = -normal.z;
+        }
+        Memory_Copy(dst, &normal, 12);
+        dst += stride;
+    }
+}
+
+}
+
+VertexLayout const &GetVertexLayout(Shader const &shader) {
+    static map<vector<pair<Shader::DataUsage, Shader::DataType>>, VertexLayout> layouts;
+    static mutex layoutsMutex;
+    vector<pair<Shader::DataUsage, Shader::DataType>> key;
+    key.reserve(shader.declaration.size());
+    for (auto const &d : shader.declaration)
+        key.emplace_back(d.usage, d.type);
+    lock_guard<mutex> lock(layoutsMutex);
+    auto it = layouts.find(key);
+    if (it != layouts.end())
+        return (*it).second;
+    VertexLayout &layout = layouts[key];
+    unsigned int offset = 0;
+    for (auto const &d : shader.declaration) {
+        VertexLayout::Element e;
+        e.usage = d.usage;
+        e.offset = offset;
+        switch (d.usage) {
+        case Shader::Position:
+            if (d.type == Shader::Float3)
+                e.attribute = VertexLayout::Position;
+            break;
+        case Shader::Normal:
+            if (d.type == Shader::Float3)
+                e.attribute = VertexLayout::Normal;
+            break;
+        case Shader::Color0:
+            if (d.type == Shader::D3DColor || d.type == Shader::UByte4)
+                e.attribute = VertexLayout::Color;
+            break;
+        case Shader::Color1:
+            e.attribute = VertexLayout::SkinIndex;
+            break;
+        case Shader::Texcoord0:
+        case Shader::Texcoord1:
+        case Shader::Texcoord2:
+            if (d.type == Shader::Float2) {
+                e.attribute = VertexLayout::Texcoord;
+                e.channel = d.usage - Shader::Texcoord0;
+            }
+            break;
+        }
+        if (e.attribute != VertexLayout::Skip)
+            layout.elements.push_back(e);
+        offset += d.Size();
+    }
+    layout.vertexSize = offset;
+    return layout;
+}
+
+void EncodePositions(unsigned char *dst, unsigned int stride, aiVector3D const *src, vector<unsigned int> const &sourceVertices,
+    PositionTransform const &transform, Bounds &bounds)
+{
+    using Encoder = void(*)(unsigned char *, unsigned int, aiVector3D const *, vector<unsigned int> const &, PositionTransform const &, Bounds &);
+    static Encoder const encoders[8] = {
+        EncodePositionsT<false, false, false>, EncodePositionsT<false, false, true>,
+        EncodePositionsT<false, true, false>, EncodePositionsT<false, true, true>,
+        EncodePositionsT<true, false, false>, EncodePositionsT<true, false, true>,
+        EncodePositionsT<true, true, false>, EncodePositionsT<true, true, true>
+    };
+    encoders[(transform.scale ? 4 : 0) | (transform.translate ? 2 : 0) | (transform.swapYZ ? 1 : 0)](dst, stride, src, sourceVertices, transform, bounds);
+}
+
+void EncodeNormals(unsigned char *dst, unsigned int stride, aiVector3D const *src, vector<unsigned int> const &sourceVertices, bool swapYZ, bool flip) {
+    if (swapYZ) {
+        if (flip)
+            EncodeNormalsT<true, true>(dst, stride, src, sourceVertices);
+        else
+            EncodeNormalsT<true, false>(dst, stride, src, sourceVertices);
+    }
+    else {
+        if (flip)
+            EncodeNormalsT<false, true>(dst, stride, src, sourceVertices);
+        else
+            EncodeNormalsT<false, false>(dst, stride, src, sourceVertices);
+    }
+}
+
+void EncodeTexcoords(unsigned char *dst, unsigned int stride, aiVector3D const *src, vector<unsigned int> const &sourceVertices) {
+    for (auto v : sourceVertices) {
+        Memory_Copy(dst, &src[v], 8);
+        dst += stride;
+    }
+}
+
+void EncodeUInt32(unsigned char *dst, unsigned int stride, unsigned int const *src, unsigned int numVertices) {
+    for (unsigned int i = 0; i < numVertices; i++) {
+        Memory_Copy(dst, &src[i], 4);
+        dst += stride;
+    }
+}
+
+void DecodeFlipVectors(unsigned char *data, unsigned int stride, unsigned int numVertices) {
+    for (unsigned int i = 0; i < numVertices; i++) {
+        float *vec = (float *)data;
+        vec[0] = -vec[0];
+        vec[1] = -vec[1];
+        vec[2] = -vec[2];
+        data += stride;
+    }
+}
+
+void DecodeSwapRB(unsigned char *data, unsigned int stride, unsigned int numVertices) {
+    for (unsigned int i = 0; i < numVertices; i++) {
+        swap(data[0], data[2]);
+        data += stride;
+    }
+}
+
+void DecodeOffsetTexcoords(unsigned char *data, unsigned int stride, unsigned int numVertices, float scale, float offsetU, float offsetV) {
+    for (unsigned int i = 0; i < numVertices; i++) {
+        float *uv = (float *)data;
+        uv[0] *= scale;
+        uv[1] *= scale;
+        if (offsetU != 0.0f)
+            uv[0] += offsetU;
+        if (offsetV != 0.0f)
+            uv[1] += offsetV;
+        data += stride;
+    }
+}
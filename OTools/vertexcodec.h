@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <assimp/vector3.h>
+#include "shaders.h"
+#include "bounds.h"
+
+// Vertex layout compiled once per distinct shader declaration. Encoders and decoders walk one attribute at a time
+// over all vertices (strided), so the attribute type and the option flags are resolved outside the vertex loop.
+struct VertexLayout {
+    enum Attribute {
+        Skip, Position, Normal, Color, SkinIndex, Texcoord
+    };
+
+    struct Element {
+        Attribute attribute = Skip;
+        Shader::DataUsage usage = Shader::NoUsage;
+        unsigned int channel = 0; // texcoord channel
+        unsigned int offset = 0;
+    };
+
+    std::vector<Element> elements; // only elements with data, in declaration order
+    unsigned int vertexSize = 0;
+};
+
+VertexLayout const &GetVertexLayout(Shader const &shader);
+
+struct PositionTransform {
+    bool scale = false;
+    bool translate = false;
+    bool swapYZ = false;
+    aiVector3D scaleValue = { 1.0f, 1.0f, 1.0f };
+    aiVector3D translateValue = { 0.0f, 0.0f, 0.0f };
+};
+
+// encoders: vertex i of the buffer gets src[sourceVertices[i]]
+// the encoded positions are added to 'bounds' in the same pass
+void EncodePositions(unsigned char *dst, unsigned int stride, aiVector3D const *src, std::vector<unsigned int> const &sourceVertices,
+    PositionTransform const &transform, Bounds &bounds);
+void EncodeNormals(unsigned char *dst, unsigned int stride, aiVector3D const *src, std::vector<unsigned int> const &sourceVertices,
+    bool swapYZ, bool flip);
+void EncodeTexcoords(unsigned char *dst, unsigned int stride, aiVector3D const *src, std::vector<unsigned int> const &sourceVertices);
+// vertex i of the buffer gets src[i]
+void EncodeUInt32(unsigned char *dst, unsigned int stride, unsigned int const *src, unsigned int numVertices);
+
+// decoders, in place
+void DecodeFlipVectors(unsigned char *data, unsigned int stride, unsigned int numVertices);
+void DecodeSwapRB(unsigned char *data, unsigned int stride, unsigned int numVertices);
+void DecodeOffsetTexcoords(unsigned char *data, unsigned int stride, unsigned int numVertices, float scale, float offsetU, float offsetV);
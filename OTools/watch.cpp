@@ -0,0 +1,151 @@
+#include "WinInclude.h"
+#include "watch.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+
+const unsigned int POLL_INTERVAL_MS = 500;
+
+bool IsInside(path const &p, path const &folder) {
+    auto relative = p.lexically_relative(folder);
+    return !relative.empty() && *relative.begin() != "..";
+}
+
+}
+
+map<path, FolderWatcher::FileState> FolderWatcher::ScanFolder(path const &folder, bool recursive) {
+    map<path, FileState> result;
+    error_code ec;
+    auto AddFile = [&](directory_entry const &entry) {
+        if (entry.is_regular_file(ec)) {
+            auto &state = result[entry.path()];
+            state.size = entry.file_size(ec);
+            state.time = entry.last_write_time(ec).time_since_epoch().count();
+        }
+    };
+    if (recursive) {
+        for (auto const &entry : recursive_directory_iterator(folder, directory_options::skip_permission_denied, ec))
+            AddFile(entry);
+    }
+    else {
+        for (auto const &entry : directory_iterator(folder, directory_options::skip_permission_denied, ec))
+            AddFile(entry);
+    }
+    return result;
+}
+
+void FolderWatcher::Close(Folder &folder) {
+    if (folder.handle) {
+        FindCloseChangeNotification(folder.handle);
+        folder.handle = nullptr;
+    }
+}
+
+FolderWatcher::~FolderWatcher() {
+    for (auto &f : mFolders)
+        Close(f);
+}
+
+void FolderWatcher::SetFolders(path const &folder, bool recursive, vector<path> const &extraFolders) {
+    vector<pair<path, bool>> wanted;
+    error_code ec;
+    path mainFolder = weakly_canonical(absolute(folder), ec);
+    wanted.emplace_back(mainFolder, recursive);
+    for (auto const &extra : extraFolders) {
+        path p = weakly_canonical(absolute(extra), ec);
+        if (p.empty() || !is_directory(p, ec) || p == mainFolder || (recursive && IsInside(p, mainFolder)))
+            continue;
+        if (find(wanted.begin(), wanted.end(), make_pair(p, false)) == wanted.end())
+            wanted.emplace_back(p, false);
+    }
+    vector<Folder> folders;
+    for (auto const &[p, r] : wanted) {
+        auto it = find_if(mFolders.begin(), mFolders.end(), [&](Folder const &f) { return f.path == p && f.recursive == r; });
+        if (it != mFolders.end()) {
+            folders.push_back(move(*it));
+            (*it).handle = nullptr;
+            continue;
+        }
+        Folder f;
+        f.path = p;
+        f.recursive = r;
+        // WaitForMultipleObjects() is limited to MAXIMUM_WAIT_OBJECTS handles, the other folders are polled
+        if (folders.size() < MAXIMUM_WAIT_OBJECTS) {
+            HANDLE handle = FindFirstChangeNotificationW(p.c_str(), r, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME
+                | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+            if (handle != INVALID_HANDLE_VALUE)
+                f.handle = handle;
+        }
+        if (!f.handle)
+            f.state = ScanFolder(p, r);
+        folders.push_back(move(f));
+    }
+    for (auto &f : mFolders)
+        Close(f);
+    mFolders = move(folders);
+}
+
+bool FolderWatcher::CheckChanges(unsigned int timeoutMs) {
+    vector<HANDLE> handles;
+    bool hasPolled = false;
+    for (auto const &f : mFolders) {
+        if (f.handle && handles.size() < MAXIMUM_WAIT_OBJECTS)
+            handles.push_back(f.handle);
+        else
+            hasPolled = true;
+    }
+    auto start = chrono::steady_clock::now();
+    while (true) {
+        unsigned int elapsed = unsigned int(chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count());
+        unsigned int remaining = timeoutMs == INFINITE ? INFINITE : (elapsed < timeoutMs ? timeoutMs - elapsed : 0);
+        unsigned int waitMs = hasPolled ? min(remaining, POLL_INTERVAL_MS) : remaining;
+        bool changed = false;
+        if (!handles.empty()) {
+            DWORD result = WaitForMultipleObjects(DWORD(handles.size()), handles.data(), FALSE, waitMs);
+            if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + handles.size()) {
+                changed = true;
+                // re-arm every signaled handle, changes made from now on signal it again
+                for (auto h : handles) {
+                    if (WaitForSingleObject(h, 0) == WAIT_OBJECT_0)
+                        FindNextChangeNotification(h);
+                }
+            }
+            else if (result == WAIT_FAILED) {
+                // the notifications stopped working (e.g. the folder was removed), switch to polling
+                for (auto &f : mFolders) {
+                    if (f.handle) {
+                        Close(f);
+                        f.state = ScanFolder(f.path, f.recursive);
+                    }
+                }
+                return true;
+            }
+        }
+        else
+            Sleep(waitMs);
+        for (auto &f : mFolders) {
+            if (!f.handle) {
+                auto newState = ScanFolder(f.path, f.recursive);
+                if (newState != f.state) {
+                    f.state = move(newState);
+                    changed = true;
+                }
+            }
+        }
+        if (changed)
+            return true;
+        if (remaining != INFINITE && waitMs >= remaining)
+            return false;
+    }
+}
+
+void FolderWatcher::Wait(unsigned int debounceMs) {
+    CheckChanges(INFINITE);
+    // every further change restarts the debounce time
+    while (CheckChanges(max(debounceMs, 1u)))
+        ;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+#include <map>
+
+// Watches folders for changes (file added, removed, renamed or written). The notification handles stay open between waits,
+// so a file saved while a pass is converting is reported by the next Wait(). Folders without change notifications (e.g. some
+// network shares, or more folders than the system can wait on) are polled by comparing file times.
+class FolderWatcher {
+    struct FileState {
+        unsigned long long size = 0;
+        long long time = 0;
+
+        bool operator==(FileState const &other) const {
+            return size == other.size && time == other.time;
+        }
+    };
+
+    struct Folder {
+        std::filesystem::path path;
+        bool recursive = false;
+        void *handle = nullptr; // null when the folder is polled
+        std::map<std::filesystem::path, FileState> state; // polled folders only
+    };
+
+    std::vector<Folder> mFolders;
+
+    static std::map<std::filesystem::path, FileState> ScanFolder(std::filesystem::path const &folder, bool recursive);
+    void Close(Folder &folder);
+    // true when something changed within timeoutMs
+    bool CheckChanges(unsigned int timeoutMs);
+public:
+    FolderWatcher() = default;
+    FolderWatcher(FolderWatcher const &) = delete;
+    FolderWatcher &operator=(FolderWatcher const &) = delete;
+    ~FolderWatcher();
+
+    // 'folder' is watched with 'recursive', 'extraFolders' (e.g. folders of textures and skeletons recorded in the manifest)
+    // without it; folders which are already watched keep their handles
+    void SetFolders(std::filesystem::path const &folder, bool recursive, std::vector<std::filesystem::path> const &extraFolders);
+    // blocks until something changes and no further changes arrive for debounceMs, so a burst of saves from an editor
+    // results in a single return
+    void Wait(unsigned int debounceMs);
+};